@@ -77,6 +77,7 @@ Observer::Observer(Motor* lm, Motor* rm, Motor* am, Motor* tm, TouchSensor* ts,
     fir_r = new FIR_Transposed<FIR_ORDER>(hn);
     fir_g = new FIR_Transposed<FIR_ORDER>(hn);
     fir_b = new FIR_Transposed<FIR_ORDER>(hn);
+    fir_priming = true;
     ma = new MovingAverage<int32_t, MA_CAP>();
 }
 
@@ -93,6 +94,7 @@ void Observer::reset() {
     prevAngL = leftMotor->getCount();
     prevAngR = rightMotor->getCount();
     integD = integDL = integDR = 0.0; // temp
+    fir_priming = true; // start filtering from the current color without waiting the FIRs to fill
 }
 
 void Observer::notifyOfDistance(int32_t delta) {
@@ -129,9 +131,16 @@ int32_t Observer::getLocY() {
 void Observer::operate() {
     colorSensor->getRawColor(cur_rgb);
     // process RGB by the Low Pass Filter
-    cur_rgb.r = fir_r->Execute(cur_rgb.r);
-    cur_rgb.g = fir_g->Execute(cur_rgb.g);
-    cur_rgb.b = fir_b->Execute(cur_rgb.b);
+    if (fir_priming) {
+        cur_rgb.r = fir_r->Prime(cur_rgb.r);
+        cur_rgb.g = fir_g->Prime(cur_rgb.g);
+        cur_rgb.b = fir_b->Prime(cur_rgb.b);
+        fir_priming = false;
+    } else {
+        cur_rgb.r = fir_r->Execute(cur_rgb.r);
+        cur_rgb.g = fir_g->Execute(cur_rgb.g);
+        cur_rgb.b = fir_b->Execute(cur_rgb.b);
+    }
     curRgbSum = cur_rgb.r + cur_rgb.g + cur_rgb.b;
     rgb_to_hsv(cur_rgb, cur_hsv);
     // save filtered color variables to the global area
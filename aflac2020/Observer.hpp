@@ -47,6 +47,7 @@ private:
     rgb_raw_t cur_rgb;
     hsv_raw_t cur_hsv;
     FIR_Transposed<FIR_ORDER> *fir_r, *fir_g, *fir_b;
+    bool fir_priming; // prime the FIRs by the next color instead of filtering it
     MovingAverage<int32_t, MA_CAP> *ma;
     //OutlierTester*  ot_r;
     //OutlierTester*  ot_g;
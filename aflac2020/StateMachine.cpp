@@ -66,13 +66,8 @@ void StateMachine::sendTrigger(uint8_t event) {
                     //ev3_led_set_color(LED_GREEN); /* スタート通知 */
                     lineTracer->activate();
                     
-                    observer->freeze();
-                    lineTracer->freeze();
+                    // the FIRs of the observer get primed by the color on reset, no need to wait them to fill
                     lineTracer->haveControl();
-                    //clock->sleep() seems to be still taking milisec parm
-                    clock->sleep(PERIOD_NAV_TSK*FIR_ORDER/1000); // wait until FIR array is filled
-                    lineTracer->unfreeze();
-                    observer->unfreeze();
                     syslog(LOG_NOTICE, "%08u, Departed", clock->now());
                     observer->notifyOfDistance(DIST_force_blind); // switch to ST_Blind forcefully after DIST_force_blind reached
                     break;
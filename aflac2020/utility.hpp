@@ -78,6 +78,7 @@ private:
 public:
     FIR_Direct(const double hk[]);
     inline double Execute(const double xin);
+    double Prime(const double xin);
 };
 
 template<int ORDER>
@@ -94,6 +95,17 @@ inline double FIR_Direct<ORDER>::Execute(const double xin) {
     return acc;
 }
 
+// fill the delay line as if the input had stayed at xin, and return the output then
+template<int ORDER>
+double FIR_Direct<ORDER>::Prime(const double xin) {
+    double acc = 0.0;
+    for (int i = 0; i <= ORDER; i++) {
+        un[i] = xin;
+        acc = acc + hm[i] * xin;
+    }
+    return acc;
+}
+
 template<int ORDER> class FIR_Transposed {
 private:
     const double *const hm;
@@ -101,6 +113,7 @@ private:
 public:
     FIR_Transposed(const double hk[]);
     inline double Execute(const double xin);
+    double Prime(const double xin);
 };
 
 template<int ORDER>
@@ -115,6 +128,17 @@ inline double FIR_Transposed<ORDER>::Execute(const double xin) {
     return un[0];
 }
 
+// fill the delay line as if the input had stayed at xin, and return the output then
+template<int ORDER>
+double FIR_Transposed<ORDER>::Prime(const double xin) {
+    double acc = 0.0;
+    for (int i = ORDER; i >= 0; i--) {
+        acc = acc + hm[i] * xin;
+        un[i] = acc;
+    }
+    return acc;
+}
+
 void rgb_to_hsv(rgb_raw_t rgb, hsv_raw_t& hsv);
 
 class PIDcalculator {
@@ -0,0 +1,50 @@
+/*
+    aflac2020.cpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#include "bench.hpp"
+
+#include "app.h"
+#include "aflac_common.hpp"
+#include "utility.hpp"
+
+using ev3host::Benchmark;
+using ev3host::doNotOptimize;
+using ev3host::inputs;
+using ev3host::inputSize;
+
+const char* const ev3host::benchSuite = "aflac2020";
+
+/* referred to by DataLogger in utility.cpp, defined in app.cpp of the app */
+Clock* clock;
+
+namespace {
+
+/* the colors across the edge of the line, from white to black through the blue */
+void rgbToHsv(long iterations) {
+    hsv_raw_t hsv;
+    for (long i = 0; i < iterations; i++) {
+        double x = inputs[i % inputSize];
+        rgb_raw_t rgb;
+        rgb.r = (uint16_t)(60.0 + 50.0 * x);
+        rgb.g = (uint16_t)(65.0 + 50.0 * x);
+        rgb.b = (uint16_t)(80.0 + 40.0 * x);
+        rgb_to_hsv(rgb, hsv);
+        doNotOptimize(hsv);
+    }
+}
+
+/* the outlier test of a color channel as in Observer, in the steady state past its initial samples */
+void outlierTest(long iterations) {
+    /* never destroyed as OutlierTester has no destructor defined */
+    static OutlierTester* tester = new OutlierTester(0, 100);
+    for (long i = 0; i < iterations; i++) {
+        doNotOptimize(tester->test(inputs[i % inputSize]));
+    }
+}
+
+Benchmark b1("rgb_to_hsv", rgbToHsv);
+Benchmark b2("OutlierTester::test", outlierTest);
+
+} // namespace
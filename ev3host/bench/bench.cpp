@@ -0,0 +1,196 @@
+/*
+    bench.cpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#include "bench.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sched.h>
+#include <string>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+/*
+    bench measures the code of an app run on every tick in nanosecond per call.
+    Each benchmark is run for as many iterations as to last the minimum time in a trial,
+    after a warm-up trial of the same, and the statistics over the trials are reported:
+    the median as the figure to compare, with the minimum, the maximum
+    and the median absolute deviation to tell how stable the figure is.
+    usage: bench_<app> [-f csv|json] [-n trials] [-m msec] [-c cpu] [name...]
+*/
+namespace ev3host {
+
+double inputs[inputSize];
+
+namespace {
+
+struct Entry {
+    const char* name;
+    BenchFunction function;
+};
+
+struct Result {
+    const char* name;
+    long iterations;
+    double median, min, max, mad;   /* in nanosecond per iteration */
+};
+
+std::vector<Entry>& registry() {
+    static std::vector<Entry> entries;
+    return entries;
+}
+
+/* the architecture and the compiler the suite is built for */
+const char* architecture() {
+#if defined(__aarch64__)
+    return "aarch64";
+#elif defined(__arm__)
+    return "arm";
+#elif defined(__x86_64__)
+    return "x86_64";
+#elif defined(__i386__)
+    return "i386";
+#else
+    return "unknown";
+#endif
+}
+
+double nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+double timeNs(BenchFunction function, long iterations) {
+    double start = nowNs();
+    function(iterations);
+    return nowNs() - start;
+}
+
+double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    return (n % 2) ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2.0;
+}
+
+Result measure(const Entry& entry, int trials, double minNs) {
+    Result result;
+    result.name = entry.name;
+    /* double the iterations until a trial lasts a tenth of the minimum time, then scale up to it */
+    long iterations = 1;
+    double elapsed;
+    while ((elapsed = timeNs(entry.function, iterations)) < minNs / 10.0 && iterations < (1L << 40)) {
+        iterations *= 2;
+    }
+    if (elapsed < minNs) {
+        iterations = (long)ceil(iterations * minNs / std::max(elapsed, 1.0));
+    }
+    result.iterations = iterations;
+    timeNs(entry.function, iterations); /* warm-up */
+    std::vector<double> perOp;
+    for (int i = 0; i < trials; i++) {
+        perOp.push_back(timeNs(entry.function, iterations) / iterations);
+    }
+    result.median = median(perOp);
+    result.min = *std::min_element(perOp.begin(), perOp.end());
+    result.max = *std::max_element(perOp.begin(), perOp.end());
+    std::vector<double> deviations;
+    for (double v : perOp) deviations.push_back(fabs(v - result.median));
+    result.mad = median(deviations);
+    return result;
+}
+
+void printCsv(const std::vector<Result>& results, int trials) {
+    printf("SUITE,ARCH,BENCHMARK,ITERATIONS,TRIALS,MEDIAN_NS,MIN_NS,MAX_NS,MAD_NS\n");
+    for (const Result& r : results) {
+        printf("%s,%s,%s,%ld,%d,%.3f,%.3f,%.3f,%.3f\n", benchSuite, architecture(), r.name,
+            r.iterations, trials, r.median, r.min, r.max, r.mad);
+    }
+}
+
+void printJson(const std::vector<Result>& results, int trials) {
+    printf("{\n  \"suite\": \"%s\",\n  \"arch\": \"%s\",\n  \"compiler\": \"%s\",\n  \"benchmarks\": [",
+        benchSuite, architecture(), __VERSION__);
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        printf("%s\n    { \"name\": \"%s\", \"iterations\": %ld, \"trials\": %d, "
+            "\"median_ns\": %.3f, \"min_ns\": %.3f, \"max_ns\": %.3f, \"mad_ns\": %.3f }",
+            (i == 0) ? "" : ",", r.name, r.iterations, trials, r.median, r.min, r.max, r.mad);
+    }
+    printf("\n  ]\n}\n");
+}
+
+void usage() {
+    fprintf(stderr,
+        "usage: bench_%s [-f csv|json] [-n trials] [-m msec] [-c cpu] [name...]\n"
+        "  -f format   csv (default) or json\n"
+        "  -n trials   trials per benchmark (default 15)\n"
+        "  -m msec     minimum time of a trial in millisecond (default 20)\n"
+        "  -c cpu      pin the process to the cpu to keep it from migrating\n"
+        "  name        run only the benchmarks whose name contains any of the names\n",
+        benchSuite);
+    exit(2);
+}
+
+} // namespace
+
+Benchmark::Benchmark(const char* name, BenchFunction function) {
+    registry().push_back(Entry{ name, function });
+}
+
+} // namespace ev3host
+
+int main(int argc, char* argv[]) {
+    using namespace ev3host;
+    std::string format = "csv";
+    int trials = 15, cpu = -1, opt;
+    double minMs = 20.0;
+    while ((opt = getopt(argc, argv, "f:n:m:c:")) != -1) {
+        switch (opt) {
+        case 'f': format = optarg; break;
+        case 'n': trials = atoi(optarg); break;
+        case 'm': minMs = atof(optarg); break;
+        case 'c': cpu = atoi(optarg); break;
+        default: usage();
+        }
+    }
+    if ((format != "csv" && format != "json") || trials < 1 || minMs <= 0.0) usage();
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            perror("sched_setaffinity");
+            return 2;
+        }
+    }
+
+    /* a fixed seed, so that every run and every build measures the same input */
+    unsigned int seed = 1;
+    for (int i = 0; i < inputSize; i++) {
+        seed = seed * 1103515245u + 12345u;
+        double noise = ((seed >> 16) & 0x7fff) / 32768.0 - 0.5;
+        inputs[i] = sin(2.0 * M_PI * i / inputSize) * 0.9 + noise * 0.2;
+    }
+
+    std::vector<Result> results;
+    for (const Entry& entry : registry()) {
+        bool selected = (optind >= argc);
+        for (int i = optind; i < argc && !selected; i++) {
+            selected = (strstr(entry.name, argv[i]) != nullptr);
+        }
+        if (selected) results.push_back(measure(entry, trials, minMs * 1e6));
+    }
+    if (format == "json") {
+        printJson(results, trials);
+    } else {
+        printCsv(results, trials);
+    }
+    return 0;
+}
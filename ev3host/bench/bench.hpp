@@ -0,0 +1,42 @@
+/*
+    bench.hpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#ifndef bench_hpp
+#define bench_hpp
+
+namespace ev3host {
+
+/* the code under measurement, to run the given times in a row */
+typedef void (*BenchFunction)(long iterations);
+
+/*
+    Benchmark registers the function under the name on construction,
+    hence it is to be defined at namespace scope of a suite, e.g.
+        ev3host::Benchmark fir("FIR_Transposed::apply", firTransposed);
+    The state of the code under measurement is to be kept across the calls of the function
+    so that setting it up is not measured and the code runs in the steady state as on every tick.
+*/
+class Benchmark {
+public:
+    Benchmark(const char* name, BenchFunction function);
+};
+
+/* name of the suite, i.e. the app, to be defined by the suite */
+extern const char* const benchSuite;
+
+/* input of the code under measurement, a period of a noisy sine of amplitude 1,
+   to be read as inputs[i % inputSize] so that the compiler cannot fold the code */
+const int inputSize = 1024;
+extern double inputs[inputSize];
+
+/* keep the value from being optimized away */
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+} // namespace ev3host
+
+#endif /* bench_hpp */
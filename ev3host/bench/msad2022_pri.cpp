@@ -0,0 +1,403 @@
+/*
+    msad2022_pri.cpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#include "bench.hpp"
+
+#include <cassert>
+#include "app.h"
+#include "Motor.h"
+#include "GyroSensor.h"
+#include "BrainTree.h"
+#include "FIR.hpp"
+#include "Biquad.hpp"
+#include "FilterChain.hpp"
+#include "RollingMedian.hpp"
+#include "FilteredColorSensor.hpp"
+#include "FilteredMotor.hpp"
+#include "SRLF.hpp"
+#include "SCurve.hpp"
+#include "MovingAverage.hpp"
+#include "PIDcalculator.hpp"
+#include "PIDController.hpp"
+#include "GainSchedule.hpp"
+#include "Plotter.hpp"
+
+using ev3host::Benchmark;
+using ev3host::doNotOptimize;
+using ev3host::inputs;
+using ev3host::inputSize;
+
+const char* const ev3host::benchSuite = "msad2022_pri";
+
+namespace {
+
+/* the low pass filter of the color sensor as in main_task, and as before by the runtime order */
+const int FIR_ORDER = 4;
+const double* const hn = FIR_LowPass02::h;
+
+void firFixed(long iterations) {
+    static FIR<FIR_ORDER, FIR_LowPass02> fir;
+    for (long i = 0; i < iterations; i++) {
+        doNotOptimize(fir.apply(inputs[i % inputSize]));
+    }
+}
+
+/* the fixed point variants by -DFIXED_POINT, to be compared on EV3 by CROSS_COMPILE where double is soft-float */
+void firFixedQ15(long iterations) {
+    static FIR_Q15<FIR_ORDER, FIR_LowPass02> fir;
+    for (long i = 0; i < iterations; i++) {
+        doNotOptimize(fir.apply(inputs[i % inputSize]));
+    }
+}
+
+/* a sample of R, G and B through the filters per channel as before,
+   and of R, G, B and brightness through the bank of them, which costs the same for the fourth lane */
+void rgbFilters(long iterations) {
+    static Filter* fil[3] = { new FIR<FIR_ORDER, FIR_LowPass02>, new FIR<FIR_ORDER, FIR_LowPass02>, new FIR<FIR_ORDER, FIR_LowPass02> };
+    for (long i = 0; i < iterations; i++) {
+        double x = inputs[i % inputSize];
+        doNotOptimize(fil[0]->apply(x));
+        doNotOptimize(fil[1]->apply(x + 5.0));
+        doNotOptimize(fil[2]->apply(x + 20.0));
+    }
+}
+
+void rgbFilterBank(long iterations) {
+    static FilterBank* bank = new FIRBank<FIR_ORDER, FIR_LowPass02>;
+    FilterLanes y;
+    for (long i = 0; i < iterations; i++) {
+        double x = inputs[i % inputSize];
+        bank->apply(x, x + 5.0, x + 20.0, x + 8.0, y);
+        doNotOptimize(y);
+    }
+}
+
+/* a tick of the color sensor as in update_task */
+void colorSense(FilteredColorSensor* sensor, long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        sensor->sense();
+        rgb_raw_t rgb;
+        sensor->getRawColor(rgb);
+        doNotOptimize(rgb);
+    }
+}
+
+void colorSenseFilters(long iterations) {
+    static FilteredColorSensor* sensor = nullptr;
+    if (sensor == nullptr) {
+        sensor = new FilteredColorSensor(PORT_2);
+        sensor->setRawColorFilters(new FIR<FIR_ORDER, FIR_LowPass02>, new FIR<FIR_ORDER, FIR_LowPass02>, new FIR<FIR_ORDER, FIR_LowPass02>);
+    }
+    colorSense(sensor, iterations);
+}
+
+void colorSenseFilterBank(long iterations) {
+    static FilteredColorSensor* sensor = nullptr;
+    if (sensor == nullptr) {
+        sensor = new FilteredColorSensor(PORT_2);
+        sensor->setRawColorFilterBank(new FIRBank<FIR_ORDER, FIR_LowPass02>);
+    }
+    colorSense(sensor, iterations);
+}
+
+/* the FIR in fixed point as built by FIXED_POINT, in integers from the sensor to the filtered color */
+void colorSenseFiltersFix(long iterations) {
+    static FilteredColorSensor* sensor = nullptr;
+    if (sensor == nullptr) {
+        sensor = new FilteredColorSensor(PORT_2);
+        sensor->setRawColorFiltersFix(new FIR_Q15<FIR_ORDER, FIR_LowPass02>, new FIR_Q15<FIR_ORDER, FIR_LowPass02>,
+                                      new FIR_Q15<FIR_ORDER, FIR_LowPass02>);
+    }
+    colorSense(sensor, iterations);
+}
+
+/* the PWM filtered by SRLF_Q15 through double as Filter or in integers as FilterFix */
+void motorDrive(FilteredMotor* motor, long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        motor->setPWM((int)(50.0 * inputs[i % inputSize]));
+        motor->drive();
+        doNotOptimize(motor->getPWM());
+    }
+}
+
+void motorDriveQ15(long iterations) {
+    static FilteredMotor* motor = nullptr;
+    if (motor == nullptr) {
+        motor = new FilteredMotor(PORT_C);
+        motor->setPWMFilter(new SRLF_Q15(0.5));
+    }
+    motorDrive(motor, iterations);
+}
+
+void motorDriveFix(long iterations) {
+    static FilteredMotor* motor = nullptr;
+    if (motor == nullptr) {
+        motor = new FilteredMotor(PORT_C);
+        motor->setPWMFilterFix(new SRLF_Q15(0.5));
+    }
+    motorDrive(motor, iterations);
+}
+
+/* the IIR in place of the FIR by LPF_TYPE=BESSEL and LPF_ORDER=2 */
+void sosBessel2(long iterations) {
+    static SOS sos(SOS::BESSEL, 2, 10.0, 100.0);
+    for (long i = 0; i < iterations; i++) {
+        doNotOptimize(sos.apply(inputs[i % inputSize]));
+    }
+}
+
+/* the IIR followed by the slew rate limiter, stage by stage through Filter and as a FilterChain */
+void sosSrlfStages(long iterations) {
+    static Filter* stages[2] = { new SOS(SOS::BESSEL, 2, 10.0, 100.0), new SRLF(0.5) };
+    for (long i = 0; i < iterations; i++) {
+        doNotOptimize(stages[1]->apply(stages[0]->apply(inputs[i % inputSize])));
+    }
+}
+
+void sosSrlfChain(long iterations) {
+    static Filter* chain = new FilterChain<SOS, SRLF>(SOS(SOS::BESSEL, 2, 10.0, 100.0), SRLF(0.5));
+    for (long i = 0; i < iterations; i++) {
+        doNotOptimize(chain->apply(inputs[i % inputSize]));
+    }
+}
+
+/* the median of a channel as in IsColorDetected, and Hampel of the sonar as in DetectSlalomPattern */
+void rollingMedian3(long iterations) {
+    static RollingMedian<3> median;
+    for (long i = 0; i < iterations; i++) {
+        doNotOptimize(median.apply(inputs[i % inputSize]));
+    }
+}
+
+void hampel5(long iterations) {
+    static Hampel<5> hampel;
+    for (long i = 0; i < iterations; i++) {
+        doNotOptimize(hampel.apply(inputs[i % inputSize]));
+    }
+}
+
+void firTransposed(long iterations) {
+    static FIR_Transposed fir(hn, FIR_ORDER);
+    for (long i = 0; i < iterations; i++) {
+        doNotOptimize(fir.apply(inputs[i % inputSize]));
+    }
+}
+
+void firDirect(long iterations) {
+    static FIR_Direct fir(hn, FIR_ORDER);
+    for (long i = 0; i < iterations; i++) {
+        doNotOptimize(fir.apply(inputs[i % inputSize]));
+    }
+}
+
+void srlf(long iterations) {
+    static SRLF filter(0.05);
+    for (long i = 0; i < iterations; i++) {
+        doNotOptimize(filter.apply(inputs[i % inputSize]));
+    }
+}
+
+void srlfQ15(long iterations) {
+    static SRLF_Q15 filter(0.05);
+    for (long i = 0; i < iterations; i++) {
+        doNotOptimize(filter.apply(inputs[i % inputSize]));
+    }
+}
+
+void sCurve(long iterations) {
+    static SCurve filter(0.05, 0.01);
+    for (long i = 0; i < iterations; i++) {
+        doNotOptimize(filter.apply(inputs[i % inputSize]));
+    }
+}
+
+/* a pivot of 90 degrees over and over, a degree per 20 PWM per tick */
+void sCurveProfile(long iterations) {
+    static SCurveProfile profile(60.0, 3.0, 0.5, 3.0);
+    static double traveled = 90.0;
+    for (long i = 0; i < iterations; i++) {
+        if (traveled >= 90.0 || profile.isArrived()) {
+            profile.start(90.0, 0.0);
+            traveled = 0.0;
+        }
+        double v = profile.next((int)traveled);
+        traveled += v / 20.0;
+        doNotOptimize(v);
+    }
+}
+
+void movingAveragePush(long iterations) {
+    static MovingAverage<double, 10> ma;
+    for (long i = 0; i < iterations; i++) {
+        doNotOptimize(ma.push(inputs[i % inputSize]));
+    }
+}
+
+void movingAverageStdev(long iterations) {
+    static MovingAverage<double, 10> ma;
+    for (long i = 0; i < iterations; i++) {
+        ma.push(inputs[i % inputSize]);
+        doNotOptimize(ma.stdev());
+    }
+}
+
+/* the line tracer of TraceLine on the reflection of 0..100 */
+void pidCompute(long iterations) {
+    static PIDcalculator pid(0.7, 0.01, 0.05, PERIOD_UPD_TSK, -50, 50);
+    for (long i = 0; i < iterations; i++) {
+        doNotOptimize(pid.compute((int16_t)(50.0 + 40.0 * inputs[i % inputSize]), 50));
+    }
+}
+
+/* with the derivative filtered over two ticks */
+void pidControllerCompute(long iterations) {
+    static PIDController* pid = nullptr;
+    if (pid == nullptr) {
+        pid = new PIDController(0.7, 0.01, 0.05, PERIOD_UPD_TSK, -50, 50);
+        pid->setDerivativeFilter(0.02);
+    }
+    for (long i = 0; i < iterations; i++) {
+        doNotOptimize(pid->compute((int16_t)(50.0 + 40.0 * inputs[i % inputSize]), 50, PERIOD_UPD_TSK));
+    }
+}
+
+/* the gains looked up per tick as TraceLine under the schedule, then the PID on them */
+void gainScheduleCompute(long iterations) {
+    static GainSchedule* schedule = nullptr;
+    static PIDController* pid = nullptr;
+    if (schedule == nullptr) {
+        schedule = new GainSchedule({ 30, 40, 50, 60 }, { 0.0, 1.0, 2.0, 4.0 },
+            std::vector<double>(16, 0.7), std::vector<double>(16, 0.01), std::vector<double>(16, 0.05));
+        pid = new PIDController(0.7, 0.01, 0.05, PERIOD_UPD_TSK, -50, 50);
+    }
+    double p, k, d;
+    for (long i = 0; i < iterations; i++) {
+        schedule->gainsAt(45.0, 2.5 + 2.0 * inputs[i % inputSize], &p, &k, &d);
+        pid->setGains(p, k, d);
+        doNotOptimize(pid->compute((int16_t)(50.0 + 40.0 * inputs[i % inputSize]), 50, PERIOD_UPD_TSK));
+    }
+}
+
+void pidComputeQ15(long iterations) {
+    static PIDcalculator_Q15 pid(0.7, 0.01, 0.05, PERIOD_UPD_TSK, -50, 50);
+    for (long i = 0; i < iterations; i++) {
+        doNotOptimize(pid.compute((int16_t)(50.0 + 40.0 * inputs[i % inputSize]), 50));
+    }
+}
+
+void plotterPlot(long iterations) {
+    static Plotter* plotter = new Plotter(new ev3api::Motor(PORT_C), new ev3api::Motor(PORT_B),
+                                          new ev3api::GyroSensor(PORT_4));
+    for (long i = 0; i < iterations; i++) {
+        plotter->plot();
+        doNotOptimize(plotter->getLocX());
+    }
+}
+
+void plotterPlotQ31(long iterations) {
+    static Plotter_Q31* plotter = new Plotter_Q31(new ev3api::Motor(PORT_C), new ev3api::Motor(PORT_B),
+                                                  new ev3api::GyroSensor(PORT_4));
+    for (long i = 0; i < iterations; i++) {
+        plotter->plot();
+        doNotOptimize(plotter->getLocX());
+    }
+}
+
+/* a condition succeeding after the ticks since it is entered, as IsDistanceEarned or IsTimeEarned */
+class IsTicked : public BrainTree::Node {
+public:
+    explicit IsTicked(int t) : ticks(t), count(0) {}
+    void initialize() override { count = 0; }
+    Status update() override { return (++count >= ticks) ? Status::Success : Status::Running; }
+private:
+    int ticks, count;
+};
+
+/* a condition never met, as IsBackOn */
+class IsNever : public BrainTree::Node {
+public:
+    Status update() override { return Status::Failure; }
+};
+
+/* an action running for good, as TraceLine or RunAsInstructed */
+class Drive : public BrainTree::Node {
+public:
+    Drive() : i(0) {}
+    Status update() override {
+        doNotOptimize(inputs[i++ % inputSize]);
+        return Status::Running;
+    }
+private:
+    long i;
+};
+
+/* a tree of the shape of tr_run for the left course, looping over its sections */
+BrainTree::Node* tree() {
+    return BrainTree::Builder()
+        .composite<BrainTree::ParallelWatch>()
+            .leaf<IsNever>()
+            .composite<BrainTree::MemSequence>()
+                .composite<BrainTree::ParallelSequence>(2,2)
+                    .leaf<IsTicked>(30)
+                    .leaf<IsTicked>(50)
+                    .leaf<Drive>()
+                .end()
+                .composite<BrainTree::ParallelWatch>()
+                    .leaf<IsTicked>(80)
+                    .leaf<IsTicked>(100)
+                    .leaf<Drive>()
+                .end()
+                .composite<BrainTree::ParallelSequence>(2,2)
+                    .leaf<IsTicked>(40)
+                    .leaf<IsTicked>(20)
+                    .leaf<Drive>()
+                .end()
+                .composite<BrainTree::ParallelWatch>()
+                    .leaf<IsTicked>(60)
+                    .leaf<Drive>()
+                .end()
+            .end()
+        .end()
+        .build();
+}
+
+void brainTreeTick(long iterations) {
+    static BrainTree::Node* root = tree();
+    for (long i = 0; i < iterations; i++) {
+        doNotOptimize(root->tick());
+    }
+}
+
+Benchmark b0("FIR<4>::apply", firFixed);
+Benchmark b0q("FIR_Q15<4>::apply", firFixedQ15);
+Benchmark b1("FIR_Transposed::apply", firTransposed);
+Benchmark b1i("SOS::apply", sosBessel2);
+Benchmark b1c("SOS+SRLF::apply", sosSrlfStages);
+Benchmark b1d("FilterChain::apply", sosSrlfChain);
+Benchmark b1m("RollingMedian<3>::apply", rollingMedian3);
+Benchmark b1h("Hampel<5>::apply", hampel5);
+Benchmark b1r("Filter::apply*3", rgbFilters);
+Benchmark b1b("FIRBank<4>::apply", rgbFilterBank);
+Benchmark b1s("FilteredColorSensor::sense+Filter*3", colorSenseFilters);
+Benchmark b1t("FilteredColorSensor::sense+FIRBank", colorSenseFilterBank);
+Benchmark b1f("FilteredColorSensor::sense+FilterFix*3", colorSenseFiltersFix);
+Benchmark b2("FIR_Direct::apply", firDirect);
+Benchmark b3("SRLF::apply", srlf);
+Benchmark b3q("SRLF_Q15::apply", srlfQ15);
+Benchmark b3m("FilteredMotor::drive+SRLF_Q15", motorDriveQ15);
+Benchmark b3f("FilteredMotor::drive+FilterFix", motorDriveFix);
+Benchmark b3s("SCurve::apply", sCurve);
+Benchmark b3p("SCurveProfile::next", sCurveProfile);
+Benchmark b4("MovingAverage::push", movingAveragePush);
+Benchmark b5("MovingAverage::push+stdev", movingAverageStdev);
+Benchmark b6("PIDcalculator::compute", pidCompute);
+Benchmark b6c("PIDController::compute", pidControllerCompute);
+Benchmark b6s("GainSchedule::gainsAt+PIDController::compute", gainScheduleCompute);
+Benchmark b6q("PIDcalculator_Q15::compute", pidComputeQ15);
+Benchmark b7("Plotter::plot", plotterPlot);
+Benchmark b7q("Plotter_Q31::plot", plotterPlotQ31);
+Benchmark b8("BrainTree::Node::tick", brainTreeTick);
+
+} // namespace
@@ -0,0 +1,76 @@
+/*
+    stub.cpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#include "ev3api.h"
+
+/*
+    the part of ev3api used by the code under measurement, stubbed out with no kernel nor plant
+    so that the benchmarks measure the code of the app alone:
+    the wheels advance by a few degrees on every read of the encoder as if the robot ran a curve,
+    and the color sensor reads across the edge of the line back and forth.
+*/
+namespace {
+
+int32_t counts[TNUM_MOTOR_PORT];
+int16_t angle;
+SYSTIM systim;
+int colorPhase;
+
+} // namespace
+
+ER ev3_motor_config(motor_port_t port, motor_type_t type) {
+    return E_OK;
+}
+
+int32_t ev3_motor_get_counts(motor_port_t port) {
+    counts[port] += 3 + port;
+    return counts[port];
+}
+
+ER ev3_motor_stop(motor_port_t port, bool_t brake) {
+    return E_OK;
+}
+
+ER ev3_motor_set_power(motor_port_t port, int power) {
+    return E_OK;
+}
+
+ER ev3_sensor_config(sensor_port_t port, sensor_type_t type) {
+    return E_OK;
+}
+
+int16_t ev3_gyro_sensor_get_angle(sensor_port_t port) {
+    return ++angle;
+}
+
+int16_t ev3_gyro_sensor_get_rate(sensor_port_t port) {
+    return 1;
+}
+
+ER ev3_gyro_sensor_reset(sensor_port_t port) {
+    angle = 0;
+    return E_OK;
+}
+
+ER get_tim(SYSTIM* p_systim) {
+    *p_systim = (systim += 4000);
+    return E_OK;
+}
+
+ER dly_tsk(RELTIM dlytim) {
+    systim += dlytim;
+    return E_OK;
+}
+
+void syslog(unsigned int prio, const char* format, ...) {
+}
+
+void ev3_color_sensor_get_rgb_raw(sensor_port_t port, rgb_raw_t* val) {
+    colorPhase = (colorPhase + 1) % 64;
+    int x = (colorPhase < 32) ? colorPhase : 64 - colorPhase;
+    val->r = (uint16_t)(60 + 3 * x);
+    val->g = (uint16_t)(65 + 3 * x);
+    val->b = (uint16_t)(80 + 2 * x);
+}
@@ -0,0 +1,44 @@
+#
+#   cfg2id.awk
+#
+#   Copyright © 2022 MSAD Mode2P. All rights reserved.
+#
+#   generates kernel_cfg.h, i.e. the object IDs, from app.cfg
+#   usage: awk -f cfg2id.awk app.cfg > kernel_cfg.h
+#
+BEGIN {
+    print "/* generated from app.cfg by cfg2id.awk, do not edit */"
+    print "#ifndef kernel_cfg_h"
+    print "#define kernel_cfg_h"
+    print ""
+    ntsk = 0
+    ncyc = 0
+}
+
+# skip comments
+/^[ \t]*\/\// { next }
+
+/CRE_TSK[ \t]*\(/ {
+    sub(/.*CRE_TSK[ \t]*\([ \t]*/, "")
+    sub(/[ \t]*,.*/, "")
+    printf("#define %-24s %d\n", $0, ++ntsk)
+    next
+}
+
+/CRE_CYC[ \t]*\(/ {
+    sub(/.*CRE_CYC[ \t]*\([ \t]*/, "")
+    sub(/[ \t]*,.*/, "")
+    cyc[++ncyc] = $0
+    next
+}
+
+END {
+    printf("#define %-24s %d\n", "TNUM_TSKID", ntsk)
+    print ""
+    for (i = 1; i <= ncyc; i++) {
+        printf("#define %-24s %d\n", cyc[i], i)
+    }
+    printf("#define %-24s %d\n", "TNUM_CYCID", ncyc)
+    print ""
+    print "#endif /* kernel_cfg_h */"
+}
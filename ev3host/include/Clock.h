@@ -0,0 +1,32 @@
+/*
+    Clock.h
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#ifndef Clock_h
+#define Clock_h
+
+#include "ev3api.h"
+
+namespace ev3api {
+
+/* host stand-in for ev3api::Clock of libcpp-ev3, in microsecond */
+class Clock {
+public:
+    Clock(void) { reset(); }
+    void reset(void) { get_tim(&mStartTime); }
+    uint32_t now(void) const {
+        SYSTIM time;
+        get_tim(&time);
+        return (uint32_t)(time - mStartTime);
+    }
+    /* busy wait on EV3, which would never end on the virtual clock of the host, hence a delay instead */
+    void wait(uint32_t duration) { dly_tsk(duration); }
+    void sleep(uint32_t duration) { dly_tsk(duration); }
+private:
+    SYSTIM mStartTime;
+};
+
+} // namespace ev3api
+
+#endif /* Clock_h */
@@ -0,0 +1,25 @@
+/*
+    ColorSensor.h
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#ifndef ColorSensor_h
+#define ColorSensor_h
+
+#include "Sensor.h"
+
+namespace ev3api {
+
+/* host stand-in for ev3api::ColorSensor of libcpp-ev3 */
+class ColorSensor : public Sensor {
+public:
+    explicit ColorSensor(ePortS port) : Sensor(port, COLOR_SENSOR) {}
+    int8_t getBrightness(void) const { return ev3_color_sensor_get_reflect(getPort()); }
+    int8_t getAmbient(void) const { return ev3_color_sensor_get_ambient(getPort()); }
+    colorid_t getColorNumber(void) const { return ev3_color_sensor_get_color(getPort()); }
+    void getRawColor(rgb_raw_t& rgb) const { ev3_color_sensor_get_rgb_raw(getPort(), &rgb); }
+};
+
+} // namespace ev3api
+
+#endif /* ColorSensor_h */
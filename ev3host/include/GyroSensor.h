@@ -0,0 +1,27 @@
+/*
+    GyroSensor.h
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#ifndef GyroSensor_h
+#define GyroSensor_h
+
+#include "Sensor.h"
+
+namespace ev3api {
+
+/* host stand-in for ev3api::GyroSensor of libcpp-ev3 */
+class GyroSensor : public Sensor {
+public:
+    explicit GyroSensor(ePortS port) : Sensor(port, GYRO_SENSOR), mOffset(0) {}
+    void setOffset(int16_t offset) { mOffset = offset; }
+    void reset(void) { ev3_gyro_sensor_reset(getPort()); }
+    int16_t getAnglerVelocity(void) const { return ev3_gyro_sensor_get_rate(getPort()) - mOffset; }
+    int16_t getAngle(void) const { return ev3_gyro_sensor_get_angle(getPort()); }
+private:
+    int16_t mOffset;
+};
+
+} // namespace ev3api
+
+#endif /* GyroSensor_h */
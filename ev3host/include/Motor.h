@@ -0,0 +1,53 @@
+/*
+    Motor.h
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#ifndef Motor_h
+#define Motor_h
+
+#include "Port.h"
+
+namespace ev3api {
+
+/* host stand-in for ev3api::Motor of libcpp-ev3 */
+class Motor {
+public:
+    static const int PWM_MAX = 100;
+    static const int PWM_MIN = -100;
+
+    Motor(ePortM port, bool brake = true, motor_type_t type = LARGE_MOTOR) : mPort((motor_port_t)port), mBrake(brake), mType(type), mOffset(0), mPWM(0) {
+        ev3_motor_config(mPort, mType);
+    }
+    virtual ~Motor(void) {
+        ev3_motor_stop(mPort, mBrake);
+    }
+    void reset(void) {
+        mOffset = ev3_motor_get_counts(mPort);
+        mPWM = 0;
+        ev3_motor_stop(mPort, mBrake);
+    }
+    int32_t getCount(void) const { return ev3_motor_get_counts(mPort) - mOffset; }
+    void setCount(int32_t count) { mOffset = ev3_motor_get_counts(mPort) - count; }
+    int getPWM(void) const { return mPWM; }
+    void setPWM(int pwm) {
+        mPWM = (pwm > PWM_MAX) ? PWM_MAX : (pwm < PWM_MIN) ? PWM_MIN : pwm;
+        if (mPWM == 0) {
+            ev3_motor_stop(mPort, mBrake);
+        } else {
+            ev3_motor_set_power(mPort, mPWM);
+        }
+    }
+    void setBrake(bool brake) { mBrake = brake; }
+    void stop(void) { setPWM(0); }
+protected:
+    motor_port_t mPort;
+    bool mBrake;
+    motor_type_t mType;
+    int32_t mOffset;
+    int mPWM;
+};
+
+} // namespace ev3api
+
+#endif /* Motor_h */
@@ -0,0 +1,27 @@
+/*
+    Port.h
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#ifndef Port_h
+#define Port_h
+
+#include "ev3api.h"
+
+/* sensor ports of ev3api C++ classes */
+enum ePortS {
+    PORT_1 = EV3_PORT_1,
+    PORT_2 = EV3_PORT_2,
+    PORT_3 = EV3_PORT_3,
+    PORT_4 = EV3_PORT_4
+};
+
+/* motor ports of ev3api C++ classes */
+enum ePortM {
+    PORT_A = EV3_PORT_A,
+    PORT_B = EV3_PORT_B,
+    PORT_C = EV3_PORT_C,
+    PORT_D = EV3_PORT_D
+};
+
+#endif /* Port_h */
@@ -0,0 +1,28 @@
+/*
+    Sensor.h
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#ifndef Sensor_h
+#define Sensor_h
+
+#include "Port.h"
+
+namespace ev3api {
+
+/* host stand-in for ev3api::Sensor of libcpp-ev3 */
+class Sensor {
+public:
+    Sensor(ePortS port, sensor_type_t type) : mPort((sensor_port_t)port) {
+        ev3_sensor_config(mPort, type);
+    }
+    virtual ~Sensor(void) {}
+protected:
+    sensor_port_t getPort(void) const { return mPort; }
+private:
+    sensor_port_t mPort;
+};
+
+} // namespace ev3api
+
+#endif /* Sensor_h */
@@ -0,0 +1,24 @@
+/*
+    SonarSensor.h
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#ifndef SonarSensor_h
+#define SonarSensor_h
+
+#include "Sensor.h"
+
+namespace ev3api {
+
+/* host stand-in for ev3api::SonarSensor of libcpp-ev3 */
+class SonarSensor : public Sensor {
+public:
+    explicit SonarSensor(ePortS port) : Sensor(port, ULTRASONIC_SENSOR) {}
+    /* distance in centimeter */
+    int16_t getDistance(void) const { return ev3_ultrasonic_sensor_get_distance(getPort()); }
+    bool listen(void) const { return ev3_ultrasonic_sensor_listen(getPort()); }
+};
+
+} // namespace ev3api
+
+#endif /* SonarSensor_h */
@@ -0,0 +1,35 @@
+/*
+    Steering.h
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#ifndef Steering_h
+#define Steering_h
+
+#include "Motor.h"
+
+namespace ev3api {
+
+/* host stand-in for ev3api::Steering of libcpp-ev3 */
+class Steering {
+public:
+    Steering(Motor& leftMotor, Motor& rightMotor) : mLeftMotor(leftMotor), mRightMotor(rightMotor) {}
+    /* turnRatio in [-100, 100], positive to turn right */
+    void setPower(int power, int turnRatio) {
+        int left = power, right = power;
+        if (turnRatio > 0) {
+            right = power * (100 - 2 * turnRatio) / 100;
+        } else if (turnRatio < 0) {
+            left = power * (100 + 2 * turnRatio) / 100;
+        }
+        mLeftMotor.setPWM(left);
+        mRightMotor.setPWM(right);
+    }
+private:
+    Motor& mLeftMotor;
+    Motor& mRightMotor;
+};
+
+} // namespace ev3api
+
+#endif /* Steering_h */
@@ -0,0 +1,22 @@
+/*
+    TouchSensor.h
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#ifndef TouchSensor_h
+#define TouchSensor_h
+
+#include "Sensor.h"
+
+namespace ev3api {
+
+/* host stand-in for ev3api::TouchSensor of libcpp-ev3 */
+class TouchSensor : public Sensor {
+public:
+    explicit TouchSensor(ePortS port) : Sensor(port, TOUCH_SENSOR) {}
+    bool isPressed(void) const { return ev3_touch_sensor_is_pressed(getPort()); }
+};
+
+} // namespace ev3api
+
+#endif /* TouchSensor_h */
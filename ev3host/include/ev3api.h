@@ -0,0 +1,207 @@
+/*
+    ev3api.h
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#ifndef ev3api_h
+#define ev3api_h
+
+/*
+    Host stand-in for ev3api.h of EV3RT.
+    It declares the subset of the TOPPERS kernel service calls and the EV3 C API used by the apps
+    so that they can be built as a Linux process by ev3host/Makefile.
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <assert.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    TOPPERS kernel types and constants
+*/
+typedef int             ER;
+typedef int             ID;
+typedef int             PRI;
+typedef unsigned int    ATR;
+typedef unsigned int    MODE;
+typedef int             bool_t;
+typedef int32_t         TMO;
+typedef uint32_t        RELTIM;
+typedef uint64_t        SYSTIM;     /* in microsecond */
+typedef uint32_t        HRTCNT;     /* in microsecond */
+typedef void            (*TASK)(intptr_t exinf);
+typedef void            (*NFYHDR)(intptr_t exinf);
+
+#ifndef TRUE
+#define TRUE            1
+#endif
+#ifndef FALSE
+#define FALSE           0
+#endif
+
+#define E_OK            0
+#define E_SYS           (-5)
+#define E_NOSPT         (-9)
+#define E_PAR           (-17)
+#define E_ID            (-18)
+#define E_CTX           (-25)
+#define E_OBJ           (-41)
+#define E_QOVR          (-43)
+#define E_TMOUT         (-50)
+#define E_RLWAI         (-49)
+
+#define TA_NULL         0U
+#define TA_ACT          0x01U
+#define TA_STA          0x02U
+#define TA_PHS          0x04U
+
+#define TSK_SELF        0
+#define TMO_POL         0
+#define TMO_FEVR        (-1)
+
+#define TMIN_TPRI       1
+#define TMAX_TPRI       16
+#define TMIN_APP_TPRI   (TMIN_TPRI + 5)
+
+/* notification modes for CRE_CYC */
+#define TNFY_HANDLER    0x00U
+#define TNFY_SETVAR     0x01U
+#define TNFY_INCVAR     0x02U
+#define TNFY_ACTTSK     0x03U
+#define TNFY_WUPTSK     0x04U
+#define TENFY_SETVAR    0x10U
+#define TENFY_INCVAR    0x20U
+
+/* syslog priorities */
+#define LOG_EMERG       0
+#define LOG_ALERT       1
+#define LOG_CRIT        2
+#define LOG_ERROR       3
+#define LOG_WARNING     4
+#define LOG_NOTICE      5
+#define LOG_INFO        6
+#define LOG_DEBUG       7
+
+extern ER       act_tsk(ID tskid);
+extern ER       wup_tsk(ID tskid);
+extern ER       slp_tsk(void);
+extern ER       tslp_tsk(TMO tmout);
+extern ER       dly_tsk(RELTIM dlytim);
+extern void     ext_tsk(void);
+extern ER       get_tid(ID* p_tskid);
+extern ER       sta_cyc(ID cycid);
+extern ER       stp_cyc(ID cycid);
+extern ER       get_tim(SYSTIM* p_systim);
+extern HRTCNT   fch_hrt(void);
+extern void     syslog(unsigned int prio, const char* format, ...);
+
+/*
+    EV3 C API
+*/
+typedef enum {
+    EV3_PORT_1 = 0, EV3_PORT_2, EV3_PORT_3, EV3_PORT_4, TNUM_SENSOR_PORT
+} sensor_port_t;
+
+typedef enum {
+    EV3_PORT_A = 0, EV3_PORT_B, EV3_PORT_C, EV3_PORT_D, TNUM_MOTOR_PORT
+} motor_port_t;
+
+typedef enum {
+    NONE_SENSOR = 0, ULTRASONIC_SENSOR, GYRO_SENSOR, TOUCH_SENSOR, COLOR_SENSOR, INFRARED_SENSOR, HT_NXT_ACCEL_SENSOR,
+    NXT_TEMP_SENSOR, TNUM_SENSOR_TYPE
+} sensor_type_t;
+
+typedef enum {
+    NONE_MOTOR = 0, MEDIUM_MOTOR, LARGE_MOTOR, UNREGULATED_MOTOR, TNUM_MOTOR_TYPE
+} motor_type_t;
+
+typedef enum {
+    COLOR_NONE = 0, COLOR_BLACK, COLOR_BLUE, COLOR_GREEN, COLOR_YELLOW, COLOR_RED, COLOR_WHITE, COLOR_BROWN, TNUM_COLOR
+} colorid_t;
+
+typedef struct {
+    uint16_t r;
+    uint16_t g;
+    uint16_t b;
+} rgb_raw_t;
+
+typedef enum {
+    LEFT_BUTTON = 0, RIGHT_BUTTON, UP_BUTTON, DOWN_BUTTON, ENTER_BUTTON, BACK_BUTTON, TNUM_BUTTON
+} button_t;
+
+typedef enum {
+    LED_OFF = 0, LED_RED = 1, LED_GREEN = 2, LED_ORANGE = 3
+} ledcolor_t;
+
+typedef enum {
+    EV3_SERIAL_DEFAULT = 0, EV3_SERIAL_UART = 1, EV3_SERIAL_BT = 2
+} serial_port_t;
+
+typedef enum {
+    EV3_FONT_SMALL, EV3_FONT_MEDIUM
+} lcdfont_t;
+
+typedef enum {
+    EV3_LCD_WHITE = 0, EV3_LCD_BLACK = 1
+} lcdcolor_t;
+
+#define EV3_LCD_WIDTH   178
+#define EV3_LCD_HEIGHT  128
+
+extern ER           ev3_motor_config(motor_port_t port, motor_type_t type);
+extern motor_type_t ev3_motor_get_type(motor_port_t port);
+extern int32_t      ev3_motor_get_counts(motor_port_t port);
+extern ER           ev3_motor_reset_counts(motor_port_t port);
+extern ER           ev3_motor_set_power(motor_port_t port, int power);
+extern int          ev3_motor_get_power(motor_port_t port);
+extern ER           ev3_motor_stop(motor_port_t port, bool_t brake);
+extern ER           ev3_motor_steer(motor_port_t left_motor, motor_port_t right_motor, int power, int turn_ratio);
+
+extern ER           ev3_sensor_config(sensor_port_t port, sensor_type_t type);
+extern sensor_type_t ev3_sensor_get_type(sensor_port_t port);
+extern colorid_t    ev3_color_sensor_get_color(sensor_port_t port);
+extern uint8_t      ev3_color_sensor_get_reflect(sensor_port_t port);
+extern uint8_t      ev3_color_sensor_get_ambient(sensor_port_t port);
+extern void         ev3_color_sensor_get_rgb_raw(sensor_port_t port, rgb_raw_t* val);
+extern int16_t      ev3_gyro_sensor_get_angle(sensor_port_t port);
+extern int16_t      ev3_gyro_sensor_get_rate(sensor_port_t port);
+extern ER           ev3_gyro_sensor_reset(sensor_port_t port);
+extern int16_t      ev3_ultrasonic_sensor_get_distance(sensor_port_t port);
+extern bool_t       ev3_ultrasonic_sensor_listen(sensor_port_t port);
+extern bool_t       ev3_touch_sensor_is_pressed(sensor_port_t port);
+
+extern bool_t       ev3_button_is_pressed(button_t button);
+extern ER           ev3_led_set_color(ledcolor_t color);
+extern int          ev3_battery_voltage_mV(void);
+extern int          ev3_battery_current_mA(void);
+extern ER           ev3_speaker_set_volume(uint8_t volume);
+extern ER           ev3_speaker_play_tone(uint16_t frequency, int32_t duration);
+extern ER           ev3_lcd_set_font(lcdfont_t font);
+extern ER           ev3_lcd_draw_string(const char* str, int32_t x, int32_t y);
+extern ER           ev3_lcd_fill_rect(int32_t x, int32_t y, int32_t w, int32_t h, lcdcolor_t color);
+extern FILE*        ev3_serial_open_file(serial_port_t port);
+extern ER           ev3_sta_cyc(ID cycid);
+extern ER           ev3_stp_cyc(ID cycid);
+extern bool_t       ev3_bluetooth_is_connected(void);
+
+/*
+    extension of ev3host, to be called by the app only when built with MAKE_HOST
+*/
+/* report a transition between the phases of the app, e.g. the states of its state machine,
+   to time the sections of the run in EV3HOST_SUMMARY */
+extern void         ev3host_notifyPhase(const char* from, const char* to);
+
+#ifdef __cplusplus
+}
+#endif
+
+/* object IDs generated from app.cfg of the app being built */
+#include "kernel_cfg.h"
+
+#endif /* ev3api_h */
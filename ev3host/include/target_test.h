@@ -0,0 +1,11 @@
+/*
+    target_test.h
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#ifndef target_test_h
+#define target_test_h
+
+/* nothing to test on the host; present only because app.h includes it */
+
+#endif /* target_test_h */
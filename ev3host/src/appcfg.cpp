@@ -0,0 +1,23 @@
+/*
+    appcfg.cpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#include "kernel.hpp"
+
+/*
+    app.cfg of the app is included here as C++ so that the static API calls in it
+    register the tasks and the cyclic notifications to the host kernel.
+    The IDs are defined in kernel_cfg.h generated from the same app.cfg by cfg2id.awk.
+*/
+#define INCLUDE(file)
+#define ATT_MOD(file)
+#define DOMAIN(dom) \
+    static void ev3host_configure_##dom(void); \
+    static ev3host::Configurator ev3host_configurator_##dom(ev3host_configure_##dom); \
+    static void ev3host_configure_##dom(void)
+#define CRE_TSK(id, ...)        ev3host::creTsk(id, #id, T_CTSK __VA_ARGS__)
+#define CRE_CYC(id, ...)        ev3host::creCyc(id, #id, T_CCYC __VA_ARGS__)
+#define EV3_CRE_CYC(id, ...)    ev3host::creEv3Cyc(id, #id, T_EV3CYC __VA_ARGS__)
+
+#include APP_CFG
@@ -0,0 +1,390 @@
+/*
+    course.cpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#include "kernel.hpp"
+#include "course.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ev3host {
+
+RobotSpec::RobotSpec()
+ : tireDiameter(100.0), wheelTread(128.0), leftMotor(EV3_PORT_C), rightMotor(EV3_PORT_B),
+   motorTimeConstant(0.08), colorForward(70.0), colorLeft(0.0), colorRadius(5.0),
+   sonarForward(90.0), sonarLeft(0.0) {}
+
+Course::Course(RGB floor)
+ : width(0.0), height(0.0), resolution(1.0), columns(0), rows(0), floor(floor), pixels(nullptr), mapped(false),
+   goalLine{ 0.0, 0.0, 0.0, 0.0 }, goalGiven(false), startPose{ 0.0, 0.0, 0.0 } {}
+
+namespace {
+
+/* the raw values of the colors as read on the course of ET Robocon */
+const std::map<std::string, RGB> predefinedColors = {
+    { "white",  { 110, 115, 120 } },
+    { "black",  {  10,  11,  14 } },
+    { "gray",   {  48,  55,  58 } },
+    { "blue",   {  22,  60,  90 } },
+    { "red",    { 100,  30,  40 } },
+    { "yellow", { 115, 105,  50 } },
+    { "green",  {  35,  70,  45 } },
+};
+
+double degToRad(double deg) {
+    return deg * M_PI / 180.0;
+}
+
+/* distance from the point to the segment */
+double distanceToSegment(double px, double py, double x1, double y1, double x2, double y2) {
+    double dx = x2 - x1, dy = y2 - y1;
+    double len2 = dx * dx + dy * dy;
+    double t = (len2 > 0.0) ? ((px - x1) * dx + (py - y1) * dy) / len2 : 0.0;
+    t = (t < 0.0) ? 0.0 : (t > 1.0) ? 1.0 : t;
+    return std::hypot(px - (x1 + t * dx), py - (y1 + t * dy));
+}
+
+/* header of the file caching the raster of a course, followed by the pixels */
+struct RasterHeader {
+    char magic[8];
+    int32_t columns, rows;
+};
+const char RASTER_MAGIC[8] = { 'e', 'v', '3', 'r', 'a', 's', '1', '\0' };
+
+/* FNV-1a of the course file, which determines the raster */
+uint64_t hashOf(const std::string& text) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (unsigned char c : text) {
+        h = (h ^ c) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+std::string cachePath(const std::string& text) {
+    const char* dir = getenv("TMPDIR");
+    char name[64];
+    snprintf(name, sizeof(name), "/ev3host.course.%016llx", (unsigned long long)hashOf(text));
+    return std::string((dir != nullptr && *dir != '\0') ? dir : "/tmp") + name;
+}
+
+/* the pixels of the cached raster mapped read-only, or nullptr if not cached as expected */
+const RGB* mapRaster(const std::string& path, int columns, int rows) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+    size_t size = sizeof(RasterHeader) + (size_t)columns * rows * sizeof(RGB);
+    struct stat st;
+    void* addr = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size == size) {
+        addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (addr == MAP_FAILED) return nullptr;
+    const RasterHeader* header = (const RasterHeader*)addr;
+    if (memcmp(header->magic, RASTER_MAGIC, sizeof(RASTER_MAGIC)) != 0 || header->columns != columns || header->rows != rows) {
+        munmap(addr, size);
+        return nullptr;
+    }
+    return (const RGB*)(header + 1);
+}
+
+/* write the raster to the cache, atomically by renaming so that a concurrent process never maps a partial one */
+bool saveRaster(const std::string& path, int columns, int rows, const std::vector<RGB>& raster) {
+    std::string temp = path + "." + std::to_string(getpid());
+    FILE* fp = fopen(temp.c_str(), "wb");
+    if (fp == nullptr) return false;
+    RasterHeader header;
+    memcpy(header.magic, RASTER_MAGIC, sizeof(RASTER_MAGIC));
+    header.columns = columns;
+    header.rows = rows;
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+              fwrite(raster.data(), sizeof(RGB), raster.size(), fp) == raster.size();
+    ok = (fclose(fp) == 0) && ok && rename(temp.c_str(), path.c_str()) == 0;
+    if (!ok) unlink(temp.c_str());
+    return ok;
+}
+
+struct Parser {
+    const char* path;
+    int lineno;
+    std::istringstream args;
+    std::map<std::string, RGB> colors;
+
+    void fail(const char* what) {
+        syslog(LOG_ERROR, "ev3host: %s:%d: %s", path, lineno, what);
+        exit(2);
+    }
+    double number() {
+        double value;
+        if (!(args >> value)) fail("number expected");
+        return value;
+    }
+    RGB color() {
+        std::string name;
+        if (!(args >> name)) fail("color expected");
+        auto it = colors.find(name);
+        if (it == colors.end()) fail("undefined color");
+        return it->second;
+    }
+    int motorPort() {
+        std::string name;
+        if (!(args >> name) || name.size() != 1 || name[0] < 'A' || name[0] > 'D') fail("motor port A to D expected");
+        return EV3_PORT_A + (name[0] - 'A');
+    }
+};
+
+} // namespace
+
+/* paint the pixels whose center satisfies inside(x, y) within the bounding box */
+template<typename Inside>
+void Course::paint(double x0, double y0, double x1, double y1, RGB color, Inside inside) {
+    if (mapped) return;
+    int c0 = std::max(0, (int)std::floor(x0 / resolution));
+    int c1 = std::min(columns - 1, (int)std::ceil(x1 / resolution));
+    int r0 = std::max(0, (int)std::floor(y0 / resolution));
+    int r1 = std::min(rows - 1, (int)std::ceil(y1 / resolution));
+    for (int row = r0; row <= r1; row++) {
+        double y = (row + 0.5) * resolution;
+        for (int col = c0; col <= c1; col++) {
+            double x = (col + 0.5) * resolution;
+            if (inside(x, y)) raster[row * columns + col] = color;
+        }
+    }
+}
+
+Course* Course::load(const char* path, RobotSpec* spec) {
+    std::ifstream file(path);
+    if (!file) {
+        syslog(LOG_ERROR, "ev3host: cannot open course file %s", path);
+        exit(2);
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    std::string cache = cachePath(text.str());
+    std::istringstream in(text.str());
+    Course* course = new Course(predefinedColors.at("white"));
+    Parser p{ path, 0, std::istringstream(), predefinedColors };
+    std::string line, directive;
+    while (std::getline(in, line)) {
+        p.lineno++;
+        line = line.substr(0, line.find('#'));
+        p.args.clear();
+        p.args.str(line);
+        if (!(p.args >> directive)) continue;
+
+        if (directive == "course") {
+            if (course->columns > 0) p.fail("course given twice");
+            course->width = p.number();
+            course->height = p.number();
+            if (!(p.args >> course->resolution)) course->resolution = 2.0;
+            if (course->width <= 0.0 || course->height <= 0.0 || course->resolution <= 0.0) p.fail("invalid course size");
+            course->columns = (int)std::ceil(course->width / course->resolution);
+            course->rows = (int)std::ceil(course->height / course->resolution);
+            course->pixels = mapRaster(cache, course->columns, course->rows);
+            course->mapped = (course->pixels != nullptr);
+            if (!course->mapped) course->raster.assign((size_t)course->columns * course->rows, course->floor);
+        } else if (directive == "color") {
+            std::string name;
+            if (!(p.args >> name)) p.fail("color name expected");
+            RGB c;
+            c.r = (uint8_t)p.number();
+            c.g = (uint8_t)p.number();
+            c.b = (uint8_t)p.number();
+            p.colors[name] = c;
+        } else if (directive == "floor") {
+            course->floor = p.color();
+            if (!course->mapped) course->raster.assign(course->raster.size(), course->floor);
+        } else if (directive == "line") {
+            double x1 = p.number(), y1 = p.number(), x2 = p.number(), y2 = p.number();
+            double hw = p.number() / 2.0;
+            course->paint(std::min(x1, x2) - hw, std::min(y1, y2) - hw, std::max(x1, x2) + hw, std::max(y1, y2) + hw, p.color(),
+                [=](double x, double y) { return distanceToSegment(x, y, x1, y1, x2, y2) <= hw; });
+            course->strokes.push_back(Stroke{ x1, y1, x2, y2, 0.0, 0.0, 0.0 });
+        } else if (directive == "arc") {
+            double cx = p.number(), cy = p.number(), radius = p.number();
+            double from = degToRad(p.number()), to = degToRad(p.number());
+            double hw = p.number() / 2.0;
+            if (to < from) p.fail("arc must be counterclockwise");
+            double reach = radius + hw;
+            course->paint(cx - reach, cy - reach, cx + reach, cy + reach, p.color(),
+                [=](double x, double y) {
+                    if (std::fabs(std::hypot(x - cx, y - cy) - radius) > hw) return false;
+                    double a = std::atan2(y - cy, x - cx);
+                    while (a < from) a += 2.0 * M_PI;
+                    return a <= to;
+                });
+            course->strokes.push_back(Stroke{ cx, cy, 0.0, 0.0, radius, from, to });
+        } else if (directive == "rect") {
+            double x = p.number(), y = p.number(), w = p.number(), h = p.number();
+            course->paint(x, y, x + w, y + h, p.color(),
+                [=](double px, double py) { return px >= x && px <= x + w && py >= y && py <= y + h; });
+        } else if (directive == "disc") {
+            double cx = p.number(), cy = p.number(), radius = p.number();
+            course->paint(cx - radius, cy - radius, cx + radius, cy + radius, p.color(),
+                [=](double x, double y) { return std::hypot(x - cx, y - cy) <= radius; });
+        } else if (directive == "bottle") {
+            double cx = p.number(), cy = p.number(), radius = p.number();
+            course->bottles.push_back(Circle{ cx, cy, radius });
+        } else if (directive == "wall") {
+            double x1 = p.number(), y1 = p.number(), x2 = p.number(), y2 = p.number();
+            course->walls.push_back(Segment{ x1, y1, x2, y2 });
+        } else if (directive == "gate") {
+            double x1 = p.number(), y1 = p.number(), x2 = p.number(), y2 = p.number();
+            course->gateLines.push_back(Segment{ x1, y1, x2, y2 });
+        } else if (directive == "goal") {
+            double x1 = p.number(), y1 = p.number(), x2 = p.number(), y2 = p.number();
+            course->goalLine = Segment{ x1, y1, x2, y2 };
+            course->goalGiven = true;
+        } else if (directive == "start") {
+            course->startPose.x = p.number();
+            course->startPose.y = p.number();
+            course->startPose.heading = degToRad(p.number());
+        } else if (directive == "tire_diameter") {
+            spec->tireDiameter = p.number();
+        } else if (directive == "wheel_tread") {
+            spec->wheelTread = p.number();
+        } else if (directive == "wheels") {
+            spec->leftMotor = p.motorPort();
+            spec->rightMotor = p.motorPort();
+        } else if (directive == "motor_time_constant") {
+            spec->motorTimeConstant = p.number();
+        } else if (directive == "color_sensor") {
+            spec->colorForward = p.number();
+            spec->colorLeft = p.number();
+            spec->colorRadius = p.number();
+        } else if (directive == "sonar") {
+            spec->sonarForward = p.number();
+            spec->sonarLeft = p.number();
+        } else {
+            p.fail("unknown directive");
+        }
+        std::string rest;
+        if (p.args >> rest) p.fail("extra argument");
+    }
+    if (spec->tireDiameter <= 0.0 || spec->wheelTread <= 0.0 || spec->motorTimeConstant <= 0.0) {
+        p.fail("invalid robot geometry");
+    }
+    if (!course->mapped && course->columns > 0) {
+        /* map the raster just painted so that the next process finds it cached, or keep it on the heap */
+        if (saveRaster(cache, course->columns, course->rows, course->raster)) {
+            course->pixels = mapRaster(cache, course->columns, course->rows);
+            course->mapped = (course->pixels != nullptr);
+        }
+        if (course->mapped) {
+            std::vector<RGB>().swap(course->raster);
+        } else {
+            course->pixels = course->raster.data();
+        }
+    }
+    syslog(LOG_NOTICE, "ev3host: course %s loaded, %dx%d pixels%s, %d bottles, %d walls, %d gates",
+        path, course->columns, course->rows, course->mapped ? " mapped" : "",
+        (int)course->bottles.size(), (int)course->walls.size(), (int)course->gateLines.size());
+    return course;
+}
+
+RGB Course::pixelAt(double x, double y) const {
+    int col = (int)std::floor(x / resolution);
+    int row = (int)std::floor(y / resolution);
+    if (col < 0 || col >= columns || row < 0 || row >= rows) return floor;
+    return pixels[row * columns + col];
+}
+
+void Course::sample(double x, double y, double radius, double rgb[3]) const {
+    double sum[3] = { 0.0, 0.0, 0.0 };
+    int n = 0;
+    int c0 = (int)std::floor((x - radius) / resolution), c1 = (int)std::floor((x + radius) / resolution);
+    int r0 = (int)std::floor((y - radius) / resolution), r1 = (int)std::floor((y + radius) / resolution);
+    for (int row = r0; row <= r1; row++) {
+        double py = (row + 0.5) * resolution;
+        for (int col = c0; col <= c1; col++) {
+            double px = (col + 0.5) * resolution;
+            if ((px - x) * (px - x) + (py - y) * (py - y) > radius * radius) continue;
+            RGB c = pixelAt(px, py);
+            sum[0] += c.r;
+            sum[1] += c.g;
+            sum[2] += c.b;
+            n++;
+        }
+    }
+    if (n == 0) {
+        /* the footprint is smaller than a pixel */
+        RGB c = pixelAt(x, y);
+        rgb[0] = c.r;
+        rgb[1] = c.g;
+        rgb[2] = c.b;
+        return;
+    }
+    for (int i = 0; i < 3; i++) {
+        rgb[i] = sum[i] / n;
+    }
+}
+
+double Course::distanceToLine(double x, double y) const {
+    double nearest = -1.0;
+    for (const auto& s : strokes) {
+        double d;
+        if (s.radius == 0.0) {
+            d = distanceToSegment(x, y, s.x1, s.y1, s.x2, s.y2);
+        } else {
+            double a = std::atan2(y - s.y1, x - s.x1);
+            while (a < s.from) a += 2.0 * M_PI;
+            if (a <= s.to) {
+                d = std::fabs(std::hypot(x - s.x1, y - s.y1) - s.radius);
+            } else {
+                /* nearer to either end of the arc */
+                d = std::min(std::hypot(x - s.x1 - s.radius * std::cos(s.from), y - s.y1 - s.radius * std::sin(s.from)),
+                             std::hypot(x - s.x1 - s.radius * std::cos(s.to),   y - s.y1 - s.radius * std::sin(s.to)));
+            }
+        }
+        if (nearest < 0.0 || d < nearest) nearest = d;
+    }
+    return nearest;
+}
+
+bool Course::crosses(const Segment& s, double x0, double y0, double x1, double y1) {
+    /* the end points of either lie on the opposite sides of the other */
+    auto side = [](double ax, double ay, double bx, double by, double px, double py) {
+        return (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+    };
+    double d0 = side(s.x1, s.y1, s.x2, s.y2, x0, y0), d1 = side(s.x1, s.y1, s.x2, s.y2, x1, y1);
+    double e0 = side(x0, y0, x1, y1, s.x1, s.y1), e1 = side(x0, y0, x1, y1, s.x2, s.y2);
+    return ((d0 < 0.0) != (d1 < 0.0)) && ((e0 < 0.0) != (e1 < 0.0));
+}
+
+double Course::raycast(double x, double y, double direction, double maxRange) const {
+    double dx = std::cos(direction), dy = std::sin(direction);
+    double nearest = maxRange;
+    for (const auto& b : bottles) {
+        /* solve |p + t d - c| = r for the smaller t */
+        double ox = x - b.x, oy = y - b.y;
+        double half = ox * dx + oy * dy;
+        double disc = half * half - (ox * ox + oy * oy - b.radius * b.radius);
+        if (disc < 0.0) continue;
+        double t = -half - std::sqrt(disc);
+        if (t >= 0.0 && t < nearest) nearest = t;
+    }
+    for (const auto& w : walls) {
+        double ex = w.x2 - w.x1, ey = w.y2 - w.y1;
+        double denom = dx * ey - dy * ex;
+        if (std::fabs(denom) < 1e-12) continue;
+        double t = ((w.x1 - x) * ey - (w.y1 - y) * ex) / denom;
+        double s = ((w.x1 - x) * dy - (w.y1 - y) * dx) / denom;
+        if (t >= 0.0 && s >= 0.0 && s <= 1.0 && t < nearest) nearest = t;
+    }
+    return nearest;
+}
+
+} // namespace ev3host
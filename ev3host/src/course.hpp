@@ -0,0 +1,89 @@
+/*
+    course.hpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#ifndef course_hpp
+#define course_hpp
+
+#include <stdint.h>
+#include <vector>
+
+namespace ev3host {
+
+/* raw RGB values as read by the color sensor */
+struct RGB {
+    uint8_t r, g, b;
+};
+
+/* position and heading in the course coordinates:
+   x to the right and y upward in millimeter, heading counterclockwise from the x axis in radian */
+struct Pose {
+    double x, y, heading;
+};
+
+/* geometry of the robot, given in the course file together with the course */
+struct RobotSpec {
+    double tireDiameter;        /* in millimeter */
+    double wheelTread;          /* distance between the wheels in millimeter */
+    int leftMotor, rightMotor;  /* motor_port_t of the wheels */
+    double motorTimeConstant;   /* of the first-order motor model in second */
+    double colorForward, colorLeft, colorRadius;    /* location and footprint of the color sensor from the axle center */
+    double sonarForward, sonarLeft;                 /* location of the sonar from the axle center */
+    RobotSpec();
+};
+
+/*
+    Course is the immutable floor and obstacles the robot runs on.
+    The floor is rasterized from the course file at the given resolution,
+    and the floor color continues without end outside of the raster.
+    The raster is cached in a file under TMPDIR, or /tmp, keyed by the hash of the course file
+    and mapped read-only, so that the processes running on the same course share a copy of it in memory
+    and rasterize it only once.
+    The obstacles are kept as the geometry for the sonar.
+*/
+class Course {
+public:
+    /* a floor of a uniform color without obstacles */
+    explicit Course(RGB floor);
+    /* load the course file, see README.md for the format; the process exits on an error */
+    static Course* load(const char* path, RobotSpec* spec);
+    RGB pixelAt(double x, double y) const;
+    /* average color of the pixels whose center is within the disc */
+    void sample(double x, double y, double radius, double rgb[3]) const;
+    /* distance to the nearest obstacle along the ray, maxRange if nothing within */
+    double raycast(double x, double y, double direction, double maxRange) const;
+    const Pose& start() const { return startPose; }
+    /* distance to the center of the nearest line or arc painted, or -1 if none painted */
+    double distanceToLine(double x, double y) const;
+
+    struct Segment { double x1, y1, x2, y2; };
+    /* whether the move from (x0, y0) to (x1, y1) crosses the segment */
+    static bool crosses(const Segment& s, double x0, double y0, double x1, double y1);
+    const std::vector<Segment>& gates() const { return gateLines; }
+    /* the goal line, valid only if hasGoal() */
+    bool hasGoal() const { return goalGiven; }
+    const Segment& goal() const { return goalLine; }
+private:
+    struct Circle { double x, y, radius; };
+    /* center of a line painted from (x1, y1) to (x2, y2), or of an arc around (x1, y1) if radius is not zero */
+    struct Stroke { double x1, y1, x2, y2, radius, from, to; };
+    double width, height, resolution;  /* in millimeter, millimeter per pixel */
+    int columns, rows;
+    RGB floor;
+    const RGB* pixels;                  /* row-major from the bottom left, either of raster or mapped */
+    std::vector<RGB> raster;            /* painted while loading unless the cache is mapped */
+    bool mapped;
+    std::vector<Circle> bottles;
+    std::vector<Segment> walls;
+    std::vector<Stroke> strokes;
+    std::vector<Segment> gateLines;
+    Segment goalLine;
+    bool goalGiven;
+    Pose startPose;
+    template<typename Inside> void paint(double x0, double y0, double x1, double y1, RGB color, Inside inside);
+};
+
+} // namespace ev3host
+
+#endif /* course_hpp */
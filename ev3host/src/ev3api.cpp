@@ -0,0 +1,335 @@
+/*
+    ev3api.cpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#include "kernel.hpp"
+#include "fault.hpp"
+#include "plant.hpp"
+#include "replay.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+/*
+    EV3 C API on the host.
+    The motors and the sensors are those of the robot simulated by the plant,
+    which gets advanced to the current time on every call.
+    When replaying a log, the wheel encoders and the sensors read the log instead in open loop,
+    a record per read of the raw color, which update_task does once per tick,
+    and the commands to the motors are written to syslog.
+    The faults configured by EV3HOST_FAULTS are injected into the values read either way.
+*/
+namespace {
+
+struct SensorPort {
+    sensor_type_t type;
+};
+
+SensorPort sensors[TNUM_SENSOR_PORT];
+ev3host::Plant* plant = nullptr;
+ev3host::Replay* replay = nullptr;
+int commanded[TNUM_MOTOR_PORT];
+double lastColor[3];
+SYSTIM gyroResetAt = 0;
+
+/* the course of EV3HOST_COURSE, or a white floor without end if not given, with the robot given in it;
+   kept across the fork of the runs in a batch, which share it read-only */
+struct LoadedCourse {
+    std::string path;
+    const ev3host::Course* course;
+    ev3host::RobotSpec spec;
+};
+LoadedCourse* loaded = nullptr;
+
+LoadedCourse* courseNow() {
+    const char* path = getenv("EV3HOST_COURSE");
+    if (path == nullptr) path = "";
+    if (loaded == nullptr || loaded->path != path) {
+        loaded = new LoadedCourse{ path, nullptr, ev3host::RobotSpec() };
+        loaded->course = (*path != '\0') ?
+            ev3host::Course::load(path, &loaded->spec) : new ev3host::Course(ev3host::RGB{ 110, 115, 120 });
+    }
+    return loaded;
+}
+
+/* the plant on the course and the replay of EV3HOST_REPLAY if given */
+ev3host::Plant* plantNow() {
+    if (plant == nullptr) {
+        LoadedCourse* lc = courseNow();
+        plant = new ev3host::Plant(lc->course, lc->spec);
+        const char* path = getenv("EV3HOST_REPLAY");
+        if (path != nullptr && *path != '\0') replay = new ev3host::Replay(path);
+    }
+    plant->advanceTo(ev3host::now());
+    return plant;
+}
+
+/* write the command to the motor to syslog on change when replaying */
+void command(motor_port_t port, int power) {
+    if (replay == nullptr || commanded[port] == power) return;
+    commanded[port] = power;
+    syslog(LOG_INFO, "ev3host: %08llu motor %c power %d", (unsigned long long)ev3host::now(), 'A' + port, power);
+}
+
+ev3host::Plant* motorAt(motor_port_t port) {
+    assert(port >= EV3_PORT_A && port < TNUM_MOTOR_PORT);
+    return plantNow();
+}
+
+ev3host::Plant* sensorAt(sensor_port_t port, sensor_type_t type) {
+    assert(port >= EV3_PORT_1 && port < TNUM_SENSOR_PORT);
+    assert(sensors[port].type == type && "sensor port not configured for the type");
+    return plantNow();
+}
+
+/* the sample of the color sensor as read through the faults */
+void injectColorFaults(double rgb[3]) {
+    /* both drawn on every read so that either stream does not depend on the other */
+    bool stale = ev3host::faults().occurs(ev3host::Faults::COLOR_STALE);
+    bool drop = ev3host::faults().occurs(ev3host::Faults::COLOR_DROP);
+    for (int i = 0; i < 3; i++) {
+        if (stale) {
+            rgb[i] = lastColor[i];
+        } else if (drop) {
+            rgb[i] = 0.0;
+        }
+        lastColor[i] = rgb[i];
+    }
+}
+
+uint8_t clampRaw(double value) {
+    return (value < 0.0) ? 0 : (value > 255.0) ? 255 : (uint8_t)std::lround(value);
+}
+
+} // namespace
+
+void ev3host::preload(void) {
+    courseNow();
+}
+
+/* write the exit code, the system time and the record of the plant to EV3HOST_RESULT if given,
+   and append the summary of the run to EV3HOST_SUMMARY if given */
+void ev3host::finalize(int exitCode) {
+    ev3host::writeSummary(exitCode, *plantNow());
+    const char* path = getenv("EV3HOST_RESULT");
+    if (path == nullptr || *path == '\0') return;
+    FILE* fp = fopen(path, "w");
+    if (fp == nullptr) {
+        syslog(LOG_ERROR, "ev3host: cannot write result to %s", path);
+        return;
+    }
+    fprintf(fp, "EXIT_CODE=%d\n", exitCode);
+    fprintf(fp, "TIME=%llu\n", (unsigned long long)ev3host::now());
+    plantNow()->writeRecord(fp);
+    ev3host::faults().writeRecord(fp);
+    if (replay != nullptr) fprintf(fp, "REPLAYED=%d\n", replay->consumed());
+    fclose(fp);
+}
+
+ER ev3_motor_config(motor_port_t port, motor_type_t type) {
+    if (port < EV3_PORT_A || port >= TNUM_MOTOR_PORT) return E_ID;
+    motorAt(port)->configMotor(port, type);
+    return E_OK;
+}
+
+motor_type_t ev3_motor_get_type(motor_port_t port) {
+    return motorAt(port)->motorType(port);
+}
+
+int32_t ev3_motor_get_counts(motor_port_t port) {
+    ev3host::Plant* plant = motorAt(port);
+    if (replay != nullptr && port == plant->robot().leftMotor) return replay->current().countL;
+    if (replay != nullptr && port == plant->robot().rightMotor) return replay->current().countR;
+    return plant->counts(port);
+}
+
+ER ev3_motor_reset_counts(motor_port_t port) {
+    motorAt(port)->resetCounts(port);
+    return E_OK;
+}
+
+ER ev3_motor_set_power(motor_port_t port, int power) {
+    ev3host::Plant* plant = motorAt(port);
+    if (plant->motorType(port) == NONE_MOTOR) return E_OBJ;
+    plant->setPower(port, power);
+    command(port, plant->power(port));
+    return E_OK;
+}
+
+int ev3_motor_get_power(motor_port_t port) {
+    return motorAt(port)->power(port);
+}
+
+ER ev3_motor_stop(motor_port_t port, bool_t brake) {
+    motorAt(port)->stop(port, brake);
+    command(port, 0);
+    return E_OK;
+}
+
+ER ev3_motor_steer(motor_port_t left_motor, motor_port_t right_motor, int power, int turn_ratio) {
+    int left = power, right = power;
+    if (turn_ratio > 0) {
+        right = power * (100 - 2 * turn_ratio) / 100;
+    } else if (turn_ratio < 0) {
+        left = power * (100 + 2 * turn_ratio) / 100;
+    }
+    ev3_motor_set_power(left_motor, left);
+    ev3_motor_set_power(right_motor, right);
+    return E_OK;
+}
+
+ER ev3_sensor_config(sensor_port_t port, sensor_type_t type) {
+    if (port < EV3_PORT_1 || port >= TNUM_SENSOR_PORT) return E_ID;
+    sensors[port].type = type;
+    if (type == ULTRASONIC_SENSOR && ev3host::faults().occurs(ev3host::Faults::SONAR_BLOCK)) {
+        syslog(LOG_NOTICE, "ev3host: configuring the ultrasonic sensor blocks");
+        dly_tsk(ev3host::faults().sonarBlockTime());
+    }
+    return E_OK;
+}
+
+sensor_type_t ev3_sensor_get_type(sensor_port_t port) {
+    assert(port >= EV3_PORT_1 && port < TNUM_SENSOR_PORT);
+    return sensors[port].type;
+}
+
+colorid_t ev3_color_sensor_get_color(sensor_port_t port) {
+    /* the nearest of the typical raw values of the colors */
+    static const struct { colorid_t id; double rgb[3]; } references[] = {
+        { COLOR_BLACK,  {  10,  11,  14 } },
+        { COLOR_BLUE,   {  22,  60,  90 } },
+        { COLOR_GREEN,  {  35,  70,  45 } },
+        { COLOR_YELLOW, { 115, 105,  50 } },
+        { COLOR_RED,    { 100,  30,  40 } },
+        { COLOR_WHITE,  { 110, 115, 120 } },
+    };
+    double rgb[3];
+    sensorAt(port, COLOR_SENSOR)->sampleColor(rgb);
+    injectColorFaults(rgb);
+    colorid_t nearest = COLOR_NONE;
+    double best = 0.0;
+    for (const auto& ref : references) {
+        double d = 0.0;
+        for (int i = 0; i < 3; i++) {
+            d += (rgb[i] - ref.rgb[i]) * (rgb[i] - ref.rgb[i]);
+        }
+        if (nearest == COLOR_NONE || d < best) {
+            nearest = ref.id;
+            best = d;
+        }
+    }
+    return nearest;
+}
+
+uint8_t ev3_color_sensor_get_reflect(sensor_port_t port) {
+    /* proportional to the red, which is what the sensor emits in the reflect mode */
+    double rgb[3];
+    sensorAt(port, COLOR_SENSOR)->sampleColor(rgb);
+    injectColorFaults(rgb);
+    double reflect = rgb[0] * 100.0 / 180.0;
+    return (reflect > 100.0) ? 100 : (uint8_t)std::lround(reflect);
+}
+
+uint8_t ev3_color_sensor_get_ambient(sensor_port_t port) {
+    sensorAt(port, COLOR_SENSOR);
+    return 10;
+}
+
+void ev3_color_sensor_get_rgb_raw(sensor_port_t port, rgb_raw_t* val) {
+    double rgb[3];
+    sensorAt(port, COLOR_SENSOR)->sampleColor(rgb);
+    if (replay != nullptr) {
+        if (!replay->next()) {
+            syslog(LOG_NOTICE, "ev3host: replay finished");
+            ev3host::stop(0);
+        }
+        for (int i = 0; i < 3; i++) rgb[i] = replay->current().rgb[i];
+    }
+    injectColorFaults(rgb);
+    val->r = clampRaw(rgb[0]);
+    val->g = clampRaw(rgb[1]);
+    val->b = clampRaw(rgb[2]);
+}
+
+int16_t ev3_gyro_sensor_get_angle(sensor_port_t port) {
+    ev3host::Plant* plant = sensorAt(port, GYRO_SENSOR);
+    int16_t angle = (replay != nullptr) ? replay->current().gyro : plant->gyroAngle();
+    return angle + (int16_t)std::lround(ev3host::faults().gyroDrift() * (ev3host::now() - gyroResetAt) / 1000000.0);
+}
+
+int16_t ev3_gyro_sensor_get_rate(sensor_port_t port) {
+    return sensorAt(port, GYRO_SENSOR)->gyroRate() + (int16_t)std::lround(ev3host::faults().gyroOffset());
+}
+
+ER ev3_gyro_sensor_reset(sensor_port_t port) {
+    sensorAt(port, GYRO_SENSOR)->resetGyro();
+    gyroResetAt = ev3host::now();
+    return E_OK;
+}
+
+int16_t ev3_ultrasonic_sensor_get_distance(sensor_port_t port) {
+    ev3host::Plant* plant = sensorAt(port, ULTRASONIC_SENSOR);
+    if (ev3host::faults().occurs(ev3host::Faults::SONAR_TIMEOUT)) return 255;
+    return (replay != nullptr) ? replay->current().sonar : plant->sonarDistance();
+}
+
+bool_t ev3_ultrasonic_sensor_listen(sensor_port_t port) {
+    sensorAt(port, ULTRASONIC_SENSOR);
+    return false;
+}
+
+bool_t ev3_touch_sensor_is_pressed(sensor_port_t port) {
+    sensorAt(port, TOUCH_SENSOR);
+    return false;
+}
+
+bool_t ev3_button_is_pressed(button_t button) {
+    return false;
+}
+
+ER ev3_led_set_color(ledcolor_t color) {
+    static const char* names[] = { "OFF", "RED", "GREEN", "ORANGE" };
+    syslog(LOG_INFO, "ev3host: LED %s", names[color & 3]);
+    return E_OK;
+}
+
+int ev3_battery_voltage_mV(void) {
+    return 8000;
+}
+
+int ev3_battery_current_mA(void) {
+    return 200;
+}
+
+ER ev3_speaker_set_volume(uint8_t volume) {
+    return E_OK;
+}
+
+ER ev3_speaker_play_tone(uint16_t frequency, int32_t duration) {
+    return E_OK;
+}
+
+ER ev3_lcd_set_font(lcdfont_t font) {
+    return E_OK;
+}
+
+ER ev3_lcd_draw_string(const char* str, int32_t x, int32_t y) {
+    syslog(LOG_INFO, "ev3host: LCD (%d,%d) %s", x, y, str);
+    return E_OK;
+}
+
+ER ev3_lcd_fill_rect(int32_t x, int32_t y, int32_t w, int32_t h, lcdcolor_t color) {
+    return E_OK;
+}
+
+/* the serial ports, including Bluetooth, are connected to stdout */
+FILE* ev3_serial_open_file(serial_port_t port) {
+    return fdopen(dup(STDOUT_FILENO), "a");
+}
+
+bool_t ev3_bluetooth_is_connected(void) {
+    return false;
+}
@@ -0,0 +1,121 @@
+/*
+    fault.cpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#include "fault.hpp"
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+namespace ev3host {
+
+namespace {
+
+const char* const names[Faults::NUM_KINDS] = {
+    "color_drop", "color_stale", "sonar_timeout", "sonar_block", "encoder_slip", "cyc_delay"
+};
+
+/* SplitMix64, small and the same on every platform unlike the distributions of <random> */
+uint64_t splitmix(uint64_t* state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+void invalid(const std::string& item) {
+    syslog(LOG_ERROR, "ev3host: invalid fault %s in EV3HOST_FAULTS", item.c_str());
+    exit(2);
+}
+
+} // namespace
+
+Faults::Faults(void) : active(false), qovr(0), drift(0.0), offset(0.0), traction(0.3),
+    sonarBlock(2000000), cycDelay(30000), slip(200000) {
+    for (int k = 0; k < NUM_KINDS; k++) {
+        probability[k] = 0.0;
+        count[k] = 0;
+    }
+    const char* spec = getenv("EV3HOST_FAULTS");
+    uint64_t seed = 1;
+    std::istringstream items((spec != nullptr) ? spec : "");
+    for (std::string item; std::getline(items, item, ',');) {
+        if (item.empty()) continue;
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) invalid(item);
+        std::string key = item.substr(0, eq);
+        char* end;
+        double value = strtod(item.c_str() + eq + 1, &end);
+        if (*end != '\0' || value < 0.0) invalid(item);
+        bool known = true;
+        if (key == "seed") {
+            seed = (uint64_t)value;
+        } else if (key == "gyro_drift") {
+            drift = value;
+        } else if (key == "gyro_offset") {
+            offset = value;
+        } else if (key == "sonar_block_ms") {
+            sonarBlock = (RELTIM)(value * 1000.0);
+        } else if (key == "slip_traction") {
+            traction = value;
+        } else if (key == "slip_ms") {
+            slip = (SYSTIM)(value * 1000.0);
+        } else if (key == "cyc_delay_ms") {
+            cycDelay = (RELTIM)(value * 1000.0);
+        } else {
+            known = false;
+            for (int k = 0; k < NUM_KINDS; k++) {
+                if (key == names[k]) {
+                    probability[k] = value;
+                    known = true;
+                }
+            }
+        }
+        if (!known) invalid(item);
+        active = true;
+    }
+    for (int k = 0; k < NUM_KINDS; k++) {
+        stream[k] = seed * (NUM_KINDS + 1) + k;
+    }
+    uint64_t sign = seed;
+    if (splitmix(&sign) & 1) drift = -drift;
+    if (active) syslog(LOG_NOTICE, "ev3host: injecting faults %s", spec);
+}
+
+double Faults::draw(Kind kind) {
+    return (splitmix(&stream[kind]) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+bool Faults::occurs(Kind kind) {
+    if (probability[kind] <= 0.0 || draw(kind) >= probability[kind]) return false;
+    count[kind]++;
+    return true;
+}
+
+bool Faults::occursWithin(Kind kind, double interval) {
+    /* the probability of an event or more of the Poisson process within the interval */
+    if (probability[kind] <= 0.0 || draw(kind) >= 1.0 - std::exp(-probability[kind] * interval)) return false;
+    count[kind]++;
+    return true;
+}
+
+void Faults::writeRecord(FILE* fp) const {
+    for (int k = 0; k < NUM_KINDS; k++) {
+        std::string key = "FAULT_";
+        for (const char* p = names[k]; *p != '\0'; p++) key += (char)toupper(*p);
+        fprintf(fp, "%s=%d\n", key.c_str(), count[k]);
+    }
+    fprintf(fp, "QOVR=%d\n", qovr);
+}
+
+Faults& faults(void) {
+    static Faults instance;
+    return instance;
+}
+
+} // namespace ev3host
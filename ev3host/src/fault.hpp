@@ -0,0 +1,76 @@
+/*
+    fault.hpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#ifndef fault_hpp
+#define fault_hpp
+
+#include "ev3api.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+namespace ev3host {
+
+/*
+    Faults injects the failures seen on the real course into the stand-ins of the sensors, the plant and the kernel,
+    as configured by EV3HOST_FAULTS, a list of key=value separated by commas, e.g.
+        seed=7,color_drop=0.01,sonar_timeout=0.1,cyc_delay=0.002
+    keys:
+        seed            seed of the random streams (default 1)
+        color_drop      probability per read of the color sensor that the sample is dropped, i.e. reads zero
+        color_stale     probability per read of the color sensor that the previous sample is read again
+        gyro_drift      drift of the gyro angle since the reset in degree per second, of the sign drawn by the seed
+        gyro_offset     offset of the gyro rate in degree per second
+        sonar_timeout   probability per read of the ultrasonic sensor that the echo times out, i.e. reads 255
+        sonar_block     probability that configuring the ultrasonic sensor blocks for sonar_block_ms (default 2000)
+        encoder_slip    slips per second of each wheel, during which the wheel keeps turning
+                        at slip_traction (default 0.3) of its grip for slip_ms (default 200)
+        cyc_delay       probability per activation of a cyclic notification that it is held back for cyc_delay_ms
+                        (default 30), after which the notifications due are made at once, hence E_QOVR
+    Each fault draws from a random stream of its own seeded by the seed,
+    so that a run is reproducible for the seed and enabling a fault does not move when the others occur.
+*/
+class Faults {
+public:
+    enum Kind { COLOR_DROP, COLOR_STALE, SONAR_TIMEOUT, SONAR_BLOCK, ENCODER_SLIP, CYC_DELAY, NUM_KINDS };
+
+    /* load EV3HOST_FAULTS; the process exits on an error */
+    Faults(void);
+    bool enabled(void) const { return active; }
+    /* draw whether the fault occurs on an event of the kind, and count it if so */
+    bool occurs(Kind kind);
+    /* draw whether the fault occurs within the interval in second, given its rate per second */
+    bool occursWithin(Kind kind, double interval);
+
+    double gyroDrift(void) const { return drift; }
+    double gyroOffset(void) const { return offset; }
+    RELTIM sonarBlockTime(void) const { return sonarBlock; }
+    double slipTraction(void) const { return traction; }
+    SYSTIM slipTime(void) const { return slip; }
+    RELTIM cyclicDelay(void) const { return cycDelay; }
+
+    /* count an activation of a task lost to E_QOVR, as the consequence of the faults */
+    void overrun(void) { qovr++; }
+    int overruns(void) const { return qovr; }
+    /* write the counts of the faults occurred as key=value lines like profile.txt */
+    void writeRecord(FILE* fp) const;
+private:
+    bool active;
+    double probability[NUM_KINDS];
+    uint64_t stream[NUM_KINDS];
+    int count[NUM_KINDS];
+    int qovr;
+    double drift, offset, traction;
+    RELTIM sonarBlock, cycDelay;
+    SYSTIM slip;
+    double draw(Kind kind);
+};
+
+/* the faults of the run, loaded on the first call */
+Faults& faults(void);
+
+} // namespace ev3host
+
+#endif /* fault_hpp */
@@ -0,0 +1,585 @@
+/*
+    kernel.cpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#include "kernel.hpp"
+#include "fault.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*
+    The host kernel emulates a uniprocessor TOPPERS kernel by threads.
+    Each task runs on its own thread but only the one designated as running may execute,
+    as the running task holds the big lock while executing the app code.
+    The lock is released only when the running task waits in a service call or terminates,
+    which is where dispatching takes place, i.e. preemption is deferred until the next service call.
+    Cyclic notifications and timeouts are processed by the timer thread holding the same lock.
+    A cyclic notification may be held back by the fault injection, see fault.hpp.
+    On the virtual clock, the time advances only when all tasks are waiting, directly to the next event,
+    hence the tasks take no time to execute and a run is reproducible regardless of the host load.
+*/
+namespace {
+
+enum TaskState { DORMANT, READY, WAITING };
+
+struct Task {
+    ID id;
+    const char* name;
+    T_CTSK ctsk;
+    TaskState state;
+    int actcnt, wupcnt;
+    bool sleeping;          /* waiting in slp_tsk/tslp_tsk, otherwise in dly_tsk */
+    SYSTIM wakeAt;          /* NEVER for no timeout */
+    ER waitResult;
+    uint64_t readySeq;      /* FIFO order among the tasks of the same priority */
+    std::condition_variable cv;
+    std::thread thread;
+};
+
+struct Cyclic {
+    ID id;
+    const char* name;
+    T_CCYC ccyc;
+    bool started;
+    SYSTIM next;
+    bool held;              /* the notification due at next is held back until heldUntil */
+    SYSTIM heldUntil;
+    SYSTIM releasedAt;      /* when the notifications last held back were made */
+};
+
+/* thrown to unwind the task function on ext_tsk() */
+struct TaskExit {};
+/* thrown to unwind the task function on the kernel shutdown */
+struct TaskKill {};
+
+const SYSTIM NEVER = UINT64_MAX;
+
+std::mutex big;
+std::condition_variable timerCv, doneCv;
+std::vector<Task*> tasks;
+std::vector<Cyclic*> cyclics;
+Task* running = nullptr;
+uint64_t seqCounter = 0;
+bool finished = false, shutdown = false;
+int exitCode = 0;
+thread_local Task* self = nullptr;  /* nullptr in the timer thread, i.e. in the handler context */
+thread_local std::unique_lock<std::mutex> selfLock;    /* the big lock held by the calling task */
+
+bool virtualClock = true;
+SYSTIM virtualTime = 0;
+double speed = 1.0;
+SYSTIM timeout = NEVER;
+std::chrono::steady_clock::time_point epoch;
+
+std::vector<ev3host::Configurator::Function>& configurators() {
+    static std::vector<ev3host::Configurator::Function> functions;
+    return functions;
+}
+
+Task* findTask(ID id) {
+    if (id == TSK_SELF) return self;
+    if (id < 1 || id > (ID)tasks.size()) return nullptr;
+    return tasks[id - 1];
+}
+
+Cyclic* findCyclic(ID id) {
+    if (id < 1 || id > (ID)cyclics.size()) return nullptr;
+    return cyclics[id - 1];
+}
+
+void finish(int code) {
+    if (!finished) {
+        finished = true;
+        exitCode = code;
+        doneCv.notify_all();
+    }
+}
+
+void makeReady(Task* t, ER result) {
+    t->state = READY;
+    t->waitResult = result;
+    t->readySeq = seqCounter++;
+}
+
+Task* highest() {
+    Task* top = nullptr;
+    for (auto t : tasks) {
+        if (t->state == READY &&
+            (top == nullptr || t->ctsk.itskpri < top->ctsk.itskpri ||
+             (t->ctsk.itskpri == top->ctsk.itskpri && t->readySeq < top->readySeq))) {
+            top = t;
+        }
+    }
+    return top;
+}
+
+/* designate the highest priority task as running, to be called with the big lock held */
+void dispatch() {
+    running = highest();
+    if (running != nullptr) {
+        running->cv.notify_one();
+    }
+    timerCv.notify_one();
+}
+
+/* let the calling task wait until it gets designated as running again */
+ER block() {
+    dispatch();
+    self->cv.wait(selfLock, [] { return running == self || shutdown; });
+    if (shutdown) throw TaskKill();
+    return self->waitResult;
+}
+
+/* dispatch if a task of higher priority than the calling task has become ready */
+void preempt() {
+    if (self == nullptr) return;    /* the timer thread dispatches after the handler returns */
+    Task* top = highest();
+    if (top != self) {
+        block();
+    }
+}
+
+/* TOPPERS service calls are issued with the big lock held by the calling task or the timer thread */
+ER activate(Task* t) {
+    if (t->state == DORMANT) {
+        makeReady(t, E_OK);
+        return E_OK;
+    }
+    if (t->actcnt < 1) {
+        t->actcnt++;
+        return E_OK;
+    }
+    return E_QOVR;
+}
+
+ER wakeup(Task* t) {
+    if (t->state == DORMANT) return E_OBJ;
+    if (t->state == WAITING && t->sleeping) {
+        makeReady(t, E_OK);
+        return E_OK;
+    }
+    if (t->wupcnt < 1) {
+        t->wupcnt++;
+        return E_OK;
+    }
+    return E_QOVR;
+}
+
+void notify(const T_NFYINFO& nfy) {
+    ER ercd = E_OK;
+    switch (nfy.nfymode & 0x0fU) {
+    case TNFY_HANDLER:
+        nfy.handler(nfy.par);
+        break;
+    case TNFY_SETVAR:
+        *nfy.var = nfy.value;
+        break;
+    case TNFY_INCVAR:
+        (*nfy.var)++;
+        break;
+    case TNFY_ACTTSK:
+        ercd = act_tsk((ID)nfy.par);
+        if (ercd == E_QOVR) ev3host::faults().overrun();
+        break;
+    case TNFY_WUPTSK:
+        ercd = wup_tsk((ID)nfy.par);
+        break;
+    }
+    if (ercd != E_OK && nfy.errvar != nullptr) {
+        if (nfy.nfymode & TENFY_SETVAR) {
+            *nfy.errvar = ercd;
+        } else if (nfy.nfymode & TENFY_INCVAR) {
+            (*nfy.errvar)++;
+        }
+    }
+}
+
+void taskMain(Task* t) {
+    selfLock = std::unique_lock<std::mutex>(big);
+    self = t;
+    for (;;) {
+        t->cv.wait(selfLock, [t] { return running == t || shutdown; });
+        if (shutdown) return;
+        try {
+            t->ctsk.task(t->ctsk.exinf);
+        } catch (TaskExit&) {
+        } catch (TaskKill&) {
+            return;
+        }
+        /* the task has terminated, get it activated again if queued */
+        t->wupcnt = 0;
+        if (t->actcnt > 0) {
+            t->actcnt--;
+            makeReady(t, E_OK);
+        } else {
+            t->state = DORMANT;
+        }
+        dispatch();
+    }
+}
+
+std::chrono::steady_clock::time_point realTimeOf(SYSTIM time) {
+    return epoch + std::chrono::microseconds((int64_t)(time / speed));
+}
+
+void timerMain() {
+    std::unique_lock<std::mutex> lk(big);
+    while (!finished) {
+        if (virtualClock) {
+            /* the virtual time stands still while any task is ready */
+            timerCv.wait(lk, [] { return running == nullptr || finished; });
+            if (finished) break;
+        }
+        SYSTIM time = ev3host::now();
+        SYSTIM next = timeout;
+        if (time >= timeout) {
+            syslog(LOG_NOTICE, "ev3host: timed out at %llu usec", (unsigned long long)time);
+            finish(124);
+            break;
+        }
+        for (auto c : cyclics) {
+            if (!c->started) continue;
+            while (c->started && c->next <= time) {
+                /* the notifications overdue behind one held back are not held back again */
+                if (!c->held && c->next >= c->releasedAt && ev3host::faults().occurs(ev3host::Faults::CYC_DELAY)) {
+                    c->held = true;
+                    c->heldUntil = c->next + ev3host::faults().cyclicDelay();
+                }
+                if (c->held) {
+                    if (c->heldUntil > time) break;
+                    c->held = false;
+                    c->releasedAt = c->heldUntil;
+                }
+                c->next += c->ccyc.cyctim;
+                notify(c->ccyc.nfyinfo);
+            }
+            SYSTIM due = c->held ? c->heldUntil : c->next;
+            if (c->started && due < next) next = due;
+        }
+        for (auto t : tasks) {
+            if (t->state != WAITING) continue;
+            if (t->wakeAt <= time) {
+                makeReady(t, t->sleeping ? E_TMOUT : E_OK);
+            } else if (t->wakeAt < next) {
+                next = t->wakeAt;
+            }
+        }
+        dispatch();
+        if (running == nullptr) {
+            bool active = false, waiting = false;
+            for (auto c : cyclics) active = active || c->started;
+            for (auto t : tasks) {
+                active = active || (t->state == WAITING && t->wakeAt != NEVER);
+                waiting = waiting || (t->state == WAITING);
+            }
+            if (!active) {
+                /* nothing will ever happen */
+                if (waiting) syslog(LOG_NOTICE, "ev3host: all tasks are waiting forever");
+                finish(waiting ? 3 : 0);
+                break;
+            }
+        }
+        if (virtualClock) {
+            /* jump to the next event when all tasks are waiting,
+               otherwise the events are looked up again after the ready tasks have run */
+            if (running == nullptr) virtualTime = next;
+        } else if (next == NEVER) {
+            timerCv.wait(lk);
+        } else {
+            timerCv.wait_until(lk, realTimeOf(next));
+        }
+    }
+}
+
+double envAsDouble(const char* name, double defaultValue) {
+    const char* value = getenv(name);
+    return (value != nullptr && *value != '\0') ? atof(value) : defaultValue;
+}
+
+/*
+    Run the batch of EV3HOST_BATCH, a run per line of the working directory and the environment variables
+    to add, separated by tabs, as many at a time as EV3HOST_JOBS (default the number of cores).
+    Each run is forked from this process after the course has been loaded, hence shares it read-only,
+    and starts the kernel in its working directory with its output to log.txt there.
+    Returns true in the forked run, or false in this process after all runs have exited.
+*/
+bool forkBatch(const char* path) {
+    std::ifstream in(path);
+    if (!in) {
+        syslog(LOG_ERROR, "ev3host: cannot open batch %s", path);
+        exit(2);
+    }
+    std::vector<std::vector<std::string> > runs;
+    for (std::string line; std::getline(in, line);) {
+        std::vector<std::string> fields;
+        std::istringstream tokens(line);
+        for (std::string field; std::getline(tokens, field, '\t');) fields.push_back(field);
+        if (!fields.empty() && !fields[0].empty()) runs.push_back(fields);
+    }
+    int jobs = (int)envAsDouble("EV3HOST_JOBS", std::thread::hardware_concurrency());
+    if (jobs < 1) jobs = 1;
+    ev3host::preload();
+    fflush(nullptr);
+
+    std::map<pid_t, size_t> running;
+    size_t next = 0;
+    while (next < runs.size() || !running.empty()) {
+        while (next < runs.size() && (int)running.size() < jobs) {
+            const auto& run = runs[next];
+            pid_t pid = fork();
+            if (pid == 0) {
+                int fd = open((run[0] + "/log.txt").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                if (fd < 0 || chdir(run[0].c_str()) != 0) _exit(127);
+                dup2(fd, STDOUT_FILENO);
+                dup2(fd, STDERR_FILENO);
+                close(fd);
+                unsetenv("EV3HOST_BATCH");
+                for (size_t i = 1; i < run.size(); i++) {
+                    size_t eq = run[i].find('=');
+                    if (eq != std::string::npos) setenv(run[i].substr(0, eq).c_str(), run[i].c_str() + eq + 1, 1);
+                }
+                return true;
+            }
+            if (pid < 0) {
+                syslog(LOG_ERROR, "ev3host: cannot fork the run in %s", run[0].c_str());
+            } else {
+                running[pid] = next;
+            }
+            next++;
+        }
+        int status;
+        pid_t pid = wait(&status);
+        if (pid < 0) break;
+        auto it = running.find(pid);
+        if (it == running.end()) continue;
+        if (WIFSIGNALED(status)) {
+            syslog(LOG_ERROR, "ev3host: the run in %s killed by signal %d", runs[it->second][0].c_str(), WTERMSIG(status));
+        }
+        running.erase(it);
+    }
+    return false;
+}
+
+} // namespace
+
+namespace ev3host {
+
+void creTsk(ID id, const char* name, const T_CTSK& ctsk) {
+    assert(id == (ID)tasks.size() + 1 && "IDs in kernel_cfg.h do not match app.cfg");
+    Task* t = new Task();
+    t->id = id;
+    t->name = name;
+    t->ctsk = ctsk;
+    t->state = DORMANT;
+    t->actcnt = t->wupcnt = 0;
+    t->sleeping = false;
+    t->wakeAt = NEVER;
+    t->waitResult = E_OK;
+    t->readySeq = 0;
+    tasks.push_back(t);
+}
+
+void creCyc(ID id, const char* name, const T_CCYC& ccyc) {
+    assert(id == (ID)cyclics.size() + 1 && "IDs in kernel_cfg.h do not match app.cfg");
+    assert(ccyc.cyctim > 0);
+    cyclics.push_back(new Cyclic{ id, name, ccyc, false, 0, false, 0, 0 });
+}
+
+void creEv3Cyc(ID id, const char* name, const T_EV3CYC& cyc) {
+    creCyc(id, name, T_CCYC{ cyc.cycatr, T_NFYINFO(TNFY_HANDLER, cyc.exinf, cyc.cychdr), cyc.cyctim, cyc.cycphs });
+}
+
+void stop(int exitCode) {
+    finish(exitCode);
+}
+
+Configurator::Configurator(Function f) {
+    configurators().push_back(f);
+}
+
+void Configurator::configureAll(void) {
+    for (auto f : configurators()) {
+        f();
+    }
+}
+
+SYSTIM now(void) {
+    if (virtualClock) return virtualTime;
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch);
+    return (SYSTIM)(elapsed.count() * speed);
+}
+
+} // namespace ev3host
+
+/*
+    TOPPERS kernel service calls
+*/
+ER act_tsk(ID tskid) {
+    Task* t = findTask(tskid);
+    if (t == nullptr) return E_ID;
+    ER ercd = activate(t);
+    preempt();
+    return ercd;
+}
+
+ER wup_tsk(ID tskid) {
+    Task* t = findTask(tskid);
+    if (t == nullptr) return E_ID;
+    ER ercd = wakeup(t);
+    preempt();
+    return ercd;
+}
+
+ER tslp_tsk(TMO tmout) {
+    if (self == nullptr) return E_CTX;
+    if (self->wupcnt > 0) {
+        self->wupcnt--;
+        return E_OK;
+    }
+    if (tmout == TMO_POL) return E_TMOUT;
+    self->state = WAITING;
+    self->sleeping = true;
+    self->wakeAt = (tmout == TMO_FEVR) ? NEVER : ev3host::now() + tmout;
+    return block();
+}
+
+ER slp_tsk(void) {
+    return tslp_tsk(TMO_FEVR);
+}
+
+ER dly_tsk(RELTIM dlytim) {
+    if (self == nullptr) return E_CTX;
+    self->state = WAITING;
+    self->sleeping = false;
+    self->wakeAt = ev3host::now() + dlytim;
+    return block();
+}
+
+void ext_tsk(void) {
+    assert(self != nullptr && "ext_tsk() called from non-task context");
+    throw TaskExit();
+}
+
+ER get_tid(ID* p_tskid) {
+    *p_tskid = (self != nullptr) ? self->id : 0;
+    return E_OK;
+}
+
+ER sta_cyc(ID cycid) {
+    Cyclic* c = findCyclic(cycid);
+    if (c == nullptr) return E_ID;
+    c->started = true;
+    c->next = ev3host::now() + c->ccyc.cycphs;
+    c->held = false;
+    c->releasedAt = 0;
+    timerCv.notify_one();
+    return E_OK;
+}
+
+ER stp_cyc(ID cycid) {
+    Cyclic* c = findCyclic(cycid);
+    if (c == nullptr) return E_ID;
+    c->started = false;
+    return E_OK;
+}
+
+ER ev3_sta_cyc(ID cycid) {
+    return sta_cyc(cycid);
+}
+
+ER ev3_stp_cyc(ID cycid) {
+    return stp_cyc(cycid);
+}
+
+ER get_tim(SYSTIM* p_systim) {
+    *p_systim = ev3host::now();
+    return E_OK;
+}
+
+HRTCNT fch_hrt(void) {
+    return (HRTCNT)ev3host::now();
+}
+
+void syslog(unsigned int prio, const char* format, ...) {
+    va_list ap;
+    va_start(ap, format);
+    vfprintf(stderr, format, ap);
+    va_end(ap);
+    fputc('\n', stderr);
+}
+
+/*
+    The host process runs the kernel until all tasks terminate with no cyclic notification started.
+    environment variables:
+        EV3HOST_SPEED   ratio of the system time to the real time, e.g. 10 to run 10 times faster,
+                        or 0 for the virtual time (default 0)
+        EV3HOST_TIMEOUT limit of the system time in second, the process exits with 124 when reached (default none)
+        EV3HOST_COURSE  course file for the plant, see ev3api.cpp
+        EV3HOST_RESULT  file to write the result of the run into, see ev3api.cpp
+        EV3HOST_SUMMARY file to append the summary of the run to, see summary.hpp
+        EV3HOST_LABEL   label of the run in the summary
+        EV3HOST_REPLAY  log of a run to replay the sensors of, see ev3api.cpp
+        EV3HOST_FAULTS  faults to inject, see fault.hpp
+        EV3HOST_BATCH   batch of runs to fork, see forkBatch()
+*/
+int main(int argc, char* argv[]) {
+    const char* batch = getenv("EV3HOST_BATCH");
+    if (batch != nullptr && *batch != '\0' && !forkBatch(batch)) return 0;
+
+    speed = envAsDouble("EV3HOST_SPEED", 0.0);
+    assert(speed >= 0.0);
+    virtualClock = (speed == 0.0);
+    double limit = envAsDouble("EV3HOST_TIMEOUT", 0.0);
+    if (limit > 0.0) timeout = (SYSTIM)(limit * 1000000.0);
+    epoch = std::chrono::steady_clock::now();
+    ev3host::faults();
+
+    ev3host::Configurator::configureAll();
+
+    std::unique_lock<std::mutex> lk(big);
+    for (auto t : tasks) {
+        if (t->ctsk.tskatr & TA_ACT) makeReady(t, E_OK);
+        t->thread = std::thread(taskMain, t);
+    }
+    for (auto c : cyclics) {
+        if (c->ccyc.cycatr & TA_STA) sta_cyc(c->id);
+    }
+    std::thread timer(timerMain);
+    dispatch();
+    doneCv.wait(lk, [] { return finished; });
+
+    /* unwind the tasks waiting in service calls and let the threads go */
+    shutdown = true;
+    for (auto t : tasks) {
+        t->cv.notify_all();
+    }
+    timerCv.notify_all();
+    lk.unlock();
+    timer.join();
+    for (auto t : tasks) {
+        t->thread.join();
+        delete t;
+    }
+    for (auto c : cyclics) {
+        delete c;
+    }
+    fflush(stdout);
+    ev3host::finalize(exitCode);
+    return exitCode;
+}
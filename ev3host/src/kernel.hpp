@@ -0,0 +1,87 @@
+/*
+    kernel.hpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#ifndef kernel_hpp
+#define kernel_hpp
+
+#include "ev3api.h"
+
+/* task creation information as given to CRE_TSK in app.cfg */
+struct T_CTSK {
+    ATR         tskatr;
+    intptr_t    exinf;
+    TASK        task;
+    PRI         itskpri;
+    size_t      stksz;
+    void*       stk;
+};
+
+/* notification information as given to CRE_CYC in app.cfg */
+struct T_NFYINFO {
+    MODE        nfymode;
+    intptr_t    par;        /* task ID for TNFY_ACTTSK/TNFY_WUPTSK, exinf for TNFY_HANDLER */
+    NFYHDR      handler;    /* for TNFY_HANDLER */
+    intptr_t*   var;        /* for TNFY_SETVAR/TNFY_INCVAR */
+    intptr_t    value;      /* for TNFY_SETVAR */
+    intptr_t*   errvar;     /* for TENFY_SETVAR/TENFY_INCVAR */
+
+    T_NFYINFO(MODE m, intptr_t p) : nfymode(m), par(p), handler(nullptr), var(nullptr), value(0), errvar(nullptr) {}
+    T_NFYINFO(MODE m, intptr_t p, intptr_t* e) : nfymode(m), par(p), handler(nullptr), var(nullptr), value(0), errvar(e) {}
+    T_NFYINFO(MODE m, intptr_t p, NFYHDR h) : nfymode(m), par(p), handler(h), var(nullptr), value(0), errvar(nullptr) {}
+    T_NFYINFO(MODE m, intptr_t* v) : nfymode(m), par(0), handler(nullptr), var(v), value(0), errvar(nullptr) {}
+    T_NFYINFO(MODE m, intptr_t* v, intptr_t val) : nfymode(m), par(0), handler(nullptr), var(v), value(val), errvar(nullptr) {}
+};
+
+/* cyclic notification creation information as given to CRE_CYC in app.cfg */
+struct T_CCYC {
+    ATR         cycatr;
+    T_NFYINFO   nfyinfo;
+    RELTIM      cyctim;
+    RELTIM      cycphs;
+};
+
+/* cyclic handler creation information as given to EV3_CRE_CYC in app.cfg of the former EV3RT */
+struct T_EV3CYC {
+    ATR         cycatr;
+    intptr_t    exinf;
+    NFYHDR      cychdr;
+    RELTIM      cyctim;
+    RELTIM      cycphs;
+};
+
+namespace ev3host {
+
+/* registration of the objects in app.cfg, called by the configurator in appcfg.cpp */
+void creTsk(ID id, const char* name, const T_CTSK& ctsk);
+void creCyc(ID id, const char* name, const T_CCYC& ccyc);
+void creEv3Cyc(ID id, const char* name, const T_EV3CYC& cyc);
+
+/* a configurator per DOMAIN block in app.cfg, run by the kernel at start */
+class Configurator {
+public:
+    typedef void (*Function)(void);
+    Configurator(Function f);
+    static void configureAll(void);
+};
+
+/* end the run with the exit code, taking effect at the next service call of the calling task */
+void stop(int exitCode);
+
+/* called by the kernel before forking the runs of a batch, to load what the runs share read-only */
+void preload(void);
+
+/* called by the kernel at the exit of the process, after all tasks have been unwound */
+void finalize(int exitCode);
+
+/* append the summary of the run on the plant to EV3HOST_SUMMARY if given, called by finalize(), see summary.hpp */
+class Plant;
+void writeSummary(int exitCode, const Plant& plant);
+
+/* the system time in microsecond since the kernel started, either virtual or scaled by EV3HOST_SPEED */
+SYSTIM now(void);
+
+} // namespace ev3host
+
+#endif /* kernel_hpp */
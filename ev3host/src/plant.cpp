@@ -0,0 +1,173 @@
+/*
+    plant.cpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#include "plant.hpp"
+#include "fault.hpp"
+
+#include <cmath>
+
+namespace ev3host {
+
+namespace {
+
+/* no-load speed at the full power in degree per second */
+const double SPEED_LARGE_MOTOR  = 1020.0;   /* 170 rpm */
+const double SPEED_MEDIUM_MOTOR = 1440.0;   /* 240 rpm */
+/* a coasting motor slows down this many times slower than a braked one */
+const double COAST_FACTOR = 5.0;
+
+/* the beam of the ultrasonic sensor */
+const double SONAR_HALF_ANGLE = 15.0 * M_PI / 180.0;
+const int    SONAR_RAYS = 13;
+const double SONAR_RANGE = 2550.0;  /* in millimeter */
+
+} // namespace
+
+Plant::Plant(const Course* course, const RobotSpec& spec)
+ : course(course), spec(spec), state(course->start()), gyroOffset(state.heading), turnRate(0.0), time(0),
+   rec{ 0, 0, 0.0, 0.0, 0.0, 0, 0.0, 0.0 }, gateTime(course->gates().size(), 0) {
+    for (auto& m : motors) {
+        m = MotorState{ NONE_MOTOR, 0, true, 0.0, 0.0, 0.0, 0 };
+    }
+}
+
+void Plant::step(double dt) {
+    for (auto& m : motors) {
+        if (m.type == NONE_MOTOR) continue;
+        double fullSpeed = (m.type == MEDIUM_MOTOR) ? SPEED_MEDIUM_MOTOR : SPEED_LARGE_MOTOR;
+        double tau = spec.motorTimeConstant * ((m.power == 0 && !m.brake) ? COAST_FACTOR : 1.0);
+        /* exact discretization of the first-order lag for the step */
+        m.speed += (fullSpeed * m.power / 100.0 - m.speed) * (1.0 - std::exp(-dt / tau));
+        m.counts += m.speed * dt;
+    }
+    double vl = wheelSpeed(spec.leftMotor, dt);
+    double vr = wheelSpeed(spec.rightMotor, dt);
+    double v = (vl + vr) / 2.0;
+    turnRate = (vr - vl) / spec.wheelTread;
+    /* midpoint rule along the arc */
+    double mid = state.heading + turnRate * dt / 2.0;
+    double x0 = state.x, y0 = state.y;
+    state.x += v * dt * std::cos(mid);
+    state.y += v * dt * std::sin(mid);
+    state.heading += turnRate * dt;
+    if (rec.lapTime == 0) recordStep(x0, y0);
+}
+
+double Plant::wheelSpeed(int port, double dt) {
+    MotorState& m = motors[port];
+    if (time >= m.slipUntil && faults().occursWithin(Faults::ENCODER_SLIP, dt)) {
+        m.slipUntil = time + faults().slipTime();
+    }
+    /* the encoder counts the turn of the wheel whether it grips the floor or not */
+    double grip = (time < m.slipUntil) ? faults().slipTraction() : 1.0;
+    return m.speed * M_PI / 180.0 * spec.tireDiameter / 2.0 * grip;
+}
+
+void Plant::recordStep(double x0, double y0) {
+    rec.distance += std::hypot(state.x - x0, state.y - y0);
+    rec.energy += (std::abs(motors[spec.leftMotor].power) + std::abs(motors[spec.rightMotor].power)) * PLANT_STEP / 1000000.0;
+    const auto& gates = course->gates();
+    for (size_t i = 0; i < gates.size(); i++) {
+        if (gateTime[i] == 0 && Course::crosses(gates[i], x0, y0, state.x, state.y)) {
+            gateTime[i] = time + PLANT_STEP;
+            rec.gatesPassed++;
+        }
+    }
+    double x, y;
+    sensorPosition(spec.colorForward, spec.colorLeft, &x, &y);
+    double d = course->distanceToLine(x, y);
+    if (d > rec.maxCrossTrack) rec.maxCrossTrack = d;
+    if (d >= 0.0) {
+        rec.sumCrossTrack += d;
+        rec.sumSqCrossTrack += d * d;
+    }
+    rec.steps++;
+    /* the goal counts only after all the gates, not when the robot strays across it */
+    if (course->hasGoal() && rec.gatesPassed == (int)gates.size() &&
+        Course::crosses(course->goal(), x0, y0, state.x, state.y)) {
+        rec.lapTime = time + PLANT_STEP;
+    }
+}
+
+void Plant::writeRecord(FILE* fp) const {
+    fprintf(fp, "LAP_TIME=%llu\n", (unsigned long long)rec.lapTime);
+    fprintf(fp, "GATES=%d\n", rec.gatesPassed);
+    fprintf(fp, "MAX_CROSS_TRACK=%.1f\n", rec.maxCrossTrack);
+    fprintf(fp, "MEAN_CROSS_TRACK=%.1f\n", (rec.steps > 0) ? rec.sumCrossTrack / rec.steps : 0.0);
+    fprintf(fp, "RMS_CROSS_TRACK=%.1f\n", (rec.steps > 0) ? std::sqrt(rec.sumSqCrossTrack / rec.steps) : 0.0);
+    fprintf(fp, "DISTANCE=%.0f\n", rec.distance);
+    fprintf(fp, "ENERGY=%.1f\n", rec.energy);
+    fprintf(fp, "GATE_TIMES=");
+    for (size_t i = 0; i < gateTime.size(); i++) {
+        fprintf(fp, "%s%llu", (i == 0) ? "" : ",", (unsigned long long)gateTime[i]);
+    }
+    fputc('\n', fp);
+}
+
+void Plant::sensorPosition(double forward, double left, double* x, double* y) const {
+    double c = std::cos(state.heading), s = std::sin(state.heading);
+    *x = state.x + forward * c - left * s;
+    *y = state.y + forward * s + left * c;
+}
+
+void Plant::advanceTo(SYSTIM t) {
+    while (time + PLANT_STEP <= t) {
+        step(PLANT_STEP / 1000000.0);
+        time += PLANT_STEP;
+    }
+}
+
+void Plant::configMotor(motor_port_t port, motor_type_t type) {
+    motors[port] = MotorState{ type, 0, true, 0.0, motors[port].counts, motors[port].offset, 0 };
+}
+
+void Plant::setPower(motor_port_t port, int power) {
+    motors[port].power = (power > 100) ? 100 : (power < -100) ? -100 : power;
+}
+
+void Plant::stop(motor_port_t port, bool brake) {
+    motors[port].power = 0;
+    motors[port].brake = brake;
+}
+
+int32_t Plant::counts(motor_port_t port) const {
+    return (int32_t)std::floor(motors[port].counts - motors[port].offset + 0.5);
+}
+
+void Plant::resetCounts(motor_port_t port) {
+    motors[port].offset = motors[port].counts;
+}
+
+void Plant::sampleColor(double rgb[3]) const {
+    double x, y;
+    sensorPosition(spec.colorForward, spec.colorLeft, &x, &y);
+    course->sample(x, y, spec.colorRadius, rgb);
+}
+
+int16_t Plant::gyroAngle(void) const {
+    return (int16_t)std::lround(-(state.heading - gyroOffset) * 180.0 / M_PI);
+}
+
+int16_t Plant::gyroRate(void) const {
+    return (int16_t)std::lround(-turnRate * 180.0 / M_PI);
+}
+
+void Plant::resetGyro(void) {
+    gyroOffset = state.heading;
+}
+
+int16_t Plant::sonarDistance(void) const {
+    double x, y;
+    sensorPosition(spec.sonarForward, spec.sonarLeft, &x, &y);
+    double nearest = SONAR_RANGE;
+    for (int i = 0; i < SONAR_RAYS; i++) {
+        double direction = state.heading - SONAR_HALF_ANGLE + 2.0 * SONAR_HALF_ANGLE * i / (SONAR_RAYS - 1);
+        double d = course->raycast(x, y, direction, SONAR_RANGE);
+        if (d < nearest) nearest = d;
+    }
+    return (int16_t)(nearest / 10.0);
+}
+
+} // namespace ev3host
@@ -0,0 +1,96 @@
+/*
+    plant.hpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#ifndef plant_hpp
+#define plant_hpp
+
+#include "ev3api.h"
+#include "course.hpp"
+
+#include <stdio.h>
+#include <vector>
+
+namespace ev3host {
+
+/*
+    Plant is the differential-drive robot running on a Course.
+    The state advances in the fixed step of PLANT_STEP so that the same inputs at the same times
+    always produce the same outputs, no matter how often or when the plant gets observed.
+    The motors follow a first-order lag toward the speed proportional to the power,
+    and the pose integrates the wheel speeds without slip, unless a slip is injected as a fault.
+*/
+class Plant {
+public:
+    static const SYSTIM PLANT_STEP = 1000;  /* in microsecond */
+
+    Plant(const Course* course, const RobotSpec& spec);
+    /* advance the state in steps up to the time */
+    void advanceTo(SYSTIM time);
+
+    void configMotor(motor_port_t port, motor_type_t type);
+    motor_type_t motorType(motor_port_t port) const { return motors[port].type; }
+    void setPower(motor_port_t port, int power);
+    int power(motor_port_t port) const { return motors[port].power; }
+    void stop(motor_port_t port, bool brake);
+    int32_t counts(motor_port_t port) const;
+    void resetCounts(motor_port_t port);
+
+    /* raw RGB averaged over the footprint of the color sensor */
+    void sampleColor(double rgb[3]) const;
+    /* in degree, clockwise positive as the EV3 gyro sensor */
+    int16_t gyroAngle(void) const;
+    int16_t gyroRate(void) const;
+    void resetGyro(void);
+    /* in centimeter, 255 when nothing is found within the beam */
+    int16_t sonarDistance(void) const;
+
+    const Pose& pose(void) const { return state; }
+    const RobotSpec& robot(void) const { return spec; }
+
+    /* performance of the run, recorded until the robot crosses the goal */
+    struct Record {
+        SYSTIM lapTime;         /* when the goal was crossed after all the gates, 0 if not yet */
+        int gatesPassed;        /* number of the gates crossed at least once */
+        double maxCrossTrack;   /* largest distance of the color sensor from the line in millimeter */
+        double sumCrossTrack;   /* sum of the distance per step for the mean */
+        double sumSqCrossTrack; /* sum of the square of the distance per step for the RMS */
+        int steps;
+        double distance;        /* traveled by the axle center in millimeter */
+        double energy;          /* integral of |PWM| of the wheels over the time in percent times second */
+    };
+    const Record& record(void) const { return rec; }
+    /* when each gate was crossed first, 0 if not yet, in the order of the course file */
+    const std::vector<SYSTIM>& gateTimes(void) const { return gateTime; }
+    /* write the record as key=value lines like profile.txt */
+    void writeRecord(FILE* fp) const;
+private:
+    struct MotorState {
+        motor_type_t type;
+        int power;
+        bool brake;
+        double speed;   /* in degree per second */
+        double counts;  /* in degree */
+        double offset;
+        SYSTIM slipUntil;   /* the wheel slips until then */
+    };
+    const Course* course;
+    RobotSpec spec;
+    MotorState motors[TNUM_MOTOR_PORT];
+    Pose state;
+    double gyroOffset;  /* heading at the last reset */
+    double turnRate;    /* in radian per second, counterclockwise positive */
+    SYSTIM time;
+    Record rec;
+    std::vector<SYSTIM> gateTime;
+    void step(double dt);
+    /* speed of the wheel on the floor in millimeter per second */
+    double wheelSpeed(int port, double dt);
+    void sensorPosition(double forward, double left, double* x, double* y) const;
+    void recordStep(double x0, double y0);
+};
+
+} // namespace ev3host
+
+#endif /* plant_hpp */
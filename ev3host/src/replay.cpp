@@ -0,0 +1,85 @@
+/*
+    replay.cpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#include "kernel.hpp"
+#include "replay.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace ev3host {
+
+namespace {
+
+/* key=value tokens following "update_task(intptr_t): " in the line, false if not of update_task */
+bool parseUpdateTask(const std::string& line, std::map<std::string, long>* values) {
+    static const char marker[] = "update_task(intptr_t): ";
+    size_t pos = line.find(marker);
+    if (pos == std::string::npos) return false;
+    std::istringstream tokens(line.substr(pos + sizeof(marker) - 1));
+    std::string token;
+    while (tokens >> token) {
+        size_t eq = token.find('=');
+        if (eq == std::string::npos) continue;
+        (*values)[token.substr(0, eq)] = strtol(token.c_str() + eq + 1, nullptr, 10);
+    }
+    return true;
+}
+
+} // namespace
+
+Replay::Replay(const char* path) : index(-1), zero{ { 0, 0, 0 }, 0, 0, 0, 0 } {
+    std::ifstream in(path);
+    if (!in) {
+        syslog(LOG_ERROR, "ev3host: cannot open replay log %s", path);
+        exit(2);
+    }
+    bool rawGiven = true;
+    for (std::string line; std::getline(in, line);) {
+        std::map<std::string, long> v;
+        if (!parseUpdateTask(line, &v)) continue;
+        if (v.count("r")) {
+            /* the first line of a tick */
+            Record r = records.empty() ? zero : records.back();
+            if (v.count("rawR")) {
+                r.rgb[0] = v["rawR"];
+                r.rgb[1] = v["rawG"];
+                r.rgb[2] = v["rawB"];
+            } else {
+                rawGiven = false;
+                r.rgb[0] = v["r"];
+                r.rgb[1] = v["g"];
+                r.rgb[2] = v["b"];
+            }
+            records.push_back(r);
+        } else if (records.empty()) {
+            continue;
+        } else if (v.count("angR")) {
+            records.back().countL = v["ang"];
+            records.back().countR = v["angR"];
+        } else if (v.count("sonar")) {
+            records.back().sonar = v["sonar"];
+            records.back().gyro = v.count("gyro") ? v["gyro"] : 0;
+        }
+    }
+    if (records.empty()) {
+        syslog(LOG_ERROR, "ev3host: no log of update_task in %s", path);
+        exit(2);
+    }
+    if (!rawGiven) syslog(LOG_WARNING, "ev3host: %s has no raw color, replaying the filtered", path);
+    syslog(LOG_NOTICE, "ev3host: replaying %d ticks of %s", (int)records.size(), path);
+}
+
+bool Replay::next(void) {
+    if (index + 1 >= (int)records.size()) return false;
+    index++;
+    return true;
+}
+
+} // namespace ev3host
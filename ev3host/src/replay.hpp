@@ -0,0 +1,46 @@
+/*
+    replay.hpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#ifndef replay_hpp
+#define replay_hpp
+
+#include <stdint.h>
+#include <vector>
+
+namespace ev3host {
+
+/*
+    Replay reads the values of the sensors per tick from the log of a run of msad2022_pri,
+    i.e. the lines of update_task:
+        r=.. g=.. b=.. rawR=.. rawG=.. rawB=..
+        dist=.. ... ang=.. angR=..
+        sonar=.. gyro=..
+    The filtered r, g and b stand in for the raw values in the logs older than rawR/G/B,
+    and so does 0 for the gyro.
+*/
+class Replay {
+public:
+    struct Record {
+        int rgb[3];
+        int32_t countL, countR;     /* encoder counts of the wheels */
+        int16_t gyro, sonar;
+    };
+    /* load the log; the process exits on an error */
+    explicit Replay(const char* path);
+    /* move on to the record of the next tick, false if no more */
+    bool next(void);
+    /* the record of the current tick, all zero before the first */
+    const Record& current(void) const { return (index < 0) ? zero : records[index]; }
+    int consumed(void) const { return index + 1; }
+    int size(void) const { return (int)records.size(); }
+private:
+    std::vector<Record> records;
+    int index;
+    Record zero;
+};
+
+} // namespace ev3host
+
+#endif /* replay_hpp */
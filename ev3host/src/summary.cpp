@@ -0,0 +1,86 @@
+/*
+    summary.cpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#include "summary.hpp"
+#include "kernel.hpp"
+#include "fault.hpp"
+#include "plant.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+/*
+    The summary of the run written to EV3HOST_SUMMARY, see summary.hpp.
+    The sections are timed by the transitions the app reports by ev3host_notifyPhase(),
+    which it calls only when built with MAKE_HOST.
+*/
+namespace {
+
+ev3host::RunSummary summary;
+int current = -1;       /* section of the current phase, -1 before the first transition or past the sections */
+SYSTIM since = 0;       /* when the current phase was entered */
+
+/* the section of the phase, added on the first entry, -1 if all the sections are taken */
+int sectionOf(const char* name) {
+    for (int i = 0; i < summary.sections; i++) {
+        if (strncmp(summary.section[i].name, name, ev3host::SUMMARY_NAME - 1) == 0) return i;
+    }
+    if (summary.sections == ev3host::SUMMARY_SECTIONS) return -1;
+    ev3host::RunSummary::Section& s = summary.section[summary.sections];
+    strncpy(s.name, name, ev3host::SUMMARY_NAME - 1);
+    return summary.sections++;
+}
+
+void enter(const char* name, SYSTIM time) {
+    current = sectionOf(name);
+    since = time;
+    if (current >= 0) summary.section[current].entries++;
+}
+
+} // namespace
+
+void ev3host_notifyPhase(const char* from, const char* to) {
+    SYSTIM time = ev3host::now();
+    /* the phase left by the first transition has been there since the start */
+    if (current < 0 && summary.sections == 0) enter(from, 0);
+    if (current >= 0) summary.section[current].duration += time - since;
+    enter(to, time);
+}
+
+/* append the summary of the run to EV3HOST_SUMMARY if given */
+void ev3host::writeSummary(int exitCode, const Plant& plant) {
+    const char* path = getenv("EV3HOST_SUMMARY");
+    if (path == nullptr || *path == '\0') return;
+    const char* label = getenv("EV3HOST_LABEL");
+    const Plant::Record& rec = plant.record();
+    const std::vector<SYSTIM>& gateTimes = plant.gateTimes();
+
+    summary.magic = SUMMARY_MAGIC;
+    summary.exitCode = exitCode;
+    if (label != nullptr) strncpy(summary.label, label, SUMMARY_LABEL - 1);
+    summary.time = now();
+    summary.lapTime = rec.lapTime;
+    summary.gates = (int32_t)gateTimes.size();
+    summary.gatesPassed = rec.gatesPassed;
+    for (size_t i = 0; i < gateTimes.size() && i < (size_t)SUMMARY_GATES; i++) {
+        summary.gateTimes[i] = gateTimes[i];
+    }
+    summary.maxCrossTrack = rec.maxCrossTrack;
+    summary.rmsCrossTrack = (rec.steps > 0) ? std::sqrt(rec.sumSqCrossTrack / rec.steps) : 0.0;
+    summary.distance = rec.distance;
+    summary.energy = rec.energy;
+    summary.qovr = faults().overruns();
+    if (current >= 0) summary.section[current].duration += summary.time - since;
+
+    /* a write to a file opened for append is not interleaved with those of the other runs */
+    int fd = open(path, O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (fd < 0 || write(fd, &summary, sizeof(summary)) != (ssize_t)sizeof(summary)) {
+        syslog(LOG_ERROR, "ev3host: cannot write summary to %s", path);
+    }
+    if (fd >= 0) close(fd);
+}
@@ -0,0 +1,55 @@
+/*
+    summary.hpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#ifndef summary_hpp
+#define summary_hpp
+
+#include <stdint.h>
+
+namespace ev3host {
+
+const uint32_t SUMMARY_MAGIC = 0x31735645;  /* "EVs1" in the little endian */
+const int SUMMARY_GATES = 8;
+const int SUMMARY_SECTIONS = 16;
+const int SUMMARY_NAME = 32;
+const int SUMMARY_LABEL = 64;
+
+/*
+    RunSummary is the record of a run appended to EV3HOST_SUMMARY in binary, in the byte order of the host.
+    A record is written in a single write to the file opened for append,
+    so that the runs of any number of processes append to a file without locking,
+    and the summary tool reads the records of thousands of runs back in a pass.
+    The layout is fixed by the magic and made of fields aligned by themselves, hence without padding,
+    to be read by the tools without the host code. The times are in microsecond of the system time.
+*/
+struct RunSummary {
+    uint32_t magic;
+    int32_t exitCode;
+    char label[SUMMARY_LABEL];          /* EV3HOST_LABEL of the run, e.g. the overrides of profile.txt */
+    uint64_t time;                      /* at the end of the run */
+    uint64_t lapTime;                   /* when the goal was crossed after all the gates, 0 if not */
+    int32_t gates;                      /* of the course, up to SUMMARY_GATES recorded in gateTimes */
+    int32_t gatesPassed;
+    uint64_t gateTimes[SUMMARY_GATES];  /* when each gate was crossed first, 0 if not */
+    double maxCrossTrack;               /* of the color sensor from the line in millimeter */
+    double rmsCrossTrack;
+    double distance;                    /* traveled by the axle center in millimeter */
+    double energy;                      /* integral of |PWM| of the wheels over the time in percent times second */
+    int32_t qovr;                       /* activations of the cyclic tasks lost to E_QOVR */
+    int32_t sections;                   /* number of the sections used */
+    /* the time spent in each phase of the app, e.g. a state of its state machine, summed over its entries,
+       the first phase timed from the start of the run; the phases past SUMMARY_SECTIONS are not recorded */
+    struct Section {
+        char name[SUMMARY_NAME];
+        uint64_t duration;
+        int32_t entries;
+        int32_t reserved;
+    } section[SUMMARY_SECTIONS];
+};
+static_assert(sizeof(RunSummary) == 968, "RunSummary is padded");
+
+} // namespace ev3host
+
+#endif /* summary_hpp */
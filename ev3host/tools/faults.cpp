@@ -0,0 +1,180 @@
+/*
+    faults.cpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#include "runner.hpp"
+
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+/*
+    faults runs the host build of an app with the faults injected, each configuration over a number of seeds,
+    to measure how often the app still reaches the goal despite the faults and how much time they cost,
+    against a run without faults. A configuration is given as in EV3HOST_FAULTS without the seed,
+    e.g. color_drop=0.02 or gyro_drift=0.5,sonar_timeout=0.1, see src/fault.hpp for the keys.
+    With -p, the lines of the output containing the text are counted per run,
+    e.g. the log of the recovery logic of the app, to tell how often it got triggered.
+    usage: faults [-a app] [-c course] [-t timeout] [-j jobs] [-n seeds] [-p text] [-s KEY=value]... [-o file] [-r file] fault...
+*/
+namespace {
+
+/* a run with the faults of the configuration and the seed */
+struct Trial {
+    size_t config;
+    int seed;
+    int matches;
+};
+
+void usage() {
+    fprintf(stderr,
+        "usage: faults [-a app] [-c course] [-t timeout] [-j jobs] [-n seeds] [-p text] [-s KEY=value]... [-o file] [-r file] fault...\n"
+        "  -a app      directory of the app (default msad2022_pri)\n"
+        "  -c course   course file with a goal (default none, a white floor)\n"
+        "  -t timeout  limit of a run in second of the system time (default 120)\n"
+        "  -j jobs     runs at a time (default the number of cores)\n"
+        "  -n seeds    runs per configuration, seeded 1 to seeds (default 20)\n"
+        "  -p text     count the lines of the output of each run containing the text\n"
+        "  -s KEY=value  override the key in profile.txt\n"
+        "  -o file     CSV to write the summary per configuration to (default stdout)\n"
+        "  -r file     CSV to write the result of each run to\n"
+        "  fault       configuration of the faults as in EV3HOST_FAULTS without the seed\n");
+    exit(2);
+}
+
+int countLines(const std::string& path, const std::string& text) {
+    std::ifstream in(path);
+    int n = 0;
+    for (std::string line; std::getline(in, line);) {
+        if (line.find(text) != std::string::npos) n++;
+    }
+    return n;
+}
+
+long resultOf(const ev3host::Run& run, const char* key) {
+    return atol(ev3host::valueOf(run.result, key, "0").c_str());
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string app = "msad2022_pri", course, text, output, perRun;
+    double timeout = 120.0;
+    int jobs = 0, seeds = 20, opt;
+    ev3host::KeyValues overrides;
+    while ((opt = getopt(argc, argv, "a:c:t:j:n:p:s:o:r:")) != -1) {
+        switch (opt) {
+        case 'a': app = optarg; break;
+        case 'c': course = optarg; break;
+        case 't': timeout = atof(optarg); break;
+        case 'j': jobs = atoi(optarg); break;
+        case 'n': seeds = atoi(optarg); break;
+        case 'p': text = optarg; break;
+        case 's':
+            if (strchr(optarg, '=') == nullptr) usage();
+            overrides.push_back(std::make_pair(std::string(optarg, strchr(optarg, '=') - optarg), std::string(strchr(optarg, '=') + 1)));
+            break;
+        case 'o': output = optarg; break;
+        case 'r': perRun = optarg; break;
+        default: usage();
+        }
+    }
+    if (optind >= argc || seeds < 1) usage();
+
+    ev3host::Runner runner(app);
+    runner.course = course;
+    runner.timeout = timeout;
+    if (jobs > 0) runner.jobs = jobs;
+
+    /* the configuration 0 is the run without faults, which needs no seeds as it is deterministic */
+    std::vector<std::string> configs(1, "");
+    for (int i = optind; i < argc; i++) configs.push_back(argv[i]);
+    std::vector<ev3host::Run> runs;
+    std::vector<Trial> trials;
+    for (size_t c = 0; c < configs.size(); c++) {
+        for (int seed = 1; seed <= ((c == 0) ? 1 : seeds); seed++) {
+            ev3host::Run run;
+            run.overrides = overrides;
+            if (c > 0) run.env.push_back(std::make_pair("EV3HOST_FAULTS", "seed=" + std::to_string(seed) + "," + configs[c]));
+            if (!text.empty()) {
+                char path[] = "/tmp/ev3host.faults.XXXXXX";
+                int fd = mkstemp(path);
+                if (fd < 0) {
+                    perror("mkstemp");
+                    return 2;
+                }
+                close(fd);
+                run.output = path;
+            }
+            run.status = -1;
+            runs.push_back(run);
+            trials.push_back(Trial{ c, seed, 0 });
+        }
+    }
+    fprintf(stderr, "faults: %zu runs of %s on %d processes\n", runs.size(), app.c_str(), runner.jobs);
+    runner.runAll(runs);
+    for (size_t i = 0; i < runs.size(); i++) {
+        if (runs[i].output.empty()) continue;
+        trials[i].matches = countLines(runs[i].output, text);
+        unlink(runs[i].output.c_str());
+    }
+
+    if (!perRun.empty()) {
+        FILE* fp = fopen(perRun.c_str(), "w");
+        if (fp == nullptr) {
+            fprintf(stderr, "cannot write %s\n", perRun.c_str());
+            return 2;
+        }
+        fprintf(fp, "FAULTS,SEED,EXIT_CODE,LAP_TIME,GATES,QOVR,MATCHES\n");
+        for (size_t i = 0; i < runs.size(); i++) {
+            fprintf(fp, "\"%s\",%d,%d,%ld,%ld,%ld,%d\n", configs[trials[i].config].c_str(), trials[i].seed,
+                runs[i].status, resultOf(runs[i], "LAP_TIME"), resultOf(runs[i], "GATES"), resultOf(runs[i], "QOVR"),
+                trials[i].matches);
+        }
+        fclose(fp);
+    }
+
+    FILE* fp = output.empty() ? stdout : fopen(output.c_str(), "w");
+    if (fp == nullptr) {
+        fprintf(stderr, "cannot write %s\n", output.c_str());
+        return 2;
+    }
+    /* the cost is the mean lap time of the runs reaching the goal over that of the run without faults */
+    fprintf(fp, "FAULTS,RUNS,GOALS,GOAL_RATE,MEAN_LAP_TIME,COST,MEAN_GATES,MEAN_QOVR,MEAN_MATCHES\n");
+    double baseline = 0.0;
+    for (size_t c = 0; c < configs.size(); c++) {
+        int n = 0, goals = 0;
+        double lapTime = 0.0, gates = 0.0, qovr = 0.0, matches = 0.0;
+        for (size_t i = 0; i < runs.size(); i++) {
+            if (trials[i].config != c) continue;
+            n++;
+            long lap = resultOf(runs[i], "LAP_TIME");
+            if (lap > 0) {
+                goals++;
+                lapTime += lap;
+            }
+            gates += resultOf(runs[i], "GATES");
+            qovr += resultOf(runs[i], "QOVR");
+            matches += trials[i].matches;
+        }
+        if (goals > 0) lapTime /= goals;
+        if (c == 0) baseline = lapTime;
+        fprintf(fp, "\"%s\",%d,%d,%.3f,", (c == 0) ? "none" : configs[c].c_str(), n, goals, (double)goals / n);
+        if (goals > 0) {
+            fprintf(fp, "%.0f,", lapTime);
+        } else {
+            fprintf(fp, ",");
+        }
+        if (goals > 0 && baseline > 0.0) {
+            fprintf(fp, "%.0f,", lapTime - baseline);
+        } else {
+            fprintf(fp, ",");
+        }
+        fprintf(fp, "%.2f,%.2f,%.2f\n", gates / n, qovr / n, matches / n);
+    }
+    if (fp != stdout) fclose(fp);
+    return 0;
+}
@@ -0,0 +1,174 @@
+/*
+    filtercmp.cpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#include "FIR.hpp"
+#include "Biquad.hpp"
+
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+/*
+    filtercmp compares the low-pass filters of the color sensor in the delay and the attenuation:
+    the FIR of msad2022_pri and of aflac2020 against Butterworth and Bessel of SOS of the orders
+    at the cut-off frequency and the sample rate, as LPF_CUTOFF and LPF_RATE of profile.txt of msad2022_pri.
+    Each filter is measured by its response to an impulse through apply(), the very code the app runs,
+    in the group delay at DC and over the pass band, the frequency of -3dB, the attenuation at the frequencies,
+    and the time of its step response to rise to the half and to 90 percent, and its overshoot.
+    usage: filtercmp [-r rate] [-c cutoff] [-n orders] [-a freq,...] [-o file]
+*/
+namespace {
+
+/* the coefficients of Observer.hpp of aflac2020 */
+const int AFLAC_ORDER = 10;
+const double aflacHn[AFLAC_ORDER+1] = { -1.247414986406201e-18, -1.270350182429102e-02, -2.481243022283666e-02, 6.381419731491805e-02, 2.761351394755998e-01, 4.000000000000000e-01, 2.761351394755998e-01, 6.381419731491805e-02, -2.481243022283666e-02, -1.270350182429102e-02, -1.247414986406201e-18 };
+
+/* long enough for the impulse response of the IIR to die out at the cut-off of a few Hz */
+const int LENGTH = 8192;
+
+struct Candidate {
+    std::string name;
+    Filter* filter;
+    std::vector<double> h;  /* impulse response */
+};
+
+void usage() {
+    fprintf(stderr,
+        "usage: filtercmp [-r rate] [-c cutoff] [-n orders] [-a freq,...] [-o file]\n"
+        "  -r rate     sample rate in Hz (default 100 of update_task)\n"
+        "  -c cutoff   cut-off frequency of SOS in Hz (default 10)\n"
+        "  -n orders   orders of SOS separated by commas (default 2,4)\n"
+        "  -a freq     frequencies in Hz to report the attenuation at, separated by commas (default 20,30)\n"
+        "  -o file     CSV to write the gain and the group delay over the frequencies to\n");
+    exit(2);
+}
+
+std::vector<double> listOf(const char* arg) {
+    std::vector<double> v;
+    for (const char* p = arg; *p != '\0';) {
+        char* end;
+        v.push_back(strtod(p, &end));
+        if (end == p || (*end != ',' && *end != '\0')) usage();
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return v;
+}
+
+/* the frequency response at the normalized angular frequency and its group delay in samples */
+std::complex<double> response(const std::vector<double>& h, double w, double* delay) {
+    std::complex<double> sum = 0.0, weighted = 0.0;
+    for (size_t n = 0; n < h.size(); n++) {
+        std::complex<double> e = std::polar(h[n], -w * n);
+        sum += e;
+        weighted += e * (double)n;
+    }
+    *delay = (weighted / sum).real();
+    return sum;
+}
+
+/* the time in samples for the step response to reach the fraction of its final value */
+double riseTime(const std::vector<double>& h, double fraction) {
+    double final = 0.0, y = 0.0;
+    for (double v : h) final += v;
+    for (size_t n = 0; n < h.size(); n++) {
+        double prev = y;
+        y += h[n];
+        if (y >= fraction * final) return n - 1 + (fraction * final - prev) / (y - prev);
+    }
+    return NAN;
+}
+
+double overshoot(const std::vector<double>& h) {
+    double final = 0.0, y = 0.0, peak = 0.0;
+    for (double v : h) final += v;
+    for (double v : h) {
+        y += v;
+        peak = fmax(peak, y);
+    }
+    return (peak / final - 1.0) * 100.0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    double rate = 100.0, cutoff = 10.0;
+    std::vector<double> orders = { 2, 4 }, freqs = { 20, 30 };
+    std::string output;
+    int opt;
+    while ((opt = getopt(argc, argv, "r:c:n:a:o:")) != -1) {
+        switch (opt) {
+        case 'r': rate = atof(optarg); break;
+        case 'c': cutoff = atof(optarg); break;
+        case 'n': orders = listOf(optarg); break;
+        case 'a': freqs = listOf(optarg); break;
+        case 'o': output = optarg; break;
+        default: usage();
+        }
+    }
+    if (optind != argc || rate <= 0.0 || cutoff <= 0.0 || cutoff >= rate / 2.0) usage();
+
+    std::vector<Candidate> candidates;
+    candidates.push_back(Candidate{ "FIR4 msad2022_pri", new FIR<4, FIR_LowPass02>, {} });
+    candidates.push_back(Candidate{ "FIR10 aflac2020", new FIR_Transposed(aflacHn, AFLAC_ORDER), {} });
+    for (double order : orders) {
+        if (order < 1 || order > SOS::MAX_ORDER) usage();
+        char name[64];
+        snprintf(name, sizeof(name), "BUTTERWORTH%d %gHz", (int)order, cutoff);
+        candidates.push_back(Candidate{ name, new SOS(SOS::BUTTERWORTH, (int)order, cutoff, rate), {} });
+        snprintf(name, sizeof(name), "BESSEL%d %gHz", (int)order, cutoff);
+        candidates.push_back(Candidate{ name, new SOS(SOS::BESSEL, (int)order, cutoff, rate), {} });
+    }
+    for (auto& c : candidates) {
+        for (int n = 0; n < LENGTH; n++) c.h.push_back(c.filter->apply((n == 0) ? 1.0 : 0.0));
+    }
+
+    const double ms = 1000.0 / rate;
+    printf("FILTER,F_3DB,DELAY_DC_MS,DELAY_MAX_MS,STEP_50_MS,STEP_90_MS,OVERSHOOT");
+    for (double f : freqs) printf(",ATT_%gHZ_DB", f);
+    printf("\n");
+    for (const auto& c : candidates) {
+        /* the group delay at DC and its largest below the -3dB frequency, found on a grid of 0.01Hz */
+        double delayDC, delayMax, delay, f3dB = NAN;
+        response(c.h, 0.0, &delayDC);
+        delayMax = delayDC;
+        for (double f = 0.01; f < rate / 2.0; f += 0.01) {
+            double gain = std::abs(response(c.h, 2.0 * M_PI * f / rate, &delay));
+            if (gain < M_SQRT1_2) {
+                f3dB = f;
+                break;
+            }
+            delayMax = fmax(delayMax, delay);
+        }
+        printf("\"%s\",%.2f,%.1f,%.1f,%.1f,%.1f,%.1f", c.name.c_str(), f3dB, delayDC * ms, delayMax * ms,
+            riseTime(c.h, 0.5) * ms, riseTime(c.h, 0.9) * ms, overshoot(c.h));
+        for (double f : freqs) {
+            printf(",%.1f", 20.0 * log10(std::abs(response(c.h, 2.0 * M_PI * f / rate, &delay))));
+        }
+        printf("\n");
+    }
+
+    if (!output.empty()) {
+        FILE* fp = fopen(output.c_str(), "w");
+        if (fp == nullptr) {
+            fprintf(stderr, "cannot write %s\n", output.c_str());
+            return 2;
+        }
+        fprintf(fp, "FILTER,FREQ,GAIN_DB,DELAY_MS\n");
+        for (const auto& c : candidates) {
+            for (double f = 0.0; f <= rate / 2.0; f += rate / 200.0) {
+                double delay, gain = std::abs(response(c.h, 2.0 * M_PI * f / rate, &delay));
+                fprintf(fp, "\"%s\",%.2f,%.2f,%.2f\n", c.name.c_str(), f, 20.0 * log10(gain), delay * ms);
+            }
+        }
+        fclose(fp);
+    }
+    for (auto& c : candidates) delete c.filter;
+    return 0;
+}
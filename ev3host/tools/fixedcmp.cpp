@@ -0,0 +1,181 @@
+/*
+    fixedcmp.cpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#include "replay.hpp"
+#include "app.h"
+#include "appusr.hpp"
+
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+/*
+    fixedcmp bounds the error of the control path in fixed point of msad2022_pri, built by -DFIXED_POINT,
+    against that in double over the logs of recorded runs, running the classes of both side by side per tick:
+    FIR_Q15<4> on the raw R, G and B, PIDcalculator_Q15 on the filtered R as TraceLine,
+    SRLF_Q15 on the PWM of the left wheel given by the PID, and Plotter_Q31 on the encoder counts.
+    The largest difference of each in a log is printed in CSV with a line of the largest over the logs,
+    and the exit code is 1 if any exceeds its bound, so that it can gate a change of the fixed point.
+    usage: fixedcmp [-k p,i,d] [-g target] [-v speed] [-r rate] [-b KEY=bound]... log...
+*/
+
+/* the encoder counts of the tick for Plotter, and the rest of ev3api it touches */
+namespace {
+
+int32_t counts[TNUM_MOTOR_PORT];
+
+} // namespace
+
+ER ev3_motor_config(motor_port_t port, motor_type_t type) { return E_OK; }
+int32_t ev3_motor_get_counts(motor_port_t port) { return counts[port]; }
+ER ev3_motor_stop(motor_port_t port, bool_t brake) { return E_OK; }
+ER ev3_motor_set_power(motor_port_t port, int power) { return E_OK; }
+ER ev3_sensor_config(sensor_port_t port, sensor_type_t type) { return E_OK; }
+ER ev3_gyro_sensor_reset(sensor_port_t port) { return E_OK; }
+
+void syslog(unsigned int prio, const char* format, ...) {
+    if (prio > LOG_WARNING) return;
+    va_list ap;
+    va_start(ap, format);
+    vfprintf(stderr, format, ap);
+    va_end(ap);
+    fputc('\n', stderr);
+}
+
+namespace {
+
+const char* const KEYS[] = { "FIR", "PID", "SRLF", "DISTANCE", "LOCATION", "DEGREE" };
+const int NUM_KEYS = sizeof(KEYS) / sizeof(KEYS[0]);
+/* the default bounds: the filters well below a count of the sensor or the PWM,
+   the PID by a step of the PWM at the truncation, and the odometry by a millimeter or a degree */
+double bounds[NUM_KEYS] = { 0.01, 1, 0.01, 1, 1, 1 };
+
+void usage() {
+    fprintf(stderr,
+        "usage: fixedcmp [-k p,i,d] [-g target] [-v speed] [-r rate] [-b KEY=bound]... log...\n"
+        "  -k p,i,d    constants of the PID (default 0.7,0.01,0.05)\n"
+        "  -g target   target of the filtered R (default 50)\n"
+        "  -v speed    forward PWM, the PID saturating at +/-speed (default 40)\n"
+        "  -r rate     rate of the slew rate limiter per tick (default 0.5)\n"
+        "  -b KEY=bound  bound of the largest difference of FIR, PID, SRLF, DISTANCE, LOCATION or DEGREE\n"
+        "  log         log of a run as printed by update_task\n");
+    exit(2);
+}
+
+struct Error {
+    double max[NUM_KEYS];
+};
+
+/* the control path of both arithmetics */
+template <class LowPass, class PID, class SlewRateLimiter, class Odometry>
+struct Path {
+    LowPass fir[3];
+    PID pid;
+    SlewRateLimiter srlf;
+    Odometry plotter;
+    Path(double k[3], int speed, double rate, ev3api::Motor* lm, ev3api::Motor* rm, ev3api::GyroSensor* gs)
+        : pid(k[0], k[1], k[2], PERIOD_UPD_TSK, -speed, speed), srlf(rate), plotter(lm, rm, gs) {}
+};
+
+typedef Path<FIR<4, FIR_LowPass02>, PIDcalculator, SRLF, Plotter> DoublePath;
+typedef Path<FIR_Q15<4, FIR_LowPass02>, PIDcalculator_Q15, SRLF_Q15, Plotter_Q31> FixedPath;
+
+Error compare(const char* log, double k[3], int target, int speed, double rate) {
+    ev3host::Replay replay(log);
+    memset(counts, 0, sizeof(counts));
+    ev3api::Motor leftMotor(PORT_C), rightMotor(PORT_B);
+    ev3api::GyroSensor gyroSensor(PORT_4);
+    DoublePath* d = new DoublePath(k, speed, rate, &leftMotor, &rightMotor, &gyroSensor);
+    FixedPath* f = new FixedPath(k, speed, rate, &leftMotor, &rightMotor, &gyroSensor);
+    Error e = {};
+    bool first = true;
+    while (replay.next()) {
+        const ev3host::Replay::Record& r = replay.current();
+        double yd[3];
+        for (int c = 0; c < 3; c++) {
+            yd[c] = first ? d->fir[c].prime(r.rgb[c]) : d->fir[c].apply(r.rgb[c]);
+            double yf = first ? f->fir[c].prime(r.rgb[c]) : f->fir[c].apply(r.rgb[c]);
+            e.max[0] = fmax(e.max[0], fabs(yd[c] - yf));
+        }
+        first = false;
+        /* both on the same sensor value, as the app truncates the filtered R to rgb_raw_t */
+        int16_t sensor = (int16_t)(uint16_t)yd[0];
+        int16_t ud = d->pid.compute(sensor, (int16_t)target);
+        int16_t uf = f->pid.compute(sensor, (int16_t)target);
+        e.max[1] = fmax(e.max[1], abs(ud - uf));
+        double pwm = (double)(speed - ud);
+        e.max[2] = fmax(e.max[2], fabs(d->srlf.apply(pwm) - f->srlf.apply(pwm)));
+        counts[PORT_C] = r.countL;
+        counts[PORT_B] = r.countR;
+        d->plotter.plot();
+        f->plotter.plot();
+        e.max[3] = fmax(e.max[3], abs(d->plotter.getDistance() - f->plotter.getDistance()));
+        e.max[4] = fmax(e.max[4], fmax(abs(d->plotter.getLocX() - f->plotter.getLocX()),
+                                       abs(d->plotter.getLocY() - f->plotter.getLocY())));
+        int deg = abs(d->plotter.getDegree() - f->plotter.getDegree()) % 360;
+        e.max[5] = fmax(e.max[5], (deg > 180) ? 360 - deg : deg);
+    }
+    delete d;
+    delete f;
+    return e;
+}
+
+void print(const char* name, const Error& e) {
+    printf("\"%s\"", name);
+    for (int i = 0; i < NUM_KEYS; i++) printf(",%g", e.max[i]);
+    printf("\n");
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    double k[3] = { 0.7, 0.01, 0.05 }, rate = 0.5;
+    int target = 50, speed = 40, opt;
+    while ((opt = getopt(argc, argv, "k:g:v:r:b:")) != -1) {
+        switch (opt) {
+        case 'k':
+            if (sscanf(optarg, "%lf,%lf,%lf", &k[0], &k[1], &k[2]) != 3) usage();
+            break;
+        case 'g': target = atoi(optarg); break;
+        case 'v': speed = atoi(optarg); break;
+        case 'r': rate = atof(optarg); break;
+        case 'b': {
+            const char* eq = strchr(optarg, '=');
+            int i = 0;
+            while (eq != nullptr && i < NUM_KEYS && std::string(optarg, eq - optarg) != KEYS[i]) i++;
+            if (eq == nullptr || i == NUM_KEYS) usage();
+            bounds[i] = atof(eq + 1);
+            break;
+        }
+        default: usage();
+        }
+    }
+    if (optind == argc || speed <= 0 || rate < 0.0) usage();
+
+    printf("LOG");
+    for (int i = 0; i < NUM_KEYS; i++) printf(",%s", KEYS[i]);
+    printf("\n");
+    Error all = {};
+    for (int n = optind; n < argc; n++) {
+        Error e = compare(argv[n], k, target, speed, rate);
+        print(argv[n], e);
+        for (int i = 0; i < NUM_KEYS; i++) all.max[i] = fmax(all.max[i], e.max[i]);
+    }
+    print("MAX", all);
+
+    int status = 0;
+    for (int i = 0; i < NUM_KEYS; i++) {
+        if (all.max[i] > bounds[i]) {
+            fprintf(stderr, "%s differs by %g over the bound of %g\n", KEYS[i], all.max[i], bounds[i]);
+            status = 1;
+        }
+    }
+    return status;
+}
@@ -0,0 +1,358 @@
+/*
+    pidtune.cpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#include "runner.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+/*
+    pidtune tunes the PID constants of the line trace of an app on the host plant, per speed tier.
+    For each speed, it first runs a relay feedback experiment, i.e. the trace with a huge P and no I nor D
+    so that the output of PIDcalculator saturates at +/-speed like a relay, to find the ultimate gain Ku
+    and period Tu from the limit cycle of the traced sensor value in the log, then seeds
+    the Ziegler-Nichols constants Kp = 0.6 Ku, Ki = 1.2 Ku / Tu and Kd = 0.075 Ku Tu
+    (PIDcalculator takes I and D per second), and refines them by Nelder-Mead on the cost
+        seconds of the lap, or of the run if the goal was not crossed
+        + MEAN_CROSS_TRACK / 10 + MAX_CROSS_TRACK / 50 in millimeter
+    evaluating the candidates of an iteration of all the tiers in parallel.
+    The best constants are written in the format of profile.txt.
+    usage: pidtune [options] SPEED...
+*/
+namespace {
+
+const int DIM = 3;
+typedef std::vector<double> Point;
+
+struct Options {
+    std::string app = "msad2022_pri", course, output;
+    std::string speedKey = "SPEED", targetKey = "GS_TARGET";
+    std::string keys[DIM] = { "P_CONST", "I_CONST", "D_CONST" };
+    double timeout = 60.0, relayGain = 100.0;
+    int iterations = 30, jobs = 0;
+    ev3host::KeyValues fixed;
+};
+
+void usage() {
+    fprintf(stderr,
+        "usage: pidtune [options] SPEED...\n"
+        "  -a app       directory of the app (default msad2022_pri)\n"
+        "  -c course    course file with the line to trace\n"
+        "  -t timeout   limit of a run in second of the system time (default 60)\n"
+        "  -j jobs      runs at a time (default the number of cores)\n"
+        "  -n count     iterations of Nelder-Mead per tier (default 30)\n"
+        "  -k P,I,D     keys of the PID constants (default P_CONST,I_CONST,D_CONST)\n"
+        "  -v key       key of the speed (default SPEED)\n"
+        "  -g key       key of the target of the trace (default GS_TARGET)\n"
+        "  -s KEY=value other keys to override, e.g. COURSE=R\n"
+        "  -o file      file to write the best constants to (default stdout)\n");
+    exit(2);
+}
+
+double costOf(const ev3host::Run& run, double timeout) {
+    if (run.status < 0) return std::numeric_limits<double>::infinity();
+    double lap = atof(ev3host::valueOf(run.result, "LAP_TIME", "0").c_str());
+    double time = (lap > 0.0) ? lap : atof(ev3host::valueOf(run.result, "TIME", "0").c_str());
+    return time / 1000000.0
+        + atof(ev3host::valueOf(run.result, "MEAN_CROSS_TRACK", "0").c_str()) / 10.0
+        + atof(ev3host::valueOf(run.result, "MAX_CROSS_TRACK", "0").c_str()) / 50.0;
+}
+
+/*
+    the ultimate gain and period from the limit cycle of the traced value in the log of update_task,
+    false if no sustained oscillation found
+*/
+bool analyzeRelay(const std::string& log, double target, double amplitude, double* ku, double* tu) {
+    std::ifstream in(log);
+    std::vector<double> times, values;
+    for (std::string line; std::getline(in, line);) {
+        size_t pos = line.find("update_task(intptr_t): r=");
+        if (pos == std::string::npos) continue;
+        times.push_back(atof(line.c_str()) / 1000000.0);
+        values.push_back(atof(line.c_str() + pos + strlen("update_task(intptr_t): r=")));
+    }
+    /* the upward crossings of the target, skipping the first second to settle */
+    std::vector<size_t> ups;
+    for (size_t i = 1; i < values.size(); i++) {
+        if (times[i] < 1.0 || times[i] < times[i - 1]) continue;
+        if (values[i - 1] < target && values[i] >= target) ups.push_back(i);
+    }
+    if (ups.size() < 3) return false;
+    double sumPeriod = 0.0, sumAmplitude = 0.0;
+    for (size_t c = 1; c < ups.size(); c++) {
+        sumPeriod += times[ups[c]] - times[ups[c - 1]];
+        auto range = std::minmax_element(values.begin() + ups[c - 1], values.begin() + ups[c]);
+        sumAmplitude += (*range.second - *range.first) / 2.0;
+    }
+    int cycles = ups.size() - 1;
+    double a = sumAmplitude / cycles;
+    if (a <= 0.0) return false;
+    *tu = sumPeriod / cycles;
+    *ku = 4.0 * amplitude / (M_PI * a);
+    return true;
+}
+
+std::string format(double value) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.4g", value);
+    return buf;
+}
+
+/* Nelder-Mead on the PID constants of a speed tier */
+struct Tier {
+    double speed = 0.0;
+    std::vector<Point> simplex;
+    std::vector<double> costs;
+    Point seed;
+    bool seeded = false;
+
+    Point best() const {
+        return simplex[std::min_element(costs.begin(), costs.end()) - costs.begin()];
+    }
+};
+
+class Tuner {
+public:
+    Tuner(const Options& o) : opt(o), runner(o.app) {
+        runner.course = opt.course;
+        runner.timeout = opt.timeout;
+        if (opt.jobs > 0) runner.jobs = opt.jobs;
+        ev3host::KeyValues profile;
+        ev3host::readKeyValues(opt.app + "/profile.txt", &profile);
+        target = atof(ev3host::valueOf(opt.fixed, opt.targetKey, ev3host::valueOf(profile, opt.targetKey, "0")).c_str());
+        for (int k = 0; k < DIM; k++) {
+            current[k] = atof(ev3host::valueOf(profile, opt.keys[k], "0").c_str());
+        }
+    }
+    void tune(std::vector<Tier>& tiers);
+private:
+    Options opt;
+    ev3host::Runner runner;
+    double target;
+    Point current = Point(DIM);
+    std::map<std::string, double> cache;   /* the runs are deterministic on the virtual clock */
+
+    ev3host::Run runOf(double speed, const Point& p) {
+        ev3host::Run run;
+        run.overrides = opt.fixed;
+        run.overrides.push_back(std::make_pair(opt.speedKey, format(speed)));
+        for (int k = 0; k < DIM; k++) {
+            run.overrides.push_back(std::make_pair(opt.keys[k], format(p[k])));
+        }
+        run.status = -1;
+        return run;
+    }
+    std::string keyOf(double speed, const Point& p) {
+        std::string key = format(speed);
+        for (int k = 0; k < DIM; k++) key += "," + format(p[k]);
+        return key;
+    }
+    /* evaluate the candidates of all the tiers in parallel */
+    std::vector<std::vector<double> > evaluate(const std::vector<Tier>& tiers, const std::vector<std::vector<Point> >& candidates);
+    void seed(std::vector<Tier>& tiers);
+};
+
+std::vector<std::vector<double> > Tuner::evaluate(const std::vector<Tier>& tiers, const std::vector<std::vector<Point> >& candidates) {
+    std::vector<ev3host::Run> runs;
+    std::vector<std::string> keys;
+    for (size_t t = 0; t < tiers.size(); t++) {
+        for (const auto& p : candidates[t]) {
+            std::string key = keyOf(tiers[t].speed, p);
+            if (cache.count(key) || std::find(keys.begin(), keys.end(), key) != keys.end()) continue;
+            runs.push_back(runOf(tiers[t].speed, p));
+            keys.push_back(key);
+        }
+    }
+    runner.runAll(runs);
+    for (size_t i = 0; i < runs.size(); i++) {
+        cache[keys[i]] = costOf(runs[i], opt.timeout);
+    }
+    std::vector<std::vector<double> > costs(tiers.size());
+    for (size_t t = 0; t < tiers.size(); t++) {
+        for (const auto& p : candidates[t]) {
+            costs[t].push_back(cache[keyOf(tiers[t].speed, p)]);
+        }
+    }
+    return costs;
+}
+
+void Tuner::seed(std::vector<Tier>& tiers) {
+    std::vector<ev3host::Run> runs;
+    for (auto& tier : tiers) {
+        ev3host::Run run = runOf(tier.speed, Point{ opt.relayGain, 0.0, 0.0 });
+        char output[] = "/tmp/ev3host.relay.XXXXXX";
+        int fd = mkstemp(output);
+        if (fd >= 0) close(fd);
+        run.output = output;
+        runs.push_back(run);
+    }
+    runner.runAll(runs);
+    for (size_t t = 0; t < tiers.size(); t++) {
+        Tier& tier = tiers[t];
+        double ku = 0.0, tu = 0.0;
+        tier.seeded = analyzeRelay(runs[t].output, target, tier.speed, &ku, &tu);
+        unlink(runs[t].output.c_str());
+        if (tier.seeded) {
+            tier.seed = Point{ 0.6 * ku, 1.2 * ku / tu, 0.075 * ku * tu };
+            fprintf(stderr, "pidtune: speed %g: Ku %.4g, Tu %.3g s by relay\n", tier.speed, ku, tu);
+        } else {
+            tier.seed = current;
+            fprintf(stderr, "pidtune: speed %g: no limit cycle by relay, starting from profile.txt\n", tier.speed);
+        }
+    }
+}
+
+void Tuner::tune(std::vector<Tier>& tiers) {
+    seed(tiers);
+    /* the initial simplex around the seed */
+    std::vector<std::vector<Point> > candidates(tiers.size());
+    for (size_t t = 0; t < tiers.size(); t++) {
+        candidates[t].push_back(tiers[t].seed);
+        for (int k = 0; k < DIM; k++) {
+            Point p = tiers[t].seed;
+            p[k] = (p[k] > 0.0) ? p[k] * 1.5 : 0.01;
+            candidates[t].push_back(p);
+        }
+        tiers[t].simplex = candidates[t];
+    }
+    auto costs = evaluate(tiers, candidates);
+    for (size_t t = 0; t < tiers.size(); t++) tiers[t].costs = costs[t];
+
+    for (int iter = 0; iter < opt.iterations; iter++) {
+        /* the reflection, expansion and contractions of every tier are evaluated at once */
+        std::vector<Point> centroids(tiers.size());
+        for (size_t t = 0; t < tiers.size(); t++) {
+            Tier& tier = tiers[t];
+            std::vector<size_t> order(DIM + 1);
+            for (size_t i = 0; i <= DIM; i++) order[i] = i;
+            std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return tier.costs[a] < tier.costs[b]; });
+            std::vector<Point> s;
+            std::vector<double> c;
+            for (auto i : order) {
+                s.push_back(tier.simplex[i]);
+                c.push_back(tier.costs[i]);
+            }
+            tier.simplex = s;
+            tier.costs = c;
+            Point centroid(DIM, 0.0);
+            for (int i = 0; i < DIM; i++) {
+                for (int k = 0; k < DIM; k++) centroid[k] += s[i][k] / DIM;
+            }
+            centroids[t] = centroid;
+            auto along = [&](double factor) {
+                Point p(DIM);
+                for (int k = 0; k < DIM; k++) p[k] = std::max(0.0, centroid[k] + factor * (s[DIM][k] - centroid[k]));
+                return p;
+            };
+            candidates[t] = { along(-1.0), along(-2.0), along(-0.5), along(0.5) };
+        }
+        costs = evaluate(tiers, candidates);
+
+        std::vector<std::vector<Point> > shrinks(tiers.size());
+        for (size_t t = 0; t < tiers.size(); t++) {
+            Tier& tier = tiers[t];
+            const auto& p = candidates[t];
+            const auto& c = costs[t];
+            double fr = c[0], fe = c[1], foc = c[2], fic = c[3];
+            if (fr < tier.costs[0]) {
+                tier.simplex[DIM] = (fe < fr) ? p[1] : p[0];
+                tier.costs[DIM] = std::min(fe, fr);
+            } else if (fr < tier.costs[DIM - 1]) {
+                tier.simplex[DIM] = p[0];
+                tier.costs[DIM] = fr;
+            } else if (fr < tier.costs[DIM] && foc <= fr) {
+                tier.simplex[DIM] = p[2];
+                tier.costs[DIM] = foc;
+            } else if (fr >= tier.costs[DIM] && fic < tier.costs[DIM]) {
+                tier.simplex[DIM] = p[3];
+                tier.costs[DIM] = fic;
+            } else {
+                /* shrink toward the best */
+                for (int i = 1; i <= DIM; i++) {
+                    for (int k = 0; k < DIM; k++) {
+                        tier.simplex[i][k] = (tier.simplex[0][k] + tier.simplex[i][k]) / 2.0;
+                    }
+                    shrinks[t].push_back(tier.simplex[i]);
+                }
+            }
+        }
+        costs = evaluate(tiers, shrinks);
+        for (size_t t = 0; t < tiers.size(); t++) {
+            for (size_t i = 0; i < shrinks[t].size(); i++) tiers[t].costs[i + 1] = costs[t][i];
+            fprintf(stderr, "pidtune: speed %g: iteration %d, cost %.4g\n", tiers[t].speed, iter + 1,
+                *std::min_element(tiers[t].costs.begin(), tiers[t].costs.end()));
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    int o;
+    while ((o = getopt(argc, argv, "a:c:t:j:n:k:v:g:s:o:")) != -1) {
+        switch (o) {
+        case 'a': opt.app = optarg; break;
+        case 'c': opt.course = optarg; break;
+        case 't': opt.timeout = atof(optarg); break;
+        case 'j': opt.jobs = atoi(optarg); break;
+        case 'n': opt.iterations = atoi(optarg); break;
+        case 'k': {
+            char* save;
+            char* key = strtok_r(optarg, ",", &save);
+            for (int k = 0; k < DIM; k++, key = strtok_r(nullptr, ",", &save)) {
+                if (key == nullptr) usage();
+                opt.keys[k] = key;
+            }
+            break;
+        }
+        case 'v': opt.speedKey = optarg; break;
+        case 'g': opt.targetKey = optarg; break;
+        case 's': {
+            const char* eq = strchr(optarg, '=');
+            if (eq == nullptr) usage();
+            opt.fixed.push_back(std::make_pair(std::string(optarg, eq - optarg), std::string(eq + 1)));
+            break;
+        }
+        case 'o': opt.output = optarg; break;
+        default: usage();
+        }
+    }
+    if (optind >= argc || opt.course.empty()) usage();
+    std::vector<Tier> tiers;
+    for (int i = optind; i < argc; i++) {
+        Tier tier;
+        tier.speed = atof(argv[i]);
+        if (tier.speed <= 0.0) usage();
+        tiers.push_back(tier);
+    }
+
+    Tuner tuner(opt);
+    tuner.tune(tiers);
+
+    FILE* fp = opt.output.empty() ? stdout : fopen(opt.output.c_str(), "w");
+    if (fp == nullptr) {
+        fprintf(stderr, "cannot write %s\n", opt.output.c_str());
+        return 2;
+    }
+    for (const auto& tier : tiers) {
+        Point best = tier.best();
+        fprintf(fp, "# speed %g, cost %.4g%s\n", tier.speed,
+            *std::min_element(tier.costs.begin(), tier.costs.end()), tier.seeded ? ", seeded by relay" : "");
+        fprintf(fp, "%s=%s\n", opt.speedKey.c_str(), format(tier.speed).c_str());
+        for (int k = 0; k < DIM; k++) {
+            fprintf(fp, "%s=%s\n", opt.keys[k].c_str(), format(best[k]).c_str());
+        }
+    }
+    if (fp != stdout) fclose(fp);
+    return 0;
+}
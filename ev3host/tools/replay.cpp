@@ -0,0 +1,112 @@
+/*
+    replay.cpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#include "runner.hpp"
+
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+/*
+    replay runs the host build of an app over the logs of recorded runs in open loop,
+    each in a process of its own, feeding the sensor values per tick in the log to the app.
+    The state transitions and the motor commands of each replay are extracted to <dir>/<log>.replay
+    so that they can be compared with those of another build, e.g. by diff -r,
+    and a summary per log is written in CSV.
+    usage: replay [-a app] [-j jobs] [-d dir] [-t timeout] [-s KEY=value]... log...
+*/
+namespace {
+
+void usage() {
+    fprintf(stderr,
+        "usage: replay [-a app] [-j jobs] [-d dir] [-t timeout] [-s KEY=value]... log...\n"
+        "  -a app      directory of the app (default msad2022_pri)\n"
+        "  -j jobs     replays at a time (default the number of cores)\n"
+        "  -d dir      directory to write the transitions and motor commands of each log to\n"
+        "  -t timeout  limit of a replay in second of the system time (default 3600)\n"
+        "  -s KEY=value  override the key in profile.txt as in the recorded runs\n"
+        "  log         log of a run as printed by update_task\n");
+    exit(2);
+}
+
+std::string baseName(const std::string& path) {
+    size_t slash = path.rfind('/');
+    return (slash == std::string::npos) ? path : path.substr(slash + 1);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string app = "msad2022_pri", dir;
+    double timeout = 3600.0;
+    int jobs = 0, opt;
+    ev3host::KeyValues overrides;
+    while ((opt = getopt(argc, argv, "a:j:d:t:s:")) != -1) {
+        switch (opt) {
+        case 'a': app = optarg; break;
+        case 'j': jobs = atoi(optarg); break;
+        case 'd': dir = optarg; break;
+        case 't': timeout = atof(optarg); break;
+        case 's':
+            if (strchr(optarg, '=') == nullptr) usage();
+            overrides.push_back(std::make_pair(std::string(optarg, strchr(optarg, '=') - optarg), std::string(strchr(optarg, '=') + 1)));
+            break;
+        default: usage();
+        }
+    }
+    if (optind >= argc) usage();
+
+    ev3host::Runner runner(app);
+    runner.timeout = timeout;
+    if (jobs > 0) runner.jobs = jobs;
+
+    std::vector<ev3host::Run> runs;
+    std::vector<std::string> logs;
+    for (int i = optind; i < argc; i++) {
+        ev3host::Run run;
+        char output[] = "/tmp/ev3host.replay.XXXXXX";
+        int fd = mkstemp(output);
+        if (fd < 0) {
+            perror("mkstemp");
+            return 2;
+        }
+        close(fd);
+        run.overrides = overrides;
+        run.env.push_back(std::make_pair("EV3HOST_REPLAY", ev3host::absolutePath(argv[i])));
+        run.output = output;
+        run.status = -1;
+        runs.push_back(run);
+        logs.push_back(argv[i]);
+    }
+    fprintf(stderr, "replay: %zu logs on %s with %d processes\n", runs.size(), app.c_str(), runner.jobs);
+    runner.runAll(runs);
+
+    printf("LOG,EXIT_CODE,REPLAYED,TRANSITIONS,FINAL_STATE\n");
+    for (size_t i = 0; i < runs.size(); i++) {
+        std::ifstream in(runs[i].output);
+        std::ofstream out;
+        if (!dir.empty()) out.open(dir + "/" + baseName(logs[i]) + ".replay");
+        int transitions = 0;
+        std::string finalState;
+        for (std::string line; std::getline(in, line);) {
+            size_t pos = line.find("State changed: ");
+            if (pos != std::string::npos) {
+                transitions++;
+                size_t to = line.rfind(" to ");
+                if (to != std::string::npos) finalState = line.substr(to + 4);
+            } else if (line.find("ev3host: ") != 0 || line.find(" motor ") == std::string::npos) {
+                continue;
+            }
+            if (out.is_open()) out << line << '\n';
+        }
+        unlink(runs[i].output.c_str());
+        printf("%s,%s,%s,%d,%s\n", logs[i].c_str(),
+            ev3host::valueOf(runs[i].result, "EXIT_CODE").c_str(),
+            ev3host::valueOf(runs[i].result, "REPLAYED").c_str(), transitions, finalState.c_str());
+    }
+    return 0;
+}
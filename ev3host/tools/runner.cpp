@@ -0,0 +1,189 @@
+/*
+    runner.cpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#include "runner.hpp"
+
+#include <fstream>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <ftw.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace ev3host {
+
+bool readKeyValues(const std::string& path, KeyValues* kv) {
+    std::ifstream is(path);
+    if (!is.is_open()) return false;
+    for (std::string line; std::getline(is, line);) {
+        size_t pos = line.find('=');
+        if (pos != std::string::npos) {
+            kv->push_back(std::make_pair(line.substr(0, pos), line.substr(pos + 1)));
+        }
+    }
+    return true;
+}
+
+std::string valueOf(const KeyValues& kv, const std::string& key, const std::string& defaultValue) {
+    for (const auto& p : kv) {
+        if (p.first == key) return p.second;
+    }
+    return defaultValue;
+}
+
+std::string absolutePath(const std::string& path) {
+    if (path.empty() || path[0] == '/') return path;
+    char cwd[4096];
+    if (getcwd(cwd, sizeof(cwd)) == nullptr) return path;
+    return std::string(cwd) + "/" + path;
+}
+
+namespace {
+
+int removeEntry(const char* path, const struct stat* sb, int type, struct FTW* ftw) {
+    return remove(path);
+}
+
+} // namespace
+
+Runner::Runner(const std::string& app)
+ : timeout(120.0), jobs(std::thread::hardware_concurrency()), keep(false), app(app) {
+    root = absolutePath(".");
+    executable = root + "/ev3host/build/" + app + "/" + app;
+    if (access(executable.c_str(), X_OK) != 0) {
+        fprintf(stderr, "%s not found, make -C ev3host app=%s first\n", executable.c_str(), app.c_str());
+        exit(2);
+    }
+    if (!readKeyValues(root + "/" + app + "/profile.txt", &baseProfile)) {
+        fprintf(stderr, "%s/profile.txt not found, run at the root of the repository\n", app.c_str());
+        exit(2);
+    }
+    if (jobs < 1) jobs = 1;
+}
+
+/* prepare the working directory of the run, false on an error */
+bool Runner::prepare(const Run& run, std::string* dir) {
+    char templ[] = "/tmp/ev3host.XXXXXX";
+    if (mkdtemp(templ) == nullptr) return false;
+    *dir = templ;
+    std::string appDir = *dir + "/" + app;
+    if (mkdir(appDir.c_str(), 0755) != 0) return false;
+
+    /* profile.txt of the app with the overrides applied in place, or appended if new */
+    KeyValues profile = baseProfile;
+    for (const auto& o : run.overrides) {
+        bool found = false;
+        for (auto& p : profile) {
+            if (p.first == o.first) {
+                p.second = o.second;
+                found = true;
+            }
+        }
+        if (!found) profile.push_back(o);
+    }
+    FILE* fp = fopen((appDir + "/profile.txt").c_str(), "w");
+    if (fp == nullptr) return false;
+    for (const auto& p : profile) {
+        fprintf(fp, "%s=%s\n", p.first.c_str(), p.second.c_str());
+    }
+    fclose(fp);
+    return true;
+}
+
+void Runner::finish(Run& run, const std::string& dir) {
+    run.result.clear();
+    if (!readKeyValues(dir + "/result.txt", &run.result)) {
+        run.status = -1;
+    } else {
+        run.status = atoi(valueOf(run.result, "EXIT_CODE", "-1").c_str());
+    }
+    if (!run.output.empty()) {
+        std::ifstream in(dir + "/log.txt", std::ios::binary);
+        std::ofstream out(run.output, std::ios::binary);
+        out << in.rdbuf();
+    }
+    if (keep) {
+        fprintf(stderr, "kept %s\n", dir.c_str());
+    } else {
+        nftw(dir.c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+    }
+}
+
+void Runner::runAll(std::vector<Run>& runs) {
+    if (runs.empty()) return;
+    /* the batch of a line per run: the working directory and the environment variables, separated by tabs */
+    char batch[] = "/tmp/ev3host.batch.XXXXXX";
+    int fd = mkstemp(batch);
+    FILE* fp = (fd < 0) ? nullptr : fdopen(fd, "w");
+    if (fp == nullptr) {
+        fprintf(stderr, "failed to write the batch: %s\n", strerror(errno));
+        for (auto& run : runs) run.status = -1;
+        return;
+    }
+    std::vector<std::string> dirs(runs.size());
+    for (size_t i = 0; i < runs.size(); i++) {
+        if (!prepare(runs[i], &dirs[i])) {
+            fprintf(stderr, "failed to prepare run %zu: %s\n", i, strerror(errno));
+            continue;
+        }
+        fprintf(fp, "%s\tEV3HOST_RESULT=%s/result.txt", dirs[i].c_str(), dirs[i].c_str());
+        if (!summary.empty() && valueOf(runs[i].env, "EV3HOST_LABEL").empty()) {
+            fprintf(fp, "\tEV3HOST_LABEL=");
+            for (size_t k = 0; k < runs[i].overrides.size(); k++) {
+                const auto& o = runs[i].overrides[k];
+                fprintf(fp, "%s%s=%s", (k == 0) ? "" : " ", o.first.c_str(), o.second.c_str());
+            }
+        }
+        for (const auto& e : runs[i].env) {
+            fprintf(fp, "\t%s=%s", e.first.c_str(), e.second.c_str());
+        }
+        fputc('\n', fp);
+    }
+    fclose(fp);
+
+    char limit[32], processes[16];
+    snprintf(limit, sizeof(limit), "%g", timeout);
+    snprintf(processes, sizeof(processes), "%d", jobs);
+    std::string coursePath = absolutePath(course);
+    std::string summaryPath = absolutePath(summary);
+    pid_t pid = fork();
+    if (pid == 0) {
+        /* the runs write their own output to log.txt */
+        int null = open("/dev/null", O_WRONLY);
+        if (null >= 0) {
+            dup2(null, STDOUT_FILENO);
+            dup2(null, STDERR_FILENO);
+            close(null);
+        }
+        unsetenv("EV3HOST_SPEED");
+        setenv("EV3HOST_TIMEOUT", limit, 1);
+        setenv("EV3HOST_COURSE", coursePath.c_str(), 1);
+        setenv("EV3HOST_BATCH", batch, 1);
+        setenv("EV3HOST_JOBS", processes, 1);
+        if (!summaryPath.empty()) setenv("EV3HOST_SUMMARY", summaryPath.c_str(), 1);
+        execl(executable.c_str(), executable.c_str(), (char*)nullptr);
+        _exit(127);
+    }
+    int status;
+    if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "failed to run the batch of %s\n", app.c_str());
+    }
+    unlink(batch);
+    for (size_t i = 0; i < runs.size(); i++) {
+        if (dirs[i].empty()) {
+            runs[i].status = -1;
+        } else {
+            finish(runs[i], dirs[i]);
+        }
+    }
+}
+
+} // namespace ev3host
@@ -0,0 +1,64 @@
+/*
+    runner.hpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#ifndef runner_hpp
+#define runner_hpp
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ev3host {
+
+/* key=value pairs in the order of appearance as in profile.txt */
+typedef std::vector<std::pair<std::string, std::string> > KeyValues;
+
+/* read key=value lines of the file, false if it cannot be opened */
+bool readKeyValues(const std::string& path, KeyValues* kv);
+/* path relative to the current directory made absolute */
+std::string absolutePath(const std::string& path);
+/* value of the key, or defaultValue if not found */
+std::string valueOf(const KeyValues& kv, const std::string& key, const std::string& defaultValue = "");
+
+/* a configuration of the app to run and its result */
+struct Run {
+    KeyValues overrides;    /* keys in profile.txt of the app to override */
+    KeyValues env;          /* environment variables to add to the run */
+    std::string output;     /* file to keep the stdout and stderr of the run, none to discard */
+    KeyValues result;       /* as written to EV3HOST_RESULT by the run */
+    int status;             /* exit code of the run, -1 if it failed to run or to write the result */
+};
+
+/*
+    Runner runs the host build of an app for each configuration in a separate process,
+    as many at a time as the jobs, each in a working directory of its own under /tmp
+    holding profile.txt with the overrides applied.
+    The runs are forked as a batch by a single process of the app after loading the course,
+    so that they share the course read-only and skip starting the executable and loading the course.
+    The runs take place on the virtual clock, hence the results do not depend on the host load.
+    With the summary given, each run appends its summary to it labeled by the overrides
+    unless EV3HOST_LABEL is given in the environment of the run.
+    Runner is to be used at the root of the repository as the apps are.
+*/
+class Runner {
+public:
+    Runner(const std::string& app);
+    std::string course;     /* course file, none for a white floor */
+    double timeout;         /* in second of the system time */
+    int jobs;               /* number of processes at a time, the number of cores by default */
+    bool keep;              /* keep the working directories for inspection */
+    std::string summary;    /* file to append the summaries of the runs to as EV3HOST_SUMMARY, none for not */
+    void runAll(std::vector<Run>& runs);
+private:
+    std::string app, root, executable;
+    KeyValues baseProfile;
+    bool prepare(const Run& run, std::string* dir);
+    void finish(Run& run, const std::string& dir);
+};
+
+} // namespace ev3host
+
+#endif /* runner_hpp */
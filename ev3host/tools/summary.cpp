@@ -0,0 +1,181 @@
+/*
+    summary.cpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#include "../src/summary.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+/*
+    summary merges the binary summaries of the runs appended to EV3HOST_SUMMARY, see src/summary.hpp,
+    e.g. by sweep -b or by the runs of a batch, in a single pass over the files without keeping the runs,
+    and writes the statistics of each metric over the runs in CSV, per label with -g.
+    The metrics are GOAL, 1 if the goal was reached and 0 if not, LAP_TIME over the runs reaching the goal,
+    GATES passed, MAX_CROSS_TRACK, RMS_CROSS_TRACK, DISTANCE, ENERGY, QOVR
+    and SECTION:<name> for the time in each phase over the runs entering it.
+    With -r, the summary of each run is written in CSV as well.
+    usage: summary [-g] [-o file] [-r file] file...
+*/
+namespace {
+
+/* the mean and the variance by Welford in a pass */
+struct Stats {
+    long n;
+    double mean, m2, min, max;
+    Stats() : n(0), mean(0.0), m2(0.0), min(0.0), max(0.0) {}
+    void add(double x) {
+        if (n == 0 || x < min) min = x;
+        if (n == 0 || x > max) max = x;
+        n++;
+        double d = x - mean;
+        mean += d / n;
+        m2 += d * (x - mean);
+    }
+    double stdev() const { return (n > 1) ? std::sqrt(m2 / (n - 1)) : 0.0; }
+};
+
+/* the metrics in the order of the output, followed by the sections in the order of appearance */
+const char* metrics[] = {
+    "GOAL", "LAP_TIME", "GATES", "MAX_CROSS_TRACK", "RMS_CROSS_TRACK", "DISTANCE", "ENERGY", "QOVR"
+};
+const int NUM_METRICS = sizeof(metrics) / sizeof(metrics[0]);
+
+struct Group {
+    Stats metric[NUM_METRICS];
+    std::vector<std::string> sectionNames;
+    std::map<std::string, Stats> sections;
+};
+
+void usage() {
+    fprintf(stderr,
+        "usage: summary [-g] [-o file] [-r file] file...\n"
+        "  -g          aggregate per label of the runs instead of over all the runs\n"
+        "  -o file     CSV to write the statistics to (default stdout)\n"
+        "  -r file     CSV to write the summary of each run to\n"
+        "  file        summaries appended by the runs to EV3HOST_SUMMARY\n");
+    exit(2);
+}
+
+/* the string of a fixed field, which is terminated only when shorter than the field */
+std::string fieldOf(const char* field, size_t size) {
+    return std::string(field, strnlen(field, size));
+}
+
+void aggregate(const ev3host::RunSummary& s, Group* g) {
+    g->metric[0].add((s.lapTime > 0) ? 1.0 : 0.0);
+    if (s.lapTime > 0) g->metric[1].add((double)s.lapTime);
+    g->metric[2].add(s.gatesPassed);
+    g->metric[3].add(s.maxCrossTrack);
+    g->metric[4].add(s.rmsCrossTrack);
+    g->metric[5].add(s.distance);
+    g->metric[6].add(s.energy);
+    g->metric[7].add(s.qovr);
+    for (int i = 0; i < s.sections && i < ev3host::SUMMARY_SECTIONS; i++) {
+        std::string name = fieldOf(s.section[i].name, ev3host::SUMMARY_NAME);
+        if (g->sections.find(name) == g->sections.end()) g->sectionNames.push_back(name);
+        g->sections[name].add((double)s.section[i].duration);
+    }
+}
+
+void writeRun(FILE* fp, const ev3host::RunSummary& s) {
+    fprintf(fp, "\"%s\",%d,%llu,%llu,%d,%.1f,%.1f,%.0f,%.1f,%d,\"", fieldOf(s.label, ev3host::SUMMARY_LABEL).c_str(),
+        s.exitCode, (unsigned long long)s.time, (unsigned long long)s.lapTime, s.gatesPassed,
+        s.maxCrossTrack, s.rmsCrossTrack, s.distance, s.energy, s.qovr);
+    for (int i = 0; i < s.gates && i < ev3host::SUMMARY_GATES; i++) {
+        fprintf(fp, "%s%llu", (i == 0) ? "" : " ", (unsigned long long)s.gateTimes[i]);
+    }
+    fprintf(fp, "\",\"");
+    for (int i = 0; i < s.sections && i < ev3host::SUMMARY_SECTIONS; i++) {
+        fprintf(fp, "%s%s:%llu", (i == 0) ? "" : " ", fieldOf(s.section[i].name, ev3host::SUMMARY_NAME).c_str(),
+            (unsigned long long)s.section[i].duration);
+    }
+    fprintf(fp, "\"\n");
+}
+
+void writeStats(FILE* fp, const std::string& label, const std::string& metric, const Stats& st) {
+    fprintf(fp, "\"%s\",%s,%ld,%.3f,%.3f,%.3f,%.3f\n",
+        label.c_str(), metric.c_str(), st.n, st.mean, st.stdev(), st.min, st.max);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string output, perRun;
+    bool byLabel = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "go:r:")) != -1) {
+        switch (opt) {
+        case 'g': byLabel = true; break;
+        case 'o': output = optarg; break;
+        case 'r': perRun = optarg; break;
+        default: usage();
+        }
+    }
+    if (optind >= argc) usage();
+
+    FILE* runs = nullptr;
+    if (!perRun.empty()) {
+        runs = fopen(perRun.c_str(), "w");
+        if (runs == nullptr) {
+            fprintf(stderr, "cannot write %s\n", perRun.c_str());
+            return 2;
+        }
+        fprintf(runs, "LABEL,EXIT_CODE,TIME,LAP_TIME,GATES,MAX_CROSS_TRACK,RMS_CROSS_TRACK,DISTANCE,ENERGY,QOVR,"
+            "GATE_TIMES,SECTIONS\n");
+    }
+
+    /* the groups in the order of appearance of the labels */
+    std::vector<std::string> labels;
+    std::map<std::string, Group> groups;
+    long n = 0;
+    for (int i = optind; i < argc; i++) {
+        FILE* fp = fopen(argv[i], "rb");
+        if (fp == nullptr) {
+            fprintf(stderr, "cannot open %s\n", argv[i]);
+            return 2;
+        }
+        ev3host::RunSummary s;
+        size_t got;
+        while ((got = fread(&s, 1, sizeof(s), fp)) == sizeof(s)) {
+            if (s.magic != ev3host::SUMMARY_MAGIC) {
+                fprintf(stderr, "%s: not a summary at record %ld\n", argv[i], n);
+                return 2;
+            }
+            std::string label = byLabel ? fieldOf(s.label, ev3host::SUMMARY_LABEL) : "all";
+            if (groups.find(label) == groups.end()) labels.push_back(label);
+            aggregate(s, &groups[label]);
+            if (runs != nullptr) writeRun(runs, s);
+            n++;
+        }
+        if (got != 0) fprintf(stderr, "%s: truncated record ignored\n", argv[i]);
+        fclose(fp);
+    }
+    if (runs != nullptr) fclose(runs);
+
+    FILE* fp = output.empty() ? stdout : fopen(output.c_str(), "w");
+    if (fp == nullptr) {
+        fprintf(stderr, "cannot write %s\n", output.c_str());
+        return 2;
+    }
+    fprintf(fp, "LABEL,METRIC,COUNT,MEAN,STDEV,MIN,MAX\n");
+    for (const auto& label : labels) {
+        const Group& g = groups[label];
+        for (int m = 0; m < NUM_METRICS; m++) {
+            writeStats(fp, label, metrics[m], g.metric[m]);
+        }
+        for (const auto& name : g.sectionNames) {
+            writeStats(fp, label, "SECTION:" + name, g.sections.at(name));
+        }
+    }
+    if (fp != stdout) fclose(fp);
+    fprintf(stderr, "summary: %ld runs in %zu groups\n", n, labels.size());
+    return 0;
+}
@@ -0,0 +1,148 @@
+/*
+    sweep.cpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#include "runner.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+/*
+    sweep runs the host build of an app over the grid of values of keys in profile.txt
+    and tabulates the results of the runs in CSV, one row per configuration.
+    A key is given as KEY=v1,v2,... for the listed values or as KEY=from:to:step for the range.
+    usage: sweep [-a app] [-c course] [-t timeout] [-j jobs] [-o file] [-b file] [-k] KEY=values...
+*/
+namespace {
+
+struct Axis {
+    std::string key;
+    std::vector<std::string> values;
+};
+
+/* the columns of the result written by the host kernel */
+const char* resultColumns[] = { "EXIT_CODE", "TIME", "LAP_TIME", "GATES", "MAX_CROSS_TRACK", "DISTANCE" };
+
+void usage() {
+    fprintf(stderr,
+        "usage: sweep [-a app] [-c course] [-t timeout] [-j jobs] [-o file] [-b file] [-k] KEY=values...\n"
+        "  -a app      directory of the app (default msad2022_pri)\n"
+        "  -c course   course file (default none, a white floor)\n"
+        "  -t timeout  limit of a run in second of the system time (default 120)\n"
+        "  -j jobs     runs at a time (default the number of cores)\n"
+        "  -o file     CSV to write the results to (default stdout)\n"
+        "  -b file     file to append the binary summaries of the runs to, see the summary tool\n"
+        "  -k          keep the working directories of the runs\n"
+        "  KEY=v1,v2,... or KEY=from:to:step for the values of a key in profile.txt\n");
+    exit(2);
+}
+
+bool parseAxis(const char* arg, Axis* axis) {
+    const char* eq = strchr(arg, '=');
+    if (eq == nullptr || eq == arg) return false;
+    axis->key.assign(arg, eq - arg);
+    std::string spec(eq + 1);
+    double from, to, step;
+    char tail;
+    if (sscanf(spec.c_str(), "%lf:%lf:%lf%c", &from, &to, &step, &tail) == 3) {
+        if (step <= 0.0 || to < from) return false;
+        int n = (int)std::floor((to - from) / step + 1e-9) + 1;
+        for (int i = 0; i < n; i++) {
+            char value[32];
+            snprintf(value, sizeof(value), "%g", from + i * step);
+            axis->values.push_back(value);
+        }
+    } else {
+        size_t begin = 0, comma;
+        do {
+            comma = spec.find(',', begin);
+            axis->values.push_back(spec.substr(begin, comma - begin));
+            begin = comma + 1;
+        } while (comma != std::string::npos);
+    }
+    return !axis->values.empty();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string app = "msad2022_pri", output, summary;
+    ev3host::Runner* runner;
+    std::string course;
+    double timeout = 120.0;
+    int jobs = 0, opt;
+    bool keep = false;
+    while ((opt = getopt(argc, argv, "a:c:t:j:o:b:k")) != -1) {
+        switch (opt) {
+        case 'a': app = optarg; break;
+        case 'c': course = optarg; break;
+        case 't': timeout = atof(optarg); break;
+        case 'j': jobs = atoi(optarg); break;
+        case 'o': output = optarg; break;
+        case 'b': summary = optarg; break;
+        case 'k': keep = true; break;
+        default: usage();
+        }
+    }
+    std::vector<Axis> axes;
+    for (int i = optind; i < argc; i++) {
+        Axis axis;
+        if (!parseAxis(argv[i], &axis)) {
+            fprintf(stderr, "invalid grid %s\n", argv[i]);
+            usage();
+        }
+        axes.push_back(axis);
+    }
+    if (axes.empty()) usage();
+
+    runner = new ev3host::Runner(app);
+    runner->course = course;
+    runner->timeout = timeout;
+    runner->keep = keep;
+    runner->summary = summary;
+    if (jobs > 0) runner->jobs = jobs;
+
+    /* the cartesian product of the axes with the last axis varying fastest */
+    std::vector<ev3host::Run> runs;
+    std::vector<size_t> index(axes.size(), 0);
+    for (;;) {
+        ev3host::Run run;
+        for (size_t a = 0; a < axes.size(); a++) {
+            run.overrides.push_back(std::make_pair(axes[a].key, axes[a].values[index[a]]));
+        }
+        run.status = -1;
+        runs.push_back(run);
+        size_t a = axes.size();
+        while (a > 0 && ++index[a - 1] == axes[a - 1].values.size()) {
+            index[--a] = 0;
+        }
+        if (a == 0) break;
+    }
+    fprintf(stderr, "sweep: %zu runs of %s on %d processes\n", runs.size(), app.c_str(), runner->jobs);
+    runner->runAll(runs);
+
+    FILE* fp = output.empty() ? stdout : fopen(output.c_str(), "w");
+    if (fp == nullptr) {
+        fprintf(stderr, "cannot write %s\n", output.c_str());
+        return 2;
+    }
+    fprintf(fp, "RUN");
+    for (const auto& axis : axes) fprintf(fp, ",%s", axis.key.c_str());
+    for (auto column : resultColumns) fprintf(fp, ",%s", column);
+    fputc('\n', fp);
+    for (size_t i = 0; i < runs.size(); i++) {
+        fprintf(fp, "%zu", i);
+        for (const auto& o : runs[i].overrides) fprintf(fp, ",%s", o.second.c_str());
+        for (auto column : resultColumns) {
+            fprintf(fp, ",%s", ev3host::valueOf(runs[i].result, column).c_str());
+        }
+        fputc('\n', fp);
+    }
+    if (fp != stdout) fclose(fp);
+    delete runner;
+    return 0;
+}
@@ -6,81 +6,168 @@
 #ifndef MovingAverage_hpp
 #define MovingAverage_hpp
 
+#include <assert.h>
 #include <math.h>
+#include <stdint.h>
+#include <type_traits>
 
-#define _stdev(cnt, sum, ssq) sqrt((((double)(cnt))*ssq-pow((double)(sum),2)) / ((double)(cnt)*((double)(cnt)-1)))
-
+/*
+    MovingAverage keeps the statistics of the last elements up to the window, CAPACITY by default.
+    The sum is kept in int64_t for an integral T not to overflow, and the mean and the variance
+    by the update of Welford for the window, recomputed from the elements each time the window turns over
+    so that the rounding does not build up over a run.
+    The min and the max are the fronts of monotonic deques, each element entering and leaving them once.
+*/
 template<typename T, int CAPACITY> class MovingAverage {
-private:
-    T elements[CAPACITY];
-    int index;
-    bool filled;
-    T sum, ssq;
 public:
-    MovingAverage();
+    struct Snapshot {
+        int count;
+        T mean, stdev, min, max;
+        double variance;
+    };
+    MovingAverage(int window = CAPACITY);
     void clear();
     T push(T element);
     T mean();
     T stdev();
+    double variance();
+    T min();
+    T max();
+    /* the element to leave the window next */
+    T oldest();
+    int count();
+    Snapshot snapshot();
+private:
+    typedef typename std::conditional<std::is_integral<T>::value, int64_t, double>::type Sum;
+    T elements[CAPACITY];
+    int window, n, index;
+    Sum sum;
+    double avg, m2;
+    /* the indices to elements in the order of arrival, increasing in value for minq and decreasing for maxq */
+    int minq[CAPACITY], maxq[CAPACITY];
+    int minHead, minLen, maxHead, maxLen;
+    void resync();
 };
 
 template<typename T, int CAPACITY>
-MovingAverage<T, CAPACITY>::MovingAverage() {
-    assert (CAPACITY > 0);
+MovingAverage<T, CAPACITY>::MovingAverage(int window) : window(window) {
+    assert (CAPACITY > 0 && window > 0 && window <= CAPACITY);
     clear();
 }
 
 template<typename T, int CAPACITY>
 void MovingAverage<T, CAPACITY>::clear() {
+    n = 0;
     index = 0;
     sum = 0;
-    ssq = 0;
-    filled = false;
+    avg = 0.0;
+    m2 = 0.0;
+    minHead = minLen = 0;
+    maxHead = maxLen = 0;
 }
 
 template<typename T, int CAPACITY>
 T MovingAverage<T, CAPACITY>::push(T element) {
-    if (index == CAPACITY) {
-        index = 0;
-        filled = true;
-    }
-    if (filled) {
-        sum = sum - elements[index] + element;
-        ssq = ssq - elements[index] * elements[index] + element * element;
-        elements[index++] = element;
-        return sum / CAPACITY;
+    double x = (double)element;
+    if (n == window) {
+        T old = elements[index];
+        if (minLen > 0 && minq[minHead] == index) {
+            minHead = (minHead + 1) % CAPACITY;
+            minLen--;
+        }
+        if (maxLen > 0 && maxq[maxHead] == index) {
+            maxHead = (maxHead + 1) % CAPACITY;
+            maxLen--;
+        }
+        sum = sum - old + element;
+        double delta = x - (double)old, prev = avg;
+        avg += delta / n;
+        m2 += delta * (x - avg + (double)old - prev);
     } else {
+        n++;
         sum = sum + element;
-        ssq = ssq + element * element;
-        elements[index++] = element;
-        return sum / index;
+        double delta = x - avg;
+        avg += delta / n;
+        m2 += delta * (x - avg);
     }
+    elements[index] = element;
+    while (minLen > 0 && elements[minq[(minHead + minLen - 1) % CAPACITY]] >= element) minLen--;
+    minq[(minHead + minLen++) % CAPACITY] = index;
+    while (maxLen > 0 && elements[maxq[(maxHead + maxLen - 1) % CAPACITY]] <= element) maxLen--;
+    maxq[(maxHead + maxLen++) % CAPACITY] = index;
+    index = (index + 1) % window;
+    if (index == 0) resync();
+    return mean();
+}
+
+template<typename T, int CAPACITY>
+void MovingAverage<T, CAPACITY>::resync() {
+    double s = 0.0;
+    for (int i = 0; i < n; i++) s += (double)elements[i];
+    avg = s / n;
+    m2 = 0.0;
+    for (int i = 0; i < n; i++) m2 += ((double)elements[i] - avg) * ((double)elements[i] - avg);
 }
 
 template<typename T, int CAPACITY>
 T MovingAverage<T, CAPACITY>::mean() {
-    if (filled) {
-        return sum / CAPACITY;
+    if (n == 0) {
+        return 0;
+    } else if (std::is_integral<T>::value) {
+        return (T)(sum / n);
     } else {
-        if (index == 0) {
-            return 0;
-        } else {
-            return sum / index;
-        }
+        return (T)avg;
+    }
+}
+
+template<typename T, int CAPACITY>
+double MovingAverage<T, CAPACITY>::variance() {
+    if (n < 2) {
+        return 0.0;
+    } else {
+        return (m2 > 0.0) ? m2 / (n - 1) : 0.0;
     }
 }
 
 template<typename T, int CAPACITY>
 T MovingAverage<T, CAPACITY>::stdev() {
-    if (filled) {
-        return _stdev(CAPACITY, sum, ssq);
+    return (T)sqrt(variance());
+}
+
+template<typename T, int CAPACITY>
+T MovingAverage<T, CAPACITY>::min() {
+    return (minLen == 0) ? 0 : elements[minq[minHead]];
+}
+
+template<typename T, int CAPACITY>
+T MovingAverage<T, CAPACITY>::max() {
+    return (maxLen == 0) ? 0 : elements[maxq[maxHead]];
+}
+
+template<typename T, int CAPACITY>
+T MovingAverage<T, CAPACITY>::oldest() {
+    if (n == 0) {
+        return 0;
     } else {
-        if (index == 0 || index == 1) {
-            return 0;
-        } else {
-            return _stdev(index, sum, ssq);
-        }
+        return (n == window) ? elements[index] : elements[0];
     }
 }
 
-#endif /* MovingAverage_hpp */
\ No newline at end of file
+template<typename T, int CAPACITY>
+int MovingAverage<T, CAPACITY>::count() {
+    return n;
+}
+
+template<typename T, int CAPACITY>
+typename MovingAverage<T, CAPACITY>::Snapshot MovingAverage<T, CAPACITY>::snapshot() {
+    Snapshot s;
+    s.count = n;
+    s.mean = mean();
+    s.variance = variance();
+    s.stdev = (T)sqrt(s.variance);
+    s.min = min();
+    s.max = max();
+    return s;
+}
+
+#endif /* MovingAverage_hpp */
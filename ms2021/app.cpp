@@ -524,30 +524,32 @@ protected:
 
 class IsCurveAveEarned : public BrainTree::Node {
 public:
-    IsCurveAveEarned(int32_t d,int32_t t,int32_t it ,CalcMode mode) : deltaDegreeTarget(d),interval(t),invalidTime(it),cnt(0),calcMode(mode),earned(false) {}
+    /* of the interval up to MAX_INTERVAL */
+    static const int MAX_INTERVAL = 100;
+    IsCurveAveEarned(int32_t d,int32_t t,int32_t it ,CalcMode mode) : deltaDegreeTarget(d),interval(t),invalidTime(it),cnt(0),calcMode(mode),earned(false),degrees(t),aveDegrees(t) {}
     Status update() override {
 
         startDegree = plotter->getDegree();
         if(startDegree > 180){
             startDegree = startDegree - 360;
         }
-        deltaDegree.insert(deltaDegree.begin(), startDegree);
+        degrees.push(startDegree);
 
         if (cnt >= invalidTime/10 && cnt >= interval) {
-            aveDegree = (double)(accumulate(deltaDegree.begin(), deltaDegree.end(), 0)/interval);
-            aveDeltaDegree.insert(aveDeltaDegree.begin(), aveDegree);
+            aveDegree = (double)degrees.mean();
+            aveDegrees.push(aveDegree);
 
-            if (aveDeltaDegree.size() >= interval){
-                //printf("nowaveDegree = %f 5komae=%f sa = %f size=%d\n",aveDegree,aveDeltaDegree.back(),aveDegree - aveDeltaDegree.back(),aveDeltaDegree.size());
+            if (aveDegrees.count() >= interval){
+                //printf("nowaveDegree = %f 5komae=%f sa = %f\n",aveDegree,aveDegrees.oldest(),aveDegree - aveDegrees.oldest());
                 switch (calcMode) {
                 case Less:
-                    if(aveDegree - aveDeltaDegree.back() <= deltaDegreeTarget){
+                    if(aveDegree - aveDegrees.oldest() <= deltaDegreeTarget){
                         _log("Delta %d getnow= %d", aveDegree,clock->now());
                         return Status::Success;
                     }
                     break;    
                 case More:
-                    if(aveDegree - aveDeltaDegree.back() >= deltaDegreeTarget){
+                    if(aveDegree - aveDegrees.oldest() >= deltaDegreeTarget){
                         _log("Delta %d getnow= %d", aveDegree,clock->now());
                         return Status::Success;
                     }
@@ -555,12 +557,8 @@ public:
                 default:
                     break;
                 }
-                aveDeltaDegree.pop_back();
             }
         }
-        if (deltaDegree.size() >= interval){
-            deltaDegree.pop_back();
-        }
         cnt ++ ;
         return Status::Failure;
     }
@@ -569,8 +567,8 @@ protected:
     double aveDegree;
     bool earned;
     CalcMode calcMode;
-    std::vector<int32_t> deltaDegree;
-    std::vector<double> aveDeltaDegree;
+    MovingAverage<int32_t, MAX_INTERVAL> degrees;
+    MovingAverage<double, MAX_INTERVAL> aveDegrees;
 };
 
 
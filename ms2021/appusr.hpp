@@ -29,6 +29,7 @@ using namespace ev3api;
 #include "FIR.hpp"
 #include "Plotter.hpp"
 #include "PIDcalculator.hpp"
+#include "MovingAverage.hpp"
 #include "Logger.hpp"
 
 /* global variables */
@@ -0,0 +1,116 @@
+/*
+    Biquad.cpp
+    Infinite Impulse Response Filter of second-order sections
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+
+#include "Biquad.hpp"
+#include <assert.h>
+#include <math.h>
+#include <complex>
+
+typedef std::complex<double> Complex;
+
+Biquad::Biquad() : b0(1.0), b1(0.0), b2(0.0), a1(0.0), a2(0.0), s1(0.0), s2(0.0) {}
+
+Biquad::Biquad(double b0, double b1, double b2, double a1, double a2)
+    : b0(b0), b1(b1), b2(b2), a1(a1), a2(a2), s1(0.0), s2(0.0) {}
+
+double Biquad::prime(const double xin) {
+    /* the output at the gain of DC, and the state that keeps it */
+    double yout = xin * (b0 + b1 + b2) / (1.0 + a1 + a2);
+    s1 = yout - b0 * xin;
+    s2 = b2 * xin - a2 * yout;
+    return yout;
+}
+
+void Biquad::reset() {
+    s1 = s2 = 0.0;
+}
+
+/* the value of the polynomial of the coefficients c[0] + c[1] s + ... + c[n] s^n */
+static Complex polynomial(const double c[], int n, Complex s) {
+    Complex v = c[n];
+    for (int k = n - 1; k >= 0; k--) v = v * s + c[k];
+    return v;
+}
+
+/* the poles of the analog prototype of the order with the gain of -3dB at 1 rad/s */
+static void prototype(SOS::Design design, int n, Complex pole[]) {
+    if (design == SOS::BUTTERWORTH) {
+        for (int k = 0; k < n; k++) pole[k] = std::polar(1.0, M_PI * (2 * k + n + 1) / (2 * n));
+        return;
+    }
+    /* the roots of the reverse Bessel polynomial, sum of (2n-k)! / (2^(n-k) k! (n-k)!) s^k,
+       found by Durand-Kerner, then scaled to the gain of -3dB at 1 rad/s */
+    double c[SOS::MAX_ORDER + 1];
+    for (int k = 0; k <= n; k++) {
+        double v = 1.0;
+        for (int i = n - k + 1; i <= 2 * n - k; i++) v *= i;
+        for (int i = 2; i <= k; i++) v /= i;
+        c[k] = v / pow(2.0, n - k);
+    }
+    for (int k = 0; k < n; k++) pole[k] = pow(Complex(0.4, 0.9), k);
+    double monic[SOS::MAX_ORDER + 1];
+    for (int k = 0; k <= n; k++) monic[k] = c[k] / c[n];
+    for (int iter = 0; iter < 500; iter++) {
+        double moved = 0.0;
+        for (int k = 0; k < n; k++) {
+            Complex d = 1.0;
+            for (int j = 0; j < n; j++) {
+                if (j != k) d *= pole[k] - pole[j];
+            }
+            Complex step = polynomial(monic, n, pole[k]) / d;
+            pole[k] -= step;
+            moved = fmax(moved, std::abs(step));
+        }
+        if (moved < 1e-14) break;
+    }
+    double lo = 0.1, hi = 10.0;
+    for (int iter = 0; iter < 100; iter++) {
+        double w = (lo + hi) / 2.0;
+        if (std::norm(c[0] / polynomial(c, n, Complex(0.0, w))) > 0.5) {
+            lo = w;
+        } else {
+            hi = w;
+        }
+    }
+    for (int k = 0; k < n; k++) pole[k] /= lo;
+}
+
+SOS::SOS(Design design, int order, double cutoff, double rate) : numSections(0) {
+    assert(order >= 1 && order <= MAX_ORDER);
+    assert(cutoff > 0.0 && cutoff < rate / 2.0);
+    Complex pole[MAX_ORDER];
+    prototype(design, order, pole);
+    /* the analog cut-off prewarped to land on the cut-off after the bilinear transform */
+    double fs2 = 2.0 * rate;
+    double wc = fs2 * tan(M_PI * cutoff / rate);
+    for (int k = 0; k < order; k++) {
+        Complex p = pole[k] * wc;
+        Complex z = (fs2 + p) / (fs2 - p);
+        if (fabs(z.imag()) < 1e-9) {
+            /* a real pole as a first-order section with the zero at Nyquist */
+            double a1 = -z.real();
+            double g = (1.0 + a1) / 2.0;
+            section[numSections++] = Biquad(g, g, 0.0, a1, 0.0);
+        } else if (z.imag() > 0.0) {
+            /* a pair of the conjugate poles, with the double zero at Nyquist */
+            double a1 = -2.0 * z.real(), a2 = std::norm(z);
+            double g = (1.0 + a1 + a2) / 4.0;
+            section[numSections++] = Biquad(g, 2.0 * g, g, a1, a2);
+        }
+    }
+    assert(numSections == (order + 1) / 2);
+}
+
+void SOS::reset() {
+    for (int i = 0; i < numSections; i++) section[i].reset();
+}
+
+double SOS::prime(const double xin) {
+    double x = xin;
+    for (int i = 0; i < numSections; i++) x = section[i].prime(x);
+    return x;
+}
@@ -0,0 +1,61 @@
+/*
+    Biquad.hpp
+    Infinite Impulse Response Filter of second-order sections
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#ifndef Biquad_hpp
+#define Biquad_hpp
+
+#include "Filter.hpp"
+
+/* a second-order section in the transposed direct form II,
+   H(z) = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2), a first-order one with b2 = a2 = 0 */
+class Biquad : public Filter {
+public:
+    Biquad();
+    Biquad(double b0, double b1, double b2, double a1, double a2);
+    inline double apply(const double xin);
+    double prime(const double xin);
+    void reset();
+protected:
+    double b0, b1, b2, a1, a2;
+    double s1, s2;
+};
+
+inline double Biquad::apply(const double xin) {
+    double yout = b0 * xin + s1;
+    s1 = b1 * xin - a1 * yout + s2;
+    s2 = b2 * xin - a2 * yout;
+    return yout;
+}
+
+/*
+    SOS is a low-pass filter of a cascade of Biquad designed at run time
+    from the analog prototype by the bilinear transform with the cut-off frequency prewarped,
+    so that the gain is -3dB at the cut-off frequency and 1 at DC for either design.
+    Butterworth is maximally flat in the pass band,
+    and Bessel maximally flat in the group delay, i.e. with the least overshoot of a step, at a slower roll-off.
+    Either delays the signal in the pass band by less than an FIR of the same attenuation.
+*/
+class SOS : public Filter {
+public:
+    enum Design { BUTTERWORTH, BESSEL };
+    static const int MAX_ORDER = 8;
+    /* of the order from 1 to MAX_ORDER, with the cut-off frequency below the half of the sample rate in Hz */
+    SOS(Design design, int order, double cutoff, double rate);
+    inline double apply(const double xin);
+    double prime(const double xin);
+    void reset();
+protected:
+    Biquad section[(MAX_ORDER + 1) / 2];
+    int numSections;
+};
+
+inline double SOS::apply(const double xin) {
+    double x = xin;
+    for (int i = 0; i < numSections; i++) x = section[i].apply(x);
+    return x;
+}
+
+#endif /* Biquad_hpp */
@@ -7,6 +7,9 @@
 //           being executable on TOPPERS/EV3RT (HRP3) with Athrill
 // 3/30/2021 Modified by Wataru Taniguchi to make use of Blackboard
 // 4/28/2021 Modified by Wataru Taniguchi to correct the behavior of UntilSuccess and UntilFailure
+// 10/19/2026 Modified to add StateMachine composite to host trees per state of HFSM
+// 10/19/2026 Modified to build trees hosted by StateMachine on demand via factories
+// 10/19/2026 Modified to add ParallelRace and ParallelWatch composites and to abort abandoned children
 
 #pragma once
 
@@ -122,6 +125,15 @@ public:
 
     void reset() { status = Status::Invalid; }
 
+    // abandon the node halfway; a running node gets terminate() called with Status::Invalid
+    void abort()
+    {
+        if (status == Status::Running) {
+            terminate(Status::Invalid);
+        }
+        status = Status::Invalid;
+    }
+
 protected:
     Status status = Status::Invalid;
     Blackboard* blackboard = nullptr;
@@ -138,6 +150,20 @@ public:
     
     void addChild(Node* child) { children.push_back(child); it=children.begin(); }
     bool hasChildren() const { return !children.empty(); }
+
+    // children still running when the composite terminates are abandoned, hence aborted
+    // and an aborted composite starts over from the first child
+    void terminate(Status s) override
+    {
+        for (auto &child : children) {
+            if (child->isRunning()) {
+                child->abort();
+            }
+        }
+        if (s == Status::Invalid) {
+            it = children.begin();
+        }
+    }
     
 protected:
     std::vector<Node*> children;
@@ -153,6 +179,14 @@ public:
 
     void setChild(Node* node) { child = node; }
     bool hasChild() const { return child != nullptr; }
+
+    // the child still running when the decorator terminates is abandoned, hence aborted
+    void terminate(Status s) override
+    {
+        if (child->isRunning()) {
+            child->abort();
+        }
+    }
     
 protected:
     Node* child = nullptr;
@@ -184,6 +218,7 @@ public:
     }
     
     Status update() { return root->tick(); }
+    void terminate(Status s) override { root->abort(); }
     
     void setRoot(Node* node) { root = node; }
     
@@ -495,6 +530,190 @@ private:
     int minFail = 0;
 };
 
+// The ParallelRace composite ticks each child node in order and the first child to succeed wins the race.
+// Once a child succeeds, the parallel race succeeds without ticking the rest and the running children get aborted.
+// A child that fails drops out of the race and is not ticked again until the parallel race starts over.
+// If all children fail, only then does the parallel race fail.
+class ParallelRace : public Composite
+{
+public:
+    void initialize() override
+    {
+        for (auto &child : children) {
+            child->reset();
+        }
+    }
+
+    Status update() override
+    {
+        assert(hasChildren() && "Composite has no children");
+
+        bool running = false;
+        for (auto &child : children) {
+            if (child->isFailure()) {
+                continue;
+            }
+            auto status = child->tick();
+            if (status == Status::Success) {
+                return Status::Success;
+            }
+            if (status == Status::Running) {
+                running = true;
+            }
+        }
+
+        return running ? Status::Running : Status::Failure;
+    }
+};
+
+// The ParallelWatch composite guards an action, i.e. the last child node, by conditions, i.e. the other children.
+// In each tick, the conditions get ticked first in order. Once a condition succeeds, the parallel watch succeeds
+// without ticking the action, which gets aborted if running, so that the action makes no move on the tick
+// the condition fires. Otherwise, the action gets ticked and the parallel watch returns the same status.
+// A condition returning failure or running is regarded as not fired, and it gets ticked again in the next tick.
+class ParallelWatch : public Composite
+{
+public:
+    Status update() override
+    {
+        assert(children.size() >= 2 && "ParallelWatch needs a condition and an action");
+
+        auto action = children.end() - 1;
+        for (auto cond = children.begin(); cond != action; ++cond) {
+            if ((*cond)->tick() == Status::Success) {
+                return Status::Success;
+            }
+        }
+
+        return (*action)->tick();
+    }
+};
+
+// The StateMachine composite hosts a child node per state and switches between them by a declared transition table.
+// Each state is registered with a factory of its child so that the child gets built only when the state is entered
+// and destroyed when the state is left, i.e. only the child of the current state occupies memory.
+// In each tick, the child of the current state gets ticked. When the child terminates, the first transition
+// in the table matching the current state and the status of the child (and whose guard holds, if any) is taken,
+// and the child of the new state gets ticked within the same tick so that no period is lost on a state change.
+// When the state machine reaches a state with no factory, i.e. a final state, it succeeds.
+// If no transition matches for the terminated child, the state machine fails.
+class StateMachine : public Node
+{
+public:
+    static const int AnyState = -1;
+    typedef Node* (*Factory)();
+    typedef bool (*Guard)();
+    typedef void (*Listener)(const char* from, const char* to);
+
+    struct Transition
+    {
+        int from;       // state to leave, or AnyState
+        Status on;      // status of the child to trigger the transition
+        int to;         // state to enter
+        Guard guard;    // optional condition, nullptr means always
+    };
+
+    StateMachine(int initialState) : current(initialState) {}
+    ~StateMachine() {
+        delete child;
+    }
+
+    // the child of the current state is abandoned when the state machine is aborted
+    void terminate(Status s) override
+    {
+        if (child != nullptr && child->isRunning()) {
+            child->abort();
+        }
+    }
+
+    void addState(int state, const char* name, Factory factory)
+    {
+        assert(findState(state) == nullptr && "State already registered");
+        states.push_back({ state, name, factory });
+    }
+
+    template <size_t N>
+    void setTransitions(const Transition (&table)[N])
+    {
+        transitions.assign(table, table + N);
+    }
+
+    void setListener(Listener l) { listener = l; }
+    int getState() const { return current; }
+
+    Status update() override
+    {
+        // every state can be entered at most once in a tick to avoid an endless loop
+        for (size_t hop = 0; hop <= states.size(); hop++) {
+            auto entry = findState(current);
+            assert(entry != nullptr && "State not registered");
+
+            if (entry->factory == nullptr) {
+                return Status::Success;
+            }
+            if (child == nullptr) {
+                child = entry->factory();
+            }
+
+            auto status = child->tick();
+            if (status == Status::Running) {
+                return status;
+            }
+
+            delete child;
+            child = nullptr;
+
+            auto transition = findTransition(current, status);
+            if (transition == nullptr) {
+                return Status::Failure;
+            }
+            auto next = findState(transition->to);
+            assert(next != nullptr && "State not registered");
+            if (listener != nullptr) {
+                listener(entry->name, next->name);
+            }
+            current = transition->to;
+        }
+
+        return Status::Running;
+    }
+
+private:
+    struct StateEntry
+    {
+        int state;
+        const char* name;
+        Factory factory;
+    };
+
+    const StateEntry* findState(int state) const
+    {
+        for (auto &entry : states) {
+            if (entry.state == state) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    const Transition* findTransition(int state, Status status) const
+    {
+        for (auto &transition : transitions) {
+            if ((transition.from == state || transition.from == AnyState) && transition.on == status &&
+                (transition.guard == nullptr || transition.guard())) {
+                return &transition;
+            }
+        }
+        return nullptr;
+    }
+
+    int current;
+    Node* child = nullptr;
+    std::vector<StateEntry> states;
+    std::vector<Transition> transitions;
+    Listener listener = nullptr;
+};
+
 // The Succeeder decorator returns success, regardless of what happens to the child.
 class Succeeder : public Decorator
 {
@@ -0,0 +1,53 @@
+/*
+    Coroutine.hpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#ifndef Coroutine_hpp
+#define Coroutine_hpp
+
+#include "BrainTree.h"
+
+/*
+    Coroutine is a BrainTree node whose update() is written as straight-line code
+    that suspends at CO_YIELD/CO_AWAIT/CO_DO_UNTIL and resumes there in the next tick.
+    It is stackless: the only frame is resumePoint and the member variables of the node,
+    hence no allocation takes place per tick nor per coroutine.
+
+    C++20 coroutines are not available for -std=gnu++14 on EV3RT,
+    so the resume points are implemented by the switch statement on __LINE__.
+    Note the following restrictions between CO_BEGIN and CO_END:
+      - local variables do NOT survive a suspension; keep the state in member variables
+      - no switch statement may enclose a suspension
+      - at most one suspension per source line
+
+    usage:
+    Status update() override {
+        CO_BEGIN
+        ...
+        CO_DO_UNTIL(condition, action);
+        ...
+        CO_END
+    }
+*/
+class Coroutine : public BrainTree::Node {
+public:
+    /* start over from CO_BEGIN whenever the node gets (re-)entered or has been aborted */
+    void initialize() override { resumePoint = 0; }
+protected:
+    int resumePoint = 0;
+};
+
+#define CO_BEGIN                    switch (resumePoint) { case 0:
+#define CO_END                      } resumePoint = 0; return Status::Success;
+
+/* suspend returning the status s and resume at the next statement in the next tick */
+#define CO_YIELD(s)                 do { resumePoint = __LINE__; return (s); case __LINE__: ; } while (0)
+/* terminate the coroutine with the status s */
+#define CO_RETURN(s)                do { resumePoint = 0; return (s); } while (0)
+/* suspend until cond holds; cond is evaluated in every tick including the current one */
+#define CO_AWAIT(cond)              while (!(cond)) CO_YIELD(Status::Running)
+/* perform the action (the rest of arguments) in every tick until cond holds; cond is evaluated before the action like ParallelWatch */
+#define CO_DO_UNTIL(cond, ...)      while (!(cond)) { __VA_ARGS__; CO_YIELD(Status::Running); }
+
+#endif /* Coroutine_hpp */
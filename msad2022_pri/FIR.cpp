@@ -11,6 +11,8 @@
 #include "FIR.hpp"
 #include <assert.h>
 
+constexpr double FIR_LowPass02::h[];
+
 FIR_Direct::FIR_Direct(const double hk[], int order)
     : hm(hk), _order(order) {
     un = new double[order + 1];
@@ -23,4 +25,23 @@ FIR_Transposed::FIR_Transposed(const double hk[], int order)
     un = new double[order + 1];
     assert(un);
     for (int i = 0; i <= order; i++) un[i] = 0.0;
+}
+
+double FIR_Direct::prime(const double xin) {
+    double acc = 0.0;
+    for (int i = 0; i <= _order; i++) {
+        un[i] = xin;
+        acc = acc + hm[i] * xin;
+    }
+    return acc;
+}
+
+double FIR_Transposed::prime(const double xin) {
+    /* un[i] holds the sum of the taps from i on of the past inputs */
+    double acc = 0.0;
+    for (int i = _order; i >= 0; i--) {
+        acc = acc + hm[i] * xin;
+        un[i] = acc;
+    }
+    return acc;
 }
\ No newline at end of file
@@ -11,6 +11,7 @@
 #define FIR_hpp
 
 #include "Filter.hpp"
+#include "Fixed.hpp"
 
 class FIR_Direct : public Filter {
 private:
@@ -19,8 +20,11 @@ private:
     double *un;
 public:
     FIR_Direct(const double hk[], int order);
-    ~FIR_Direct() { delete un; }
+    FIR_Direct(const FIR_Direct&) = delete;
+    FIR_Direct& operator=(const FIR_Direct&) = delete;
+    ~FIR_Direct() { delete[] un; }
     inline double apply(const double xin);
+    double prime(const double xin);
 };
 
 inline double FIR_Direct::apply(const double xin) {
@@ -38,8 +42,11 @@ private:
     double *un;
 public:
     FIR_Transposed(const double hk[], int order);
-    ~FIR_Transposed() { delete un; }
+    FIR_Transposed(const FIR_Transposed&) = delete;
+    FIR_Transposed& operator=(const FIR_Transposed&) = delete;
+    ~FIR_Transposed() { delete[] un; }
     inline double apply(const double xin);
+    double prime(const double xin);
 };
 
 inline double FIR_Transposed::apply(const double xin) {
@@ -48,4 +55,172 @@ inline double FIR_Transposed::apply(const double xin) {
     return un[0];
 }
 
+/*
+    FIR of the fixed order N with the coefficients known at compile time,
+    given by Coeffs as a class with a static constexpr array h of N+1 elements, e.g. FIR_LowPass02.
+    The delay line is held inline twice over, so that the last N+1 samples are contiguous
+    from the newest one at any position of the ring, which lets the loop over the taps get unrolled and vectorized.
+    Symmetric coefficients, i.e. of a linear phase filter, are applied in the folded form with half the multiplies.
+*/
+#if defined(__GNUC__) && __GNUC__ >= 8
+#define FIR_UNROLL _Pragma("GCC unroll 32")
+#else
+#define FIR_UNROLL
+#endif
+
+template <int N, class Coeffs>
+constexpr bool FIR_isSymmetric() {
+    for (int i = 0; i <= N; i++) {
+        if (Coeffs::h[i] != Coeffs::h[N - i]) return false;
+    }
+    return true;
+}
+
+template <int N, class Coeffs>
+class FIR final : public Filter {
+private:
+    static_assert(N >= 0 && sizeof(Coeffs::h) == (N + 1) * sizeof(double), "Coeffs::h has not N+1 elements");
+    double un[2 * (N + 1)];
+    int pos;
+public:
+    FIR() : un(), pos(0) {}
+    inline double apply(const double xin) override;
+    double prime(const double xin) override;
+};
+
+template <int N, class Coeffs>
+inline double FIR<N, Coeffs>::apply(const double xin) {
+    pos = (pos == 0) ? N : pos - 1;
+    un[pos] = un[pos + N + 1] = xin;
+    const double *const w = un + pos;   /* w[i] is the input i samples ago */
+    double acc = 0.0;
+    if (FIR_isSymmetric<N, Coeffs>()) {
+        FIR_UNROLL
+        for (int i = 0; i < (N + 1) / 2; i++) acc += Coeffs::h[i] * (w[i] + w[N - i]);
+        if (N % 2 == 0) acc += Coeffs::h[N / 2] * w[N / 2];
+    } else {
+        FIR_UNROLL
+        for (int i = 0; i <= N; i++) acc += Coeffs::h[i] * w[i];
+    }
+    return acc;
+}
+
+template <int N, class Coeffs>
+double FIR<N, Coeffs>::prime(const double xin) {
+    for (int i = 0; i < 2 * (N + 1); i++) un[i] = xin;
+    double acc = 0.0;
+    for (int i = 0; i <= N; i++) acc += Coeffs::h[i] * xin;
+    return acc;
+}
+
+/*
+    FIR<N, Coeffs> over the lanes of FilterLanes, e.g. for R, G and B of the color sensor,
+    with the delay line of vectors so that a pass over the taps filters all the channels,
+    each coefficient multiplying the lanes at once.
+*/
+template <int N, class Coeffs>
+class FIRBank final : public FilterBank {
+private:
+    static_assert(N >= 0 && sizeof(Coeffs::h) == (N + 1) * sizeof(double), "Coeffs::h has not N+1 elements");
+    FilterLanes un[2 * (N + 1)];
+    int pos;
+public:
+    FIRBank() : un(), pos(0) {}
+    inline void apply(double x0, double x1, double x2, double x3, FilterLanes& yout) override;
+    void prime(double x0, double x1, double x2, double x3, FilterLanes& yout) override;
+};
+
+template <int N, class Coeffs>
+inline void FIRBank<N, Coeffs>::apply(double x0, double x1, double x2, double x3, FilterLanes& yout) {
+    const FilterLanes xin = { x0, x1, x2, x3 };
+    pos = (pos == 0) ? N : pos - 1;
+    un[pos] = un[pos + N + 1] = xin;
+    const FilterLanes *const w = un + pos;
+    FilterLanes acc = {};
+    if (FIR_isSymmetric<N, Coeffs>()) {
+        FIR_UNROLL
+        for (int i = 0; i < (N + 1) / 2; i++) acc += Coeffs::h[i] * (w[i] + w[N - i]);
+        if (N % 2 == 0) acc += Coeffs::h[N / 2] * w[N / 2];
+    } else {
+        FIR_UNROLL
+        for (int i = 0; i <= N; i++) acc += Coeffs::h[i] * w[i];
+    }
+    yout = acc;
+}
+
+template <int N, class Coeffs>
+void FIRBank<N, Coeffs>::prime(double x0, double x1, double x2, double x3, FilterLanes& yout) {
+    const FilterLanes xin = { x0, x1, x2, x3 };
+    FilterLanes acc = {};
+    for (int i = 0; i < 2 * (N + 1); i++) un[i] = xin;
+    for (int i = 0; i <= N; i++) acc += Coeffs::h[i] * xin;
+    yout = acc;
+}
+
+/*
+    FIR<N, Coeffs> in fixed point, of the coefficients rounded to Q15 at compile time, which are to be in [-1, 1),
+    and of the samples in fix15_t accumulated in 64 bits.
+    applyFix() of FilterFix takes and returns fix15_t for the callers in fixed point, e.g. FilteredColorSensor,
+    and apply() converts at the boundary.
+*/
+template <int N>
+struct FIR_TapsQ15 {
+    q15_t h[N + 1];
+};
+
+template <int N, class Coeffs>
+constexpr FIR_TapsQ15<N> FIR_quantize() {
+    FIR_TapsQ15<N> t = {};
+    for (int i = 0; i <= N; i++) t.h[i] = toQ15(Coeffs::h[i]);
+    return t;
+}
+
+template <int N, class Coeffs>
+class FIR_Q15 final : public Filter, public FilterFix {
+private:
+    static_assert(N >= 0 && sizeof(Coeffs::h) == (N + 1) * sizeof(double), "Coeffs::h has not N+1 elements");
+    static constexpr FIR_TapsQ15<N> taps = FIR_quantize<N, Coeffs>();
+    fix15_t un[2 * (N + 1)];
+    int pos;
+public:
+    FIR_Q15() : un(), pos(0) {}
+    inline fix15_t applyFix(const fix15_t xin) override;
+    fix15_t primeFix(const fix15_t xin) override;
+    inline double apply(const double xin) override { return fromFix15(applyFix(toFix15(xin))); }
+    double prime(const double xin) override { return fromFix15(primeFix(toFix15(xin))); }
+};
+
+template <int N, class Coeffs>
+constexpr FIR_TapsQ15<N> FIR_Q15<N, Coeffs>::taps;
+
+template <int N, class Coeffs>
+inline fix15_t FIR_Q15<N, Coeffs>::applyFix(const fix15_t xin) {
+    pos = (pos == 0) ? N : pos - 1;
+    un[pos] = un[pos + N + 1] = xin;
+    const fix15_t *const w = un + pos;
+    int64_t acc = 0;
+    if (FIR_isSymmetric<N, Coeffs>()) {
+        FIR_UNROLL
+        for (int i = 0; i < (N + 1) / 2; i++) acc += taps.h[i] * ((int64_t)w[i] + w[N - i]);
+        if (N % 2 == 0) acc += (int64_t)taps.h[N / 2] * w[N / 2];
+    } else {
+        FIR_UNROLL
+        for (int i = 0; i <= N; i++) acc += (int64_t)taps.h[i] * w[i];
+    }
+    return fix_sat32(fix_shr(acc, 15));
+}
+
+template <int N, class Coeffs>
+fix15_t FIR_Q15<N, Coeffs>::primeFix(const fix15_t xin) {
+    for (int i = 0; i < 2 * (N + 1); i++) un[i] = xin;
+    int64_t acc = 0;
+    for (int i = 0; i <= N; i++) acc += (int64_t)taps.h[i] * xin;
+    return fix_sat32(fix_shr(acc, 15));
+}
+
+/* a low-pass filter with normalized cut-off frequency of 0.2 using a function of the Hamming Window */
+struct FIR_LowPass02 {
+    static constexpr double h[5] = { 7.483914270309116e-03, 1.634745733863819e-01, 4.000000000000000e-01, 1.634745733863819e-01, 7.483914270309116e-03 };
+};
+
 #endif /* FIR_hpp */
\ No newline at end of file
@@ -6,10 +6,37 @@
 #ifndef Filter_hpp
 #define Filter_hpp
 
+#include "Fixed.hpp"
+
 class Filter {
 public:
     virtual ~Filter() {};
     virtual double apply(double xin) = 0;
+    /* fill the state as if the input had stayed at xin forever, to start without the transient,
+       and return the output in that state */
+    virtual double prime(double xin) = 0;
+};
+
+/* a filter in fixed point of the samples in fix15_t, for the callers of integers to filter without double */
+class FilterFix {
+public:
+    virtual ~FilterFix() {};
+    virtual fix15_t applyFix(fix15_t xin) = 0;
+    virtual fix15_t primeFix(fix15_t xin) = 0;
+};
+
+/* the samples of up to four channels, e.g. R, G, B and brightness, as the lanes of a vector of GCC,
+   aligned as a double only, since new of gnu++14 does not align beyond that for FIRBank holding them */
+typedef double FilterLanes __attribute__((vector_size(4 * sizeof(double)), aligned(sizeof(double))));
+
+/* filters of the channels applied together, a lane each, in a call per sample;
+   the inputs are given apart to be gathered into a vector in the registers,
+   as a vector built in memory lane by lane is slow to load back */
+class FilterBank {
+public:
+    virtual ~FilterBank() {};
+    virtual void apply(double x0, double x1, double x2, double x3, FilterLanes& yout) = 0;
+    virtual void prime(double x0, double x1, double x2, double x3, FilterLanes& yout) = 0;
 };
 
 #endif /* Filter_hpp */
\ No newline at end of file
@@ -6,31 +6,76 @@
 #include "FilteredColorSensor.hpp"
 
 FilteredColorSensor::FilteredColorSensor(ePortS port)
- : ColorSensor(port),fil_r(nullptr),fil_g(nullptr),fil_b(nullptr) {}
+ : ColorSensor(port),fil_r(nullptr),fil_g(nullptr),fil_b(nullptr),
+   fix_r(nullptr),fix_g(nullptr),fix_b(nullptr),bank(nullptr),priming(false) {}
 
 void FilteredColorSensor::setRawColorFilters(Filter *filter_r, Filter *filter_g, Filter *filter_b) {
     fil_r = filter_r;
     fil_g = filter_g;
     fil_b = filter_b;
+    priming = true;
+}
+
+void FilteredColorSensor::setRawColorFiltersFix(FilterFix *filter_r, FilterFix *filter_g, FilterFix *filter_b) {
+    fix_r = filter_r;
+    fix_g = filter_g;
+    fix_b = filter_b;
+    priming = true;
+}
+
+uint16_t FilteredColorSensor::filterFix(FilterFix *filter, uint16_t xin) const {
+    if (filter == nullptr) return xin;
+    fix15_t x = (fix15_t)xin * FIX_ONE;
+    return (uint16_t)fix_trunc(priming ? filter->primeFix(x) : filter->applyFix(x), FIX_FRAC);
+}
+
+void FilteredColorSensor::setRawColorFilterBank(FilterBank *filter_bank) {
+    bank = filter_bank;
+    priming = true;
+}
+
+void FilteredColorSensor::prime() {
+    priming = true;
 }
 
 void FilteredColorSensor::sense() {
-    rgb_raw_t original_rgb;
     ev3api::ColorSensor::getRawColor(original_rgb);
-    /* process RGB by the Filters */
+    /* process RGB by the FilterBank at once if set, otherwise by the Filters */
+    if (bank != nullptr) {
+        FilterLanes yout;
+        if (priming) {
+            bank->prime(original_rgb.r, original_rgb.g, original_rgb.b, 0.0, yout);
+        } else {
+            bank->apply(original_rgb.r, original_rgb.g, original_rgb.b, 0.0, yout);
+        }
+        filtered_rgb.r = yout[0];
+        filtered_rgb.g = yout[1];
+        filtered_rgb.b = yout[2];
+        priming = false;
+        return;
+    }
+    /* in fixed point by the FilterFix if any set */
+    if (fix_r != nullptr || fix_g != nullptr || fix_b != nullptr) {
+        filtered_rgb.r = filterFix(fix_r, original_rgb.r);
+        filtered_rgb.g = filterFix(fix_g, original_rgb.g);
+        filtered_rgb.b = filterFix(fix_b, original_rgb.b);
+        priming = false;
+        return;
+    }
     if (fil_r == nullptr) {
         filtered_rgb.r = original_rgb.r;
     } else {
-        filtered_rgb.r = fil_r->apply(original_rgb.r);
+        filtered_rgb.r = priming ? fil_r->prime(original_rgb.r) : fil_r->apply(original_rgb.r);
     }
     if (fil_g == nullptr) {
         filtered_rgb.g = original_rgb.g;
     } else {
-        filtered_rgb.g = fil_g->apply(original_rgb.g);
+        filtered_rgb.g = priming ? fil_g->prime(original_rgb.g) : fil_g->apply(original_rgb.g);
     }
     if (fil_b == nullptr) {
         filtered_rgb.b = original_rgb.b;
     } else {
-        filtered_rgb.b = fil_b->apply(original_rgb.b);
+        filtered_rgb.b = priming ? fil_b->prime(original_rgb.b) : fil_b->apply(original_rgb.b);
     }
+    priming = false;
 }
\ No newline at end of file
@@ -13,11 +13,23 @@ class FilteredColorSensor : public ev3api::ColorSensor {
 public:
     FilteredColorSensor(ePortS port);
     inline void getRawColor(rgb_raw_t &rgb) const;
+    inline void getUnfilteredColor(rgb_raw_t &rgb) const;
     void setRawColorFilters(Filter *filter_r, Filter *filter_g, Filter *filter_b);
+    /* the filters in fixed point, in place of the Filters, to filter R, G and B in integers */
+    void setRawColorFiltersFix(FilterFix *filter_r, FilterFix *filter_g, FilterFix *filter_b);
+    /* R, G and B filtered together in the lanes 0 to 2, in place of the filters per channel */
+    void setRawColorFilterBank(FilterBank *filter_bank);
     void sense();
+    /* prime the filters by the color of the next sense(), to filter from it without the transient,
+       which is done as well on the first sense() after the filters are set */
+    void prime();
 protected:
     Filter *fil_r, *fil_g, *fil_b;
-    rgb_raw_t filtered_rgb;
+    FilterFix *fix_r, *fix_g, *fix_b;
+    FilterBank *bank;
+    uint16_t filterFix(FilterFix *filter, uint16_t xin) const;
+    bool priming;
+    rgb_raw_t original_rgb, filtered_rgb;
 };
 
 inline void FilteredColorSensor::getRawColor(rgb_raw_t &rgb) const {
@@ -26,4 +38,11 @@ inline void FilteredColorSensor::getRawColor(rgb_raw_t &rgb) const {
     rgb.b = filtered_rgb.b;
 }
 
+/* raw color as sensed before the filters */
+inline void FilteredColorSensor::getUnfilteredColor(rgb_raw_t &rgb) const {
+    rgb.r = original_rgb.r;
+    rgb.g = original_rgb.g;
+    rgb.b = original_rgb.b;
+}
+
 #endif /* FilteredColorSensor_hpp */
\ No newline at end of file
@@ -5,15 +5,23 @@
 */
 #include "FilteredMotor.hpp"
 
-FilteredMotor::FilteredMotor(ePortM port) : Motor(port, true, MEDIUM_MOTOR),fil(nullptr) {}
+FilteredMotor::FilteredMotor(ePortM port) : Motor(port, true, MEDIUM_MOTOR),fil(nullptr),filFix(nullptr) {}
 
 void FilteredMotor::setPWMFilter(Filter *filter) {
     fil = filter;
+    filFix = nullptr;
+}
+
+void FilteredMotor::setPWMFilterFix(FilterFix *filter) {
+    filFix = filter;
+    fil = nullptr;
 }
 
 void FilteredMotor::drive() {
     /* process pwm by the Filter */
-    if (fil == nullptr) {
+    if (filFix != nullptr) {
+        filtered_pwm = (int)fix_trunc(filFix->applyFix(original_pwm * FIX_ONE), FIX_FRAC);
+    } else if (fil == nullptr) {
         filtered_pwm = original_pwm;
     } else {
         filtered_pwm = fil->apply(original_pwm);
@@ -15,9 +15,12 @@ public:
     inline int getPWM() const;
     inline void setPWM(int pwm);
     void setPWMFilter(Filter *filter);
+    /* the filter in fixed point, in place of the Filter, to filter the PWM in integers */
+    void setPWMFilterFix(FilterFix *filter);
     void drive();
 protected:
     Filter *fil;
+    FilterFix *filFix;
     int original_pwm, filtered_pwm;
 };
 
@@ -0,0 +1,78 @@
+/*
+    Fixed.hpp
+    Fixed-point arithmetic for the control path
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#ifndef Fixed_hpp
+#define Fixed_hpp
+
+#include <stdint.h>
+
+/*
+    The ARM9 of EV3 has no FPU, so that double costs a call to the soft-float library per operation.
+    The variants of the classes with the suffix _Q15 or _Q31 compute in integers instead:
+    the coefficients in Q15 or Q31, i.e. the fractions in [-1, 1) of 15 or 31 bits,
+    and the samples in fix15_t, 32 bits of 15 of them fractional, for the sensor values and the PWM,
+    multiplied into 64 bits and saturated on the way back to 32.
+    The conversions from double are constexpr for the constants and otherwise done once per call at the boundary.
+*/
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+typedef int32_t fix15_t;
+
+const int FIX_FRAC = 15;
+const int32_t FIX_ONE = 1 << FIX_FRAC;
+
+constexpr int64_t fix_round(double x) {
+    return (x >= 0.0) ? (int64_t)(x + 0.5) : -(int64_t)(-x + 0.5);
+}
+
+constexpr int32_t fix_sat32(int64_t x) {
+    return (x > INT32_MAX) ? INT32_MAX : (x < INT32_MIN) ? INT32_MIN : (int32_t)x;
+}
+
+constexpr q15_t toQ15(double x) {
+    return (x * 32768.0 >= INT16_MAX) ? INT16_MAX : (x <= -1.0) ? INT16_MIN : (q15_t)fix_round(x * 32768.0);
+}
+
+constexpr q31_t toQ31(double x) {
+    return (x * 2147483648.0 >= INT32_MAX) ? INT32_MAX : (x <= -1.0) ? INT32_MIN : (q31_t)fix_round(x * 2147483648.0);
+}
+
+constexpr fix15_t toFix15(double x) {
+    return (x * FIX_ONE >= INT32_MAX) ? INT32_MAX : (x <= -65536.0) ? INT32_MIN : (fix15_t)fix_round(x * FIX_ONE);
+}
+
+inline double fromFix15(fix15_t x) {
+    return x * (1.0 / FIX_ONE);
+}
+
+/* x shifted right by the bits with the rounding to the nearest */
+inline int64_t fix_shr(int64_t x, int bits) {
+    return (x + ((int64_t)1 << (bits - 1))) >> bits;
+}
+
+/* the integer part of x of the fractional bits rounded toward zero, as a cast of double to int */
+inline int64_t fix_trunc(int64_t x, int bits) {
+    return (x >= 0) ? (x >> bits) : -((-x) >> bits);
+}
+
+inline fix15_t fix_add(fix15_t a, fix15_t b) {
+    return fix_sat32((int64_t)a + b);
+}
+
+inline fix15_t fix_sub(fix15_t a, fix15_t b) {
+    return fix_sat32((int64_t)a - b);
+}
+
+/* a sample multiplied by a coefficient in Q15 */
+inline fix15_t fix_mulQ15(fix15_t x, q15_t c) {
+    return fix_sat32(fix_shr((int64_t)x * c, 15));
+}
+
+inline q31_t mulQ31(q31_t a, q31_t b) {
+    return fix_sat32(fix_shr((int64_t)a * b, 31));
+}
+
+#endif /* Fixed_hpp */
@@ -0,0 +1,86 @@
+/*
+    GainSchedule.cpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#include "GainSchedule.hpp"
+#include "Plotter.hpp"
+#include <math.h>
+#include <stdlib.h>
+
+GainSchedule::GainSchedule(const std::vector<double>& speeds, const std::vector<double>& curvatures,
+                           const std::vector<double>& p, const std::vector<double>& i, const std::vector<double>& d)
+    : speeds(speeds), curvatures(curvatures), kp(p), ki(i), kd(d) {
+    size_t n = speeds.size() * curvatures.size();
+    valid = (n > 0 && kp.size() == n && ki.size() == n && kd.size() == n);
+    for (size_t k = 1; k < speeds.size(); k++) {
+        if (speeds[k] <= speeds[k - 1]) valid = false;
+    }
+    for (size_t k = 1; k < curvatures.size(); k++) {
+        if (curvatures[k] <= curvatures[k - 1]) valid = false;
+    }
+}
+
+bool GainSchedule::isValid() const {
+    return valid;
+}
+
+/* the index of the cell of the grid and the weight of its upper edge, clamped to the grid */
+static size_t cellOf(const std::vector<double>& grid, double x, double* w) {
+    if (grid.size() == 1 || x <= grid.front()) {
+        *w = 0.0;
+        return 0;
+    }
+    if (x >= grid.back()) {
+        *w = 1.0;
+        return grid.size() - 2;
+    }
+    size_t k = 0;
+    while (x > grid[k + 1]) k++;
+    *w = (x - grid[k]) / (grid[k + 1] - grid[k]);
+    return k;
+}
+
+double GainSchedule::at(const std::vector<double>& k, double speed, double curvature) const {
+    double ws, wc;
+    size_t s = cellOf(speeds, speed, &ws);
+    size_t c = cellOf(curvatures, curvature, &wc);
+    size_t cols = curvatures.size();
+    size_t s1 = (speeds.size() > 1) ? s + 1 : s;
+    size_t c1 = (cols > 1) ? c + 1 : c;
+    double lo = k[s * cols + c] * (1.0 - wc) + k[s * cols + c1] * wc;
+    double hi = k[s1 * cols + c] * (1.0 - wc) + k[s1 * cols + c1] * wc;
+    return lo * (1.0 - ws) + hi * ws;
+}
+
+void GainSchedule::gainsAt(double speed, double curvature, double* p, double* i, double* d) const {
+    *p = at(kp, speed, curvature);
+    *i = at(ki, speed, curvature);
+    *d = at(kd, speed, curvature);
+}
+
+CurvatureEstimator::CurvatureEstimator() {
+    reset();
+}
+
+void CurvatureEstimator::reset() {
+    count = 0;
+    pos = 0;
+    last = 0.0;
+}
+
+double CurvatureEstimator::update(int32_t angL, int32_t angR) {
+    /* the oldest of the window at pos once filled */
+    int oldest = (count < WINDOW) ? 0 : pos;
+    this->angL[pos] = angL;
+    this->angR[pos] = angR;
+    pos = (pos + 1) % WINDOW;
+    if (count < WINDOW) count++;
+    int32_t dL = angL - this->angL[oldest];
+    int32_t dR = angR - this->angR[oldest];
+    if (abs(dL + dR) >= 2) {
+        /* the counts stand for the distances of the wheels alike */
+        last = fabs(2000.0 * (dL - dR) / (WHEEL_TREAD * (dL + dR)));
+    }
+    return last;
+}
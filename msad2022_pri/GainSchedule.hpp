@@ -0,0 +1,47 @@
+/*
+    GainSchedule.hpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#ifndef GainSchedule_hpp
+#define GainSchedule_hpp
+
+#include <stdint.h>
+#include <vector>
+
+/*
+    GainSchedule gives the PID gains interpolated bilinearly from a table on the grid of
+    the commanded speeds and the curvatures of the path in 1/m, both in the ascending order,
+    and clamped to the edges outside it. The gains are given row by row of a speed, a curvature each.
+*/
+class GainSchedule {
+public:
+    GainSchedule(const std::vector<double>& speeds, const std::vector<double>& curvatures,
+                 const std::vector<double>& p, const std::vector<double>& i, const std::vector<double>& d);
+    /* false if the table is not of the grid, or the grid is not ascending */
+    bool isValid() const;
+    void gainsAt(double speed, double curvature, double* p, double* i, double* d) const;
+private:
+    std::vector<double> speeds, curvatures, kp, ki, kd;
+    bool valid;
+    double at(const std::vector<double>& k, double speed, double curvature) const;
+};
+
+/*
+    CurvatureEstimator estimates the curvature of the path in 1/m from the encoder counts of the wheels
+    over the last ticks up to WINDOW, as the difference over the sum of the distances of the wheels,
+    regardless of the direction of the turn, keeping the last estimate while the wheels hardly advance.
+*/
+class CurvatureEstimator {
+public:
+    static const int WINDOW = 10;
+    CurvatureEstimator();
+    double update(int32_t angL, int32_t angR);
+    void reset();
+private:
+    int32_t angL[WINDOW], angR[WINDOW];
+    int count, pos;
+    double last;
+};
+
+#endif /* GainSchedule_hpp */
@@ -0,0 +1,78 @@
+/*
+    PIDController.cpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#include "PIDController.hpp"
+#include <assert.h>
+
+PIDController::PIDController(double p, double i, double d, int16_t t, int16_t min, int16_t max) :
+kp(p),ki(i),kd(d),tf(0.0),weight(1.0),deltaT(t),minimum(min),maximum(max) {
+    assert(t > 0 && min <= max);
+    reset();
+}
+
+void PIDController::setDerivativeFilter(double tf) {
+    assert(tf >= 0.0);
+    this->tf = tf;
+}
+
+void PIDController::setSetpointWeight(double b) {
+    weight = b;
+}
+
+void PIDController::setGains(double p, double i, double d) {
+    kp = p;
+    ki = i;
+    kd = d;
+}
+
+void PIDController::setLimits(int16_t min, int16_t max) {
+    assert(min <= max);
+    minimum = min;
+    maximum = max;
+}
+
+void PIDController::reset() {
+    integral = 0.0;
+    derivative = 0.0;
+    prevError = 0.0;
+    prevSensor = 0;
+    started = false;
+}
+
+int16_t PIDController::compute(int16_t sensor, int16_t target) {
+    return compute(sensor, target, deltaT);
+}
+
+int16_t PIDController::compute(int16_t sensor, int16_t target, int32_t dt, double feedforward) {
+    /* a tick of no time, e.g. the first, is taken as nominal */
+    double h = ((dt > 0) ? dt : deltaT) / 1000000.0;
+    double error = sensor - target;
+    if (!started) {
+        prevError = error;
+        prevSensor = sensor;
+        started = true;
+    }
+
+    /* the derivative of the measurement by the backward difference, filtered as kd s / (tf s + 1) */
+    derivative = (tf * derivative + kd * (sensor - prevSensor)) / (tf + h);
+    prevSensor = sensor;
+
+    /* the integral by the trapezoid, held back if it would wind the saturated output further */
+    double candidate = integral + ki * (prevError + error) / 2.0 * h;
+    prevError = error;
+    double p = kp * (sensor - weight * target);
+    double u = p + candidate + derivative + feedforward;
+    if (!((u > maximum && error > 0.0) || (u < minimum && error < 0.0))) {
+        integral = candidate;
+    }
+    u = p + integral + derivative + feedforward;
+
+    if (u < minimum) {
+        return minimum;
+    } else if (u > maximum) {
+        return maximum;
+    }
+    return (int16_t)u;
+}
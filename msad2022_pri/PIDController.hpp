@@ -0,0 +1,44 @@
+/*
+    PIDController.hpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#ifndef PIDController_hpp
+#define PIDController_hpp
+
+#include <stdint.h>
+
+/*
+    PIDController is PIDcalculator of the same constants and sign, i.e. of the error sensor - target,
+    with the following on top:
+    - the integral held while the output saturates in the direction of the error (conditional integration),
+    - the derivative on the measurement, so that a step of the target does not kick,
+      through a first-order low-pass filter of the time constant setDerivativeFilter() (none by default),
+    - the target weighted by setSetpointWeight() in the proportional term (1 by default),
+    - the feedforward added to the output before the saturation,
+    - the output saturated in double before it is truncated to int16_t,
+    - the elapsed time of the tick given to compute() in usec, the nominal one by default.
+    The integral is kept as the term of the output, i.e. of ki applied per tick,
+    so that setGains() changes the gains on the way without a bump, e.g. by GainSchedule.
+*/
+class PIDController {
+public:
+    PIDController(double p, double i, double d, int16_t t, int16_t min, int16_t max);
+    /* the time constant in sec, 0 for none */
+    void setDerivativeFilter(double tf);
+    void setSetpointWeight(double b);
+    void setGains(double p, double i, double d);
+    void setLimits(int16_t min, int16_t max);
+    int16_t compute(int16_t sensor, int16_t target);
+    int16_t compute(int16_t sensor, int16_t target, int32_t dt, double feedforward = 0.0);
+    void reset();
+protected:
+    double kp, ki, kd, tf, weight;
+    int16_t deltaT, minimum, maximum;
+    double integral, derivative;
+    double prevError;
+    int16_t prevSensor;
+    bool started;
+};
+
+#endif /* PIDController_hpp */
@@ -14,6 +14,7 @@ PIDcalculator::PIDcalculator(double p, double i, double d, int16_t t, int16_t mi
     minimum = min;
     maximum = max;
     traceCnt = 0;
+    integral = 0.0;
 }
 
 PIDcalculator::~PIDcalculator() {}
@@ -43,4 +44,41 @@ int16_t PIDcalculator::compute(int16_t sensor, int16_t target) {
     d = kd * (diff[1] - diff[0]) * 1000000.0 / deltaT;
 
     return math_limit(p + i + d, minimum, maximum);
-}
\ No newline at end of file
+}
+
+PIDcalculator_Q15::PIDcalculator_Q15(double p, double i, double d, int16_t t, int16_t min, int16_t max) :
+kp(toFix15(p)),ki(toFix15(i)),kd(toFix15(d * 1000000.0 / t)),kdUsec(fix_round(d * 1000000.0 * FIX_ONE)),
+halfT(toQ31(t / 2000000.0)),deltaT(t),minimum(min),maximum(max),integral(0) {
+    diff[1] = INT16_MAX; // initialize diff[1]
+}
+
+int16_t PIDcalculator_Q15::compute(int16_t sensor, int16_t target) {
+    return compute(sensor, target, deltaT);
+}
+
+int16_t PIDcalculator_Q15::compute(int16_t sensor, int16_t target, int32_t dt) {
+    if ( diff[1] == INT16_MAX ) {
+        diff[0] = diff[1] = sensor - target;
+    } else {
+        diff[0] = diff[1];
+        diff[1] = sensor - target;
+    }
+    /* the constants of the nominal tick unless it took another time, for which a division is needed */
+    bool nominal = (dt == deltaT || dt <= 0);
+    /* half of dt in Q31 sec as dt / 2000000 by 2^47 / 2000000 = 70368744.18 */
+    int64_t h = nominal ? halfT : fix_shr((int64_t)dt * 70368744, 16);
+    integral += (int64_t)(diff[0] + diff[1]) * h;
+
+    int64_t p = (int64_t)kp * diff[1];
+    int64_t i = fix_shr((int64_t)ki * fix_shr(integral, 16), 15);
+    int64_t d = nominal ? (int64_t)kd * (diff[1] - diff[0]) : kdUsec * (diff[1] - diff[0]) / dt;
+
+    /* truncated toward zero as the double to int16_t of PIDcalculator */
+    int64_t u = fix_trunc(p + i + d, FIX_FRAC);
+    if (u < minimum) {
+        return minimum;
+    } else if (u > maximum) {
+        return maximum;
+    }
+    return (int16_t)u;
+}
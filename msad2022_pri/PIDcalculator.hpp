@@ -6,6 +6,8 @@
 #ifndef PIDcalculator_hpp
 #define PIDcalculator_hpp
 
+#include "Fixed.hpp"
+
 class PIDcalculator {
 private:
     double kp, ki, kd;   /* PID constant */
@@ -18,4 +20,20 @@ public:
     ~PIDcalculator();
 };
 
+/* PIDcalculator in fixed point, of the constants in fix15_t with the time of a tick folded in,
+   the integral in Q31 seconds times the difference, and the output saturated at min and max */
+class PIDcalculator_Q15 {
+private:
+    fix15_t kp, ki, kd;     /* kd per the tick */
+    int64_t kdUsec;         /* kd per usec in fix15_t for a tick of another length */
+    q31_t halfT;            /* half the tick in seconds */
+    int16_t diff[2], deltaT, minimum, maximum;
+    int64_t integral;
+public:
+    PIDcalculator_Q15(double p, double i, double d, int16_t t, int16_t min, int16_t max);
+    int16_t compute(int16_t sensor, int16_t target);
+    /* of the elapsed time of the tick in usec */
+    int16_t compute(int16_t sensor, int16_t target, int32_t dt);
+};
+
 #endif /* PIDcalculator_hpp */
\ No newline at end of file
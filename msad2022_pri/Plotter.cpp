@@ -6,7 +6,7 @@
 #include "Plotter.hpp"
 
 Plotter::Plotter(ev3api::Motor* lm, ev3api::Motor* rm, ev3api::GyroSensor* gs) :
-distance(0.0),azimuth(0.0),locX(0.0),locY(0.0),leftMotor(lm),rightMotor(rm),gyroSensor(gs) {
+leftMotor(lm),rightMotor(rm),gyroSensor(gs),distance(0.0),azimuth(0.0),locX(0.0),locY(0.0) {
     /* reset motor encoders */
     leftMotor->reset();
     rightMotor->reset();
@@ -73,3 +73,84 @@ void Plotter::plot() {
     locX += (deltaDist * sin(azimuth));
     locY += (deltaDist * cos(azimuth));
 }
+
+namespace {
+
+/* the millimeters per the count of the two wheels, of a half of the turn of a tire */
+const q31_t DIST_Q31 = toQ31(M_PI * TIRE_DIAMETER / 720.0);
+/* the turns of the azimuth per the difference of the counts of the wheels, in 2^-48 */
+const int64_t TURN_Q48 = fix_round(TIRE_DIAMETER / (720.0 * WHEEL_TREAD) * 281474976710656.0);
+/* radians in a turn in 2^-29 */
+const uint64_t TWOPI_Q29 = (uint64_t)fix_round(M_TWOPI * 536870912.0);
+
+} // namespace
+
+q31_t Plotter_Q31::sine[(1 << SINE_BITS) + 1];
+
+/* sin of the binary angle, interpolated linearly between the entries of the table */
+q31_t Plotter_Q31::sinQ31(uint32_t bam) {
+    uint32_t i = bam >> (32 - SINE_BITS);
+    int64_t frac = (bam >> (16 - SINE_BITS)) & 0xFFFF;
+    return sine[i] + (q31_t)(((sine[i + 1] - (int64_t)sine[i]) * frac) >> 16);
+}
+
+Plotter_Q31::Plotter_Q31(ev3api::Motor* lm, ev3api::Motor* rm, ev3api::GyroSensor* gs) :
+leftMotor(lm),rightMotor(rm),gyroSensor(gs),distCount(0),turnCount(0),locX(0),locY(0),azimuth(0) {
+    /* fill the table of sin once, the only use of double */
+    if (sine[1 << (SINE_BITS - 2)] == 0) {
+        for (int i = 0; i <= (1 << SINE_BITS); i++) sine[i] = toQ31(::sin(M_TWOPI * i / (1 << SINE_BITS)));
+    }
+    /* reset motor encoders */
+    leftMotor->reset();
+    rightMotor->reset();
+    /* reset gyro sensor */
+    gyroSensor->reset();
+    /* initialize variables */
+    prevAngL = leftMotor->getCount();
+    prevAngR = rightMotor->getCount();
+}
+
+int32_t Plotter_Q31::getDistance() {
+    return (int32_t)((distCount * DIST_Q31) >> 31);
+}
+
+int16_t Plotter_Q31::getAzimuth() {
+    return (int16_t)(((uint64_t)azimuth * TWOPI_Q29) >> 61);
+}
+
+int16_t Plotter_Q31::getDegree() {
+    return (int16_t)(((uint64_t)azimuth * 360) >> 32);
+}
+
+int32_t Plotter_Q31::getLocX() {
+    return (int32_t)fix_trunc(locX, 16);
+}
+
+int32_t Plotter_Q31::getLocY() {
+    return (int32_t)fix_trunc(locY, 16);
+}
+
+int32_t Plotter_Q31::getAngL() {
+    return prevAngL;
+}
+
+int32_t Plotter_Q31::getAngR() {
+    return prevAngR;
+}
+
+void Plotter_Q31::plot() {
+    /* accumulate distance */
+    int32_t curAngL = leftMotor->getCount();
+    int32_t curAngR = rightMotor->getCount();
+    int32_t sum = (curAngL - prevAngL) + (curAngR - prevAngR);
+    distCount += (sum >= 0) ? sum : -sum;
+    /* calculate azimuth */
+    turnCount += (curAngL - prevAngL) - (curAngR - prevAngR);
+    azimuth = (uint32_t)((turnCount * TURN_Q48) >> 16);
+    prevAngL = curAngL;
+    prevAngR = curAngR;
+    /* estimate location */
+    int64_t deltaDist = fix_shr((int64_t)sum * DIST_Q31, 15);  /* in Q16 */
+    locX += fix_shr(deltaDist * sinQ31(azimuth), 31);
+    locY += fix_shr(deltaDist * sinQ31(azimuth + (1u << 30)), 31);
+}
@@ -11,6 +11,7 @@
 
 #include "GyroSensor.h"
 #include "Motor.h"
+#include "Fixed.hpp"
 
 /* M_PI and M_TWOPI is NOT available even with math header file under -std=c++11
    because they are not strictly comforming to C++11 standards
@@ -39,4 +40,32 @@ protected:
     int32_t prevAngL, prevAngR;
 };
 
+/*
+    Plotter in fixed point with the same interface:
+    the distance and the turn are kept as the sums of the encoder counts, which are exact,
+    and scaled when asked; the azimuth is a binary angle of 2^32 to a turn, wrapping around by itself,
+    and the location is integrated in Q16 millimeters with sin and cos in Q31 from a table.
+*/
+class Plotter_Q31 {
+public:
+    Plotter_Q31(ev3api::Motor* lm, ev3api::Motor* rm, ev3api::GyroSensor* gs);
+    int32_t getDistance();
+    int16_t getAzimuth();
+    int16_t getDegree();
+    int32_t getLocX();
+    int32_t getLocY();
+    int32_t getAngL();
+    int32_t getAngR();
+    void plot();
+protected:
+    static const int SINE_BITS = 12;  /* entries of the table of sin per turn in bits */
+    static q31_t sine[(1 << SINE_BITS) + 1];
+    static q31_t sinQ31(uint32_t bam);
+    ev3api::Motor *leftMotor, *rightMotor;
+    ev3api::GyroSensor *gyroSensor;
+    int64_t distCount, turnCount, locX, locY;
+    uint32_t azimuth;
+    int32_t prevAngL, prevAngR;
+};
+
 #endif /* Plotter_hpp */
\ No newline at end of file
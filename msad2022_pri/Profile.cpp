@@ -41,3 +41,16 @@ double Profile::getValueAsNum(const std::string& key) {
   }
   return std::stod(profile[key]);
 }
+
+std::vector<double> Profile::getValueAsNums(const std::string& key) {
+  std::vector<double> nums;
+  std::string value = getValueAsStr(key);
+  size_t pos = 0, next;
+  while (pos < value.length()) {
+    next = value.find(',', pos);
+    if (next == std::string::npos) next = value.length();
+    nums.push_back(std::stod(value.substr(pos, next - pos)));
+    pos = next + 1;
+  }
+  return nums;
+}
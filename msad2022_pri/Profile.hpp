@@ -8,12 +8,15 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 class Profile {
 public:
   Profile(const std::string& path);
   std::string getValueAsStr(const std::string& key);
   double getValueAsNum(const std::string& key);
+  /* the numbers separated by commas, none for a missing key */
+  std::vector<double> getValueAsNums(const std::string& key);
 private:
   std::unordered_map<std::string, std::string> profile;
 };
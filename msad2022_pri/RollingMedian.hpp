@@ -0,0 +1,95 @@
+/*
+    RollingMedian.hpp
+    Rolling Median Filter and Hampel Identifier
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#ifndef RollingMedian_hpp
+#define RollingMedian_hpp
+
+#include "Filter.hpp"
+#include <algorithm>
+#include <math.h>
+
+/*
+    RollingMedian outputs the median of the last N samples, of the samples so far until N of them arrive,
+    so that a spike shorter than the half of the window does not get through.
+    The samples are kept in the order of arrival and in the ascending order at once:
+    a new sample takes the place of the oldest in the sorted array and moves by the change of the rank only,
+    which is a step or two for a signal changing by little, and N at worst for the small N it is meant for.
+*/
+template <int N>
+class RollingMedian : public Filter {
+public:
+    RollingMedian() : count(0), pos(0) { static_assert(N >= 1, "RollingMedian of no sample"); }
+    inline double apply(const double xin) override;
+    double prime(const double xin) override;
+    double median() const;
+    /* true once N samples arrived or primed, for the callers to wait for the full window */
+    bool isFull() const { return count == N; }
+protected:
+    double ring[N];     /* in the order of arrival, the oldest at pos when filled */
+    double sorted[N];
+    int count, pos;
+};
+
+template <int N>
+inline double RollingMedian<N>::apply(const double xin) {
+    int i;
+    if (count < N) {
+        i = count++;
+    } else {
+        for (i = 0; sorted[i] != ring[pos]; i++) {}
+    }
+    sorted[i] = xin;
+    for (; i > 0 && sorted[i - 1] > xin; i--) std::swap(sorted[i - 1], sorted[i]);
+    for (; i < count - 1 && sorted[i + 1] < xin; i++) std::swap(sorted[i + 1], sorted[i]);
+    ring[pos] = xin;
+    pos = (pos + 1) % N;
+    return median();
+}
+
+template <int N>
+double RollingMedian<N>::prime(const double xin) {
+    for (int i = 0; i < N; i++) ring[i] = sorted[i] = xin;
+    count = N;
+    pos = 0;
+    return xin;
+}
+
+template <int N>
+double RollingMedian<N>::median() const {
+    if (count == 0) return 0.0;
+    return (count % 2 == 1) ? sorted[count / 2] : (sorted[count / 2 - 1] + sorted[count / 2]) / 2.0;
+}
+
+/*
+    Hampel passes a sample unless it deviates from the median of the last N samples, including itself,
+    by more than the threshold times the median absolute deviation scaled to the standard deviation,
+    in which case the median is output in place of the sample.
+    The samples pass as they are until three of them arrive, so that the callers
+    to reject a spike from the first sample are to wait for isFull().
+*/
+template <int N>
+class Hampel : public RollingMedian<N> {
+public:
+    Hampel(double threshold = 3.0) : threshold(threshold) {}
+    inline double apply(const double xin) override;
+protected:
+    double threshold;
+};
+
+template <int N>
+inline double Hampel<N>::apply(const double xin) {
+    const double m = RollingMedian<N>::apply(xin);
+    const int n = this->count;
+    if (n < 3) return xin;
+    double deviation[N];
+    for (int i = 0; i < n; i++) deviation[i] = fabs(this->sorted[i] - m);
+    std::nth_element(deviation, deviation + n / 2, deviation + n);
+    /* 1.4826 makes the median absolute deviation of the normal distribution its standard deviation */
+    const double sigma = 1.4826 * deviation[n / 2];
+    return (fabs(xin - m) > threshold * sigma) ? m : xin;
+}
+
+#endif /* RollingMedian_hpp */
@@ -0,0 +1,89 @@
+/*
+    SCurve.cpp
+    Jerk-limited filter for S-curve motion
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+
+#include "SCurve.hpp"
+#include <assert.h>
+
+SCurve::SCurve(const double accel, const double jerk) : prevXout(0.0), rate(0.0) {
+    setLimits(accel, jerk);
+}
+
+void SCurve::setLimits(const double accel, const double jerk) {
+    assert(accel >= 0.0 && jerk >= 0.0);
+    this->accel = accel;
+    this->jerk = jerk;
+}
+
+double SCurve::prime(const double xin) {
+    prevXout = xin;
+    rate = 0.0;
+    return xin;
+}
+
+double SCurve::rampTicks(const double dv) const {
+    const double v = fabs(dv);
+    if (accel == 0.0) {
+        return 0.0;
+    } else if (jerk == 0.0) {
+        return v / accel;
+    } else if (v >= accel * accel / jerk) {
+        /* the jerk up to accel and back down, with the constant acceleration in between,
+           a tick shorter than in continuous time as the rate changes at the ticks */
+        return v / accel + accel / jerk - 1.0;
+    }
+    return fmax(1.0, 2.0 * sqrt(v / jerk) - 1.0);
+}
+
+double SCurve::sumTo(const double xin) const {
+    double settled = prevXout, sum = 0.0;
+    if (jerk != 0.0 && rate != 0.0) {
+        /* the rate down by the jerk per tick over r / j ticks, r (r / j - 1) / 2 after this tick */
+        const double r = fabs(rate), ticks = r / jerk;
+        settled += ((rate < 0.0) ? -1.0 : 1.0) * fmax(0.0, r * (ticks - 1.0) / 2.0);
+        sum = ticks * (prevXout + settled) / 2.0;
+    }
+    return sum + rampTicks(xin - settled) * (settled + xin) / 2.0;
+}
+
+SCurveProfile::SCurveProfile(const double speed, const double accel, const double jerk, const double creep, const double lag) :
+scurve(accel, jerk),speed(fabs(speed)),creep(fabs(creep)),follow((lag > 0.0) ? 1.0 - exp(-1.0 / lag) : 1.0),lag(lag) {
+    assert(this->creep <= this->speed && lag >= 0.0);
+    start(0.0, 0.0);
+}
+
+void SCurveProfile::start(const double distance, const double v) {
+    this->distance = distance;
+    commanded = 0.0;
+    velocity = response = fabs(v);
+    decelerating = false;
+    arrived = false;
+    scurve.prime(velocity);
+}
+
+double SCurveProfile::next(const double traveled) {
+    const double sign = (distance < 0.0) ? -1.0 : 1.0;
+    const double rest = sign * (distance - traveled);
+    /* the distance per velocity over the ticks so far, the velocities as the motors follow them,
+       as the traveled distance is measured in coarse steps, taken at the middle of the step truncated */
+    const double gain = (commanded > 0.0) ? (sign * traveled + 0.5) / commanded : 0.0;
+    /* the motors stopped now coast by the lag times the response */
+    if (!arrived && commanded > 0.0 && rest <= gain * lag * response) {
+        arrived = true;
+    }
+    /* the distance to decelerate down to creep and coast to a stop from it, where the motors lag
+       by the lag times the response in all, with a tick of the margin as the next check may be too late */
+    if (!decelerating && commanded > 0.0 &&
+        rest <= gain * (scurve.sumTo(creep) + lag * response + velocity)) {
+        decelerating = true;
+    }
+    velocity = arrived ? 0.0 : scurve.apply(decelerating ? creep : speed);
+    /* the first-order lag discretized exactly per tick, and integrated over the tick for the distance */
+    const double last = response;
+    response += (velocity - response) * follow;
+    commanded += velocity + (last - velocity) * lag * follow;
+    return sign * velocity;
+}
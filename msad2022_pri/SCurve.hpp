@@ -0,0 +1,86 @@
+/*
+    SCurve.hpp
+    Jerk-limited filter for S-curve motion
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#ifndef SCurve_hpp
+#define SCurve_hpp
+
+#include "Filter.hpp"
+#include <math.h>
+
+/*
+    SCurve is SRLF of the acceleration limited in turn by the jerk, i.e. the change of the rate per tick,
+    for S-curve motion instead of trapezoidal one. The rate is brought down as the output approaches the input
+    so that it arrives without overshoot, by the largest rate from which the output still stops at the input
+    by the jerk, solved in a closed form per tick.
+    accel = 0.0 indicates NO limit, i.e. bypass, and jerk = 0.0 NO limit of the jerk, i.e. trapezoidal motion.
+*/
+class SCurve : public Filter {
+public:
+    SCurve(const double accel, const double jerk);
+    void setLimits(const double accel, const double jerk);
+    inline double apply(const double xin);
+    double prime(const double xin);
+    /* the ticks to change the output by dv from and to a steady state */
+    double rampTicks(const double dv) const;
+    /* the sum of the outputs until the output settles at xin from the current state, e.g. a distance by velocities,
+       of the rate brought down to 0 by the jerk first and then a ramp to xin */
+    double sumTo(const double xin) const;
+protected:
+    double accel, jerk;
+    double prevXout, rate;
+};
+
+inline double SCurve::apply(const double xin) {
+    if (accel == 0.0) { /* bypass mode */
+        prevXout = xin;
+        rate = 0.0;
+        return xin;
+    }
+
+    /* in the direction of the input from the output */
+    const double sign = (xin >= prevXout) ? 1.0 : -1.0;
+    const double e = sign * (xin - prevXout);
+    const double r = sign * rate;
+    /* no limit of the jerk is the rate reversed at once */
+    const double j = (jerk == 0.0) ? 2.0 * accel : jerk;
+    /* the rate x of the m ticks to stop at the input, m x - j m (m - 1) / 2 = e, as large as the jerk allows */
+    const double m = fmax(1.0, ceil((sqrt(1.0 + 8.0 * e / j) - 1.0) / 2.0));
+    double next = (e + j * m * (m - 1.0) / 2.0) / m;
+    next = fmin(next, fmin(r + j, accel));
+    next = fmax(next, fmax(r - j, -accel));
+    rate = sign * next;
+    prevXout += rate;
+    return prevXout;
+}
+
+/*
+    SCurveProfile gives the velocity of the motion over a distance, e.g. the PWM of a pivot by the angle,
+    accelerating by SCurve up to speed and decelerating to creep when the rest of the distance comes
+    within the distance to decelerate, estimated by the traveled distance per velocity measured on the way,
+    and giving 0 to stop once the rest comes within the distance to coast to a stop, so that the motion
+    comes to rest at the distance without overshoot. All in O(1) per tick.
+    The motors are taken to follow the velocity by the first-order lag of the time constant lag in ticks, 0 for none,
+    in motion and braked alike.
+*/
+class SCurveProfile {
+public:
+    SCurveProfile(const double speed, const double accel, const double jerk, const double creep, const double lag = 0.0);
+    /* start over from the velocity v at the traveled distance 0 */
+    void start(const double distance, const double v);
+    /* the velocity of the tick in the direction of the distance,
+       at the traveled distance measured in the counts truncated toward 0, e.g. the degree of Plotter */
+    double next(const double traveled);
+    /* true once next() gave 0 to coast to a stop at the distance */
+    bool isArrived() const { return arrived; }
+protected:
+    SCurve scurve;
+    double speed, creep;
+    const double follow, lag;
+    double distance, commanded, velocity, response;
+    bool decelerating, arrived;
+};
+
+#endif /* SCurve_hpp */
@@ -18,4 +18,28 @@ double SRLF::setRate(const double rate) {
     double currentRate = srewRate;
     srewRate = rate;
     return currentRate;
-}
\ No newline at end of file
+}
+
+double SRLF::prime(const double xin) {
+    prevXin = xin;
+    return xin;
+}
+SRLF_Q15::SRLF_Q15(const double rate) : prevXin(0) {
+    srewRate = toFix15(rate);
+}
+
+double SRLF_Q15::setRate(const double rate) {
+    assert(rate >= 0.0);
+    double currentRate = fromFix15(srewRate);
+    srewRate = toFix15(rate);
+    return currentRate;
+}
+
+fix15_t SRLF_Q15::primeFix(const fix15_t xin) {
+    prevXin = xin;
+    return xin;
+}
+
+double SRLF_Q15::prime(const double xin) {
+    return fromFix15(primeFix(toFix15(xin)));
+}
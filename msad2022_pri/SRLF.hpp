@@ -9,12 +9,14 @@
 #define SRLF_hpp
 
 #include "Filter.hpp"
+#include "Fixed.hpp"
 
 class SRLF : public Filter {
 public:
     SRLF(const double rate);
     double setRate(const double rate);
     inline double apply(const double xin);
+    double prime(const double xin);
 protected:
     double srewRate;
     double prevXin;
@@ -37,4 +39,35 @@ inline double SRLF::apply(const double xin) {
     return prevXin;
 }
 
+/* SRLF in fixed point, of the rate and the output in fix15_t, applyFix() for FilteredMotor in fixed point */
+class SRLF_Q15 : public Filter, public FilterFix {
+public:
+    SRLF_Q15(const double rate);
+    double setRate(const double rate);
+    inline fix15_t applyFix(const fix15_t xin);
+    fix15_t primeFix(const fix15_t xin);
+    inline double apply(const double xin) { return fromFix15(applyFix(toFix15(xin))); }
+    double prime(const double xin);
+protected:
+    fix15_t srewRate;
+    fix15_t prevXin;
+};
+
+inline fix15_t SRLF_Q15::applyFix(const fix15_t xin) {
+    if (srewRate == 0) { /* bypass mode */
+        prevXin = xin;
+        return xin;
+    }
+
+    fix15_t delta = fix_sub(xin, prevXin);
+    if (srewRate < delta) {
+        delta = srewRate;
+    }
+    if (-srewRate > delta) {
+        delta = -srewRate;
+    }
+    prevXin = fix_add(prevXin, delta);
+    return prevXin;
+}
+
 #endif /* SRLF_hpp */
\ No newline at end of file
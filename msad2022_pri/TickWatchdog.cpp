@@ -0,0 +1,101 @@
+/*
+    TickWatchdog.cpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#include "TickWatchdog.hpp"
+#include <stdio.h>
+#include <string.h>
+
+TickWatchdog::TickWatchdog(uint32_t p) :
+period(p),numPhases(0),qovrCounter(nullptr),started(false),ticks(0),overruns(0),worstExec(0),worstJitter(0) {
+    assert(period > 0);
+    memset(execHistogram, 0, sizeof(execHistogram));
+    memset(jitterHistogram, 0, sizeof(jitterHistogram));
+}
+
+int TickWatchdog::addPhase(const char* name, uint32_t budget) {
+    assert(numPhases < TWD_MAX_PHASES);
+    phases[numPhases] = { name, budget, 0, 0, 0, 0 };
+    return numPhases++;
+}
+
+void TickWatchdog::watchQueueOverflow(const intptr_t* counter) {
+    qovrCounter = counter;
+}
+
+void TickWatchdog::begin() {
+    HRTCNT now = fch_hrt();
+    if (started) {
+        uint32_t interval = now - tickStart;
+        uint32_t jitter = (interval > period) ? interval - period : period - interval;
+        if (jitter > worstJitter) worstJitter = jitter;
+        record(jitterHistogram, jitter, period);
+    }
+    started = true;
+    tickStart = phaseStart = now;
+    for (int i = 0; i < numPhases; i++) {
+        phases[i].duration = 0;
+    }
+}
+
+void TickWatchdog::mark(int phase) {
+    assert(phase >= 0 && phase < numPhases);
+    HRTCNT now = fch_hrt();
+    Phase& ph = phases[phase];
+    ph.duration = now - phaseStart;
+    if (ph.duration > ph.worst) ph.worst = ph.duration;
+    if (ph.duration > ph.budget) ph.overBudget++;
+    phaseStart = now;
+}
+
+void TickWatchdog::end() {
+    uint32_t exec = fch_hrt() - tickStart;
+    ticks++;
+    if (exec > worstExec) worstExec = exec;
+    record(execHistogram, exec, 2 * period);
+    if (exec > period) {
+        overruns++;
+        /* blame the phase that exceeded its budget by the most */
+        int culprit = -1;
+        int32_t worstExcess = INT32_MIN;
+        for (int i = 0; i < numPhases; i++) {
+            int32_t excess = (int32_t)(phases[i].duration - phases[i].budget);
+            if (excess > worstExcess) {
+                worstExcess = excess;
+                culprit = i;
+            }
+        }
+        if (culprit >= 0) phases[culprit].overruns++;
+    }
+}
+
+void TickWatchdog::record(uint32_t* histogram, uint32_t value, uint32_t range) {
+    uint32_t bin = (uint64_t)value * (TWD_NUM_BINS - 1) / range;
+    if (bin > TWD_NUM_BINS - 1) bin = TWD_NUM_BINS - 1;
+    histogram[bin]++;
+}
+
+void TickWatchdog::printHistogram(const char* title, const uint32_t* histogram, uint32_t range) {
+    uint32_t width = range / (TWD_NUM_BINS - 1);
+    printf("  %s histogram (usec):\n", title);
+    for (int i = 0; i < TWD_NUM_BINS - 1; i++) {
+        if (histogram[i] > 0) {
+            printf("    %6u - %6u: %u\n", i * width, (i + 1) * width - 1, histogram[i]);
+        }
+    }
+    if (histogram[TWD_NUM_BINS - 1] > 0) {
+        printf("    %6u -       : %u\n", (TWD_NUM_BINS - 1) * width, histogram[TWD_NUM_BINS - 1]);
+    }
+}
+
+void TickWatchdog::report() {
+    printf("TickWatchdog: period=%u ticks=%u overruns=%u qovr=%d worst exec=%u jitter=%u\n",
+        period, ticks, overruns, (qovrCounter != nullptr) ? (int)*qovrCounter : 0, worstExec, worstJitter);
+    for (int i = 0; i < numPhases; i++) {
+        printf("  phase %-8s budget=%6u worst=%6u over budget=%u overruns=%u\n",
+            phases[i].name, phases[i].budget, phases[i].worst, phases[i].overBudget, phases[i].overruns);
+    }
+    printHistogram("exec", execHistogram, 2 * period);
+    printHistogram("jitter", jitterHistogram, period);
+}
@@ -0,0 +1,59 @@
+/*
+    TickWatchdog.hpp
+
+    Copyright © 2022 MSAD Mode2P. All rights reserved.
+*/
+#ifndef TickWatchdog_hpp
+#define TickWatchdog_hpp
+
+#include "ev3api.h"
+
+#define TWD_MAX_PHASES  8   /* maximum number of phases in a tick */
+#define TWD_NUM_BINS    21  /* number of histogram bins, the last one counts the values beyond the range */
+
+/*
+    TickWatchdog timestamps each activation of a periodic task by the high-resolution timer
+    to find out whether the task finishes within its period.
+    usage in the periodic task:
+        watchdog->begin();
+        ... phase 0 ...
+        watchdog->mark(PHASE0);
+        ... phase 1 ...
+        watchdog->mark(PHASE1);
+        watchdog->end();
+    where the phases are registered by addPhase() in advance, each with its own budget.
+    - execution time, from begin() to end(), is recorded in a histogram over [0, 2 * period)
+    - start jitter, the deviation of the interval between begin()s from the period,
+      is recorded in a histogram over [0, period)
+    - a tick whose execution time exceeds the period is an overrun, which is attributed to
+      the phase that exceeded its budget by the most
+    - activations lost due to the queue overflow (E_QOVR) are read from the counter given to watchQueueOverflow()
+*/
+class TickWatchdog {
+public:
+    TickWatchdog(uint32_t period);
+    int addPhase(const char* name, uint32_t budget);
+    void watchQueueOverflow(const intptr_t* counter);
+    void begin();
+    void mark(int phase);
+    void end();
+    void report();
+private:
+    struct Phase {
+        const char* name;
+        uint32_t budget, duration, worst;
+        uint32_t overBudget, overruns;
+    };
+    void record(uint32_t* histogram, uint32_t value, uint32_t range);
+    void printHistogram(const char* title, const uint32_t* histogram, uint32_t range);
+    uint32_t period;
+    Phase phases[TWD_MAX_PHASES];
+    int numPhases;
+    const intptr_t* qovrCounter;
+    HRTCNT tickStart, phaseStart;
+    bool started;
+    uint32_t ticks, overruns, worstExec, worstJitter;
+    uint32_t execHistogram[TWD_NUM_BINS], jitterHistogram[TWD_NUM_BINS];
+};
+
+#endif /* TickWatchdog_hpp */
@@ -13,9 +13,17 @@ Video::Video() {
   cap.set(CAP_PROP_FPS,90);
   assert(cap.isOpened());
 #endif
+#if !defined(WITH_OPENCV)
+  frame = nullptr;
+#endif
   
   XInitThreads();
   disp = XOpenDisplay(NULL);
+  if (disp == NULL) {
+    /* no X server, e.g. run headless on the host, the video is disabled */
+    _log("cannot open display, video disabled.");
+    return;
+  }
   sc = DefaultScreenOfDisplay(disp);
   vis = DefaultVisualOfScreen(sc);
   assert(DefaultDepthOfScreen(sc) == 24);
@@ -43,16 +51,13 @@ Video::Video() {
   }
   ximg = XCreateImage(disp, vis, 24, ZPixmap, 0, (char*)gbuf, X11_FRAME_WIDTH, 2*X11_FRAME_HEIGHT, BitmapUnit(disp), 0);
   XInitImage(ximg);
-  
-#if !defined(WITH_OPENCV)
-  frame = nullptr;
-#endif
 }
 
 Video::~Video() {
 #if defined(WITH_OPENCV)
   cap.release();
 #endif
+  if (disp == NULL) return;
   XDestroyImage(ximg);
   XFreeGC(disp, gc);
   XDestroyWindow(disp, win);
@@ -67,6 +72,7 @@ void Video::capture() {
 Mat Video::readFrame() { return frame; }
 
 void Video::writeFrame(Mat f) {
+  if (disp == NULL) return;
 #if defined(WITH_OPENCV)
   if (f.empty()) return;
   if (f.size().width != FRAME_WIDTH || f.size().height != FRAME_HEIGHT) {
@@ -92,6 +98,7 @@ void Video::writeFrame(Mat f) {
 }
 
 void Video::show() {
+  if (disp == NULL) return;
   sprintf(strbuf[0], "x=%+04d,y=%+04d", plotter->getLocX(), plotter->getLocY());
   sprintf(strbuf[1], "dist=%+05d", plotter->getDistance());
   sprintf(strbuf[2], "deg=%03d,gyro=%+03d", plotter->getDegree(), gyroSensor->getAngle());
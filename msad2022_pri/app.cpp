@@ -3,8 +3,10 @@
     Copyright © 2022 MSAD Mode2P. All rights reserved.
 */
 #include "BrainTree.h"
+#include "Coroutine.hpp"
 #include "Profile.hpp"
 #include "Video.hpp"
+#include "TickWatchdog.hpp"
 /*
     BrainTree.h must present before ev3api.h on RasPike environment.
     Note that ev3api.h is included by app.h.
@@ -28,27 +30,25 @@ TouchSensor*    touchSensor;
 SonarSensor*    sonarSensor;
 FilteredColorSensor*    colorSensor;
 GyroSensor*     gyroSensor;
-SRLF*           srlfL;
+SRLF_t*         srlfL;
 FilteredMotor*  leftMotor;
-SRLF*           srlfR;
+SRLF_t*         srlfR;
 FilteredMotor*  rightMotor;
 Motor*          armMotor;
-Plotter*        plotter;
+Plotter_t*      plotter;
 Video*          video;
+TickWatchdog*   watchdog;
+/* the PID shared by TraceLine under the gain schedule, null without it */
+GainSchedule*   gainSchedule = nullptr;
+PIDController*  schedPid = nullptr;
+CurvatureEstimator* curvature = nullptr;
 
-BrainTree::BehaviorTree* tr_calibration = nullptr;
-BrainTree::BehaviorTree* tr_run         = nullptr;
-BrainTree::BehaviorTree* tr_slalom_first      = nullptr;
-BrainTree::BehaviorTree* tr_slalom_check      = nullptr;
-BrainTree::BehaviorTree* tr_slalom_second_a      = nullptr;
-BrainTree::BehaviorTree* tr_slalom_second_b      = nullptr;
-BrainTree::BehaviorTree* tr_block_r     = nullptr;
-BrainTree::BehaviorTree* tr_block_g     = nullptr;
-BrainTree::BehaviorTree* tr_block_b     = nullptr;
-BrainTree::BehaviorTree* tr_block_y     = nullptr;
-BrainTree::BehaviorTree* tr_block_d     = nullptr;
-BrainTree::BehaviorTree* tr_block_d2    = nullptr;
-State state = ST_INITIAL;
+BrainTree::StateMachine* stateMachine   = nullptr;
+
+/* activations of update task lost due to queue overflow, incremented by the kernel as configured in app.cfg */
+intptr_t upd_qovr_count = 0;
+/* phases of update task watched by TickWatchdog */
+enum { PH_SENSE, PH_PLOT, PH_SONAR, PH_LOG, PH_TREE, PH_DRIVE };
 
 /*
     === NODE CLASS DEFINITION STARTS HERE ===
@@ -85,6 +85,25 @@ public:
     }
 };
 
+/*
+    usage:
+    ".leaf<WakeUpMain>()"
+    is to wake up the main task to terminate the application.
+*/
+class WakeUpMain : public BrainTree::Node {
+public:
+    Status update() override {
+        _log("waking up main...");
+        /* wake up the main task */
+        ER ercd = wup_tsk(MAIN_TASK);
+        assert(ercd == E_OK);
+        if (ercd != E_OK) {
+            syslog(LOG_NOTICE, "wup_tsk() returned %d", ercd);
+        }
+        return Status::Success;
+    }
+};
+
 /*
     usage:
     ".leaf<IsTouchOn>()"
@@ -146,6 +165,7 @@ protected:
     usage:
     ".leaf<DetectSlalomPattern>()"
     is to determine slalom pattern from the distance between the robot and plastic bottle using ultrasonic sensor.
+    The distance goes through Hampel so that a stray echo or a timeout of a single reading does not decide the pattern.
 */
 class DetectSlalomPattern : public BrainTree::Node {
 public:
@@ -153,8 +173,12 @@ public:
     static int32_t earnedDistance;
     DetectSlalomPattern() {}
     Status update() override {
-        distance = 10 * (sonarSensor->getDistance());
+        distance = 10 * (int32_t)sonarFilter.apply(sonarSensor->getDistance());
         _log("sonar recieved distance: %d", distance);
+        /* the tree is built anew on entering the state, so that the window fills up first not to pass a stray echo */
+        if (!sonarFilter.isFull()) {
+            return Status::Running;
+        }
         if (0 < distance && distance <= 250) {
             //*ptrSlalomPattern = 1;
             isSlalomPatternA = true;
@@ -171,6 +195,7 @@ public:
     }
 protected:
     int32_t distance;
+    Hampel<5> sonarFilter;
 };
 bool DetectSlalomPattern::isSlalomPatternA = true;
 int32_t DetectSlalomPattern::earnedDistance = 0;
@@ -306,6 +331,14 @@ public:
         }
         rgb_raw_t cur_rgb;
         colorSensor->getRawColor(cur_rgb);
+        /* the median of the last three samples, not to take a spike of a sample for the color */
+        cur_rgb.r = (uint16_t)medianR.apply(cur_rgb.r);
+        cur_rgb.g = (uint16_t)medianG.apply(cur_rgb.g);
+        cur_rgb.b = (uint16_t)medianB.apply(cur_rgb.b);
+        /* the tree is built anew on entering the state, so that the window fills up first not to pass a spike */
+        if (!medianR.isFull()) {
+            return Status::Running;
+        }
 
         switch(color){
             case CL_JETBLACK:
@@ -404,6 +437,7 @@ public:
 protected:
     Color color;
     bool updated;
+    RollingMedian<3> medianR, medianG, medianB;
 };
 Color IsColorDetected::garageColor = CL_BLUE_SL;    // define default color as blue
 
@@ -418,12 +452,27 @@ Color IsColorDetected::garageColor = CL_BLUE_SL;    // define default color as b
     until the current speed gradually reaches the instructed target speed.
     trace_side = TS_NORMAL   when in R(L) course and tracing the right(left) side of the line.
     trace_side = TS_OPPOSITE when in R(L) course and tracing the left(right) side of the line.
+    The PID is given the time elapsed since the previous update(), as update_task may run late under load,
+    and filters its derivative by the time constant PID_TF in sec of profile.txt.
+    Under the gain schedule given by SCHED_* of profile.txt, p, i and d are ignored
+    and all TraceLine share a PID of the gains at the speed and the curvature of the path per tick,
+    so that the integral and the derivative carry over from a leaf to the next without a transient.
+    The PID and the curvature start over instead when the leaf traces another side or target than the last,
+    as the integral would steer the other way or off the line, or when another leaf ran in between,
+    as the derivative and the curvature would span the gap.
 */
 class TraceLine : public BrainTree::Node {
 public:
     TraceLine(int s, int t, double p, double i, double d, double srew_rate, TraceSide trace_side) : speed(s),target(t),srewRate(srew_rate),side(trace_side) {
         updated = false;
-        ltPid = new PIDcalculator(p, i, d, PERIOD_UPD_TSK, -speed, speed);
+        ltPid = nullptr;
+#if !defined(FIXED_POINT)
+        if (gainSchedule != nullptr) return;
+#endif
+        ltPid = new PIDcalculator_t(p, i, d, PERIOD_UPD_TSK, -speed, speed);
+#if !defined(FIXED_POINT)
+        ltPid->setDerivativeFilter(prof->getValueAsNum("PID_TF"));
+#endif
     }
     ~TraceLine() {
         delete ltPid;
@@ -437,7 +486,25 @@ public:
             rightMotor->setPWM(rightMotor->getPWM());
             _log("ODO=%05d, Trace run started.", plotter->getDistance());
             updated = true;
+            prevTime = ev3clock->now() - PERIOD_UPD_TSK;
+#if !defined(FIXED_POINT)
+            if (ltPid == nullptr) {
+                /* a tick late by half a period at most is taken as the next to the last leaf */
+                if (side != schedSide || target != schedTarget ||
+                    (int32_t)(prevTime + PERIOD_UPD_TSK - schedTime) > PERIOD_UPD_TSK * 3 / 2) {
+                    schedPid->reset();
+                    curvature->reset();
+                } else {
+                    prevTime = schedTime;
+                }
+                schedSide = side;
+                schedTarget = target;
+            }
+#endif
         }
+        uint32_t now = ev3clock->now();
+        int32_t dt = (int32_t)(now - prevTime);
+        prevTime = now;
 
         int16_t sensor;
         int8_t forward, turn, pwmL, pwmR;
@@ -445,11 +512,22 @@ public:
 
         colorSensor->getRawColor(cur_rgb);
         sensor = cur_rgb.r;
+        PIDcalculator_t* pid = ltPid;
+#if !defined(FIXED_POINT)
+        if (pid == nullptr) {
+            double p, i, d;
+            gainSchedule->gainsAt(speed, curvature->update(plotter->getAngL(), plotter->getAngR()), &p, &i, &d);
+            schedPid->setGains(p, i, d);
+            schedPid->setLimits(-speed, speed);
+            pid = schedPid;
+            schedTime = now;
+        }
+#endif
         /* compute necessary amount of steering by PID control */
         if (side == TS_NORMAL) {
-            turn = (-1) * _COURSE * ltPid->compute(sensor, (int16_t)target);
+            turn = (-1) * _COURSE * pid->compute(sensor, (int16_t)target, dt);
         } else { /* side == TS_OPPOSITE */
-            turn = _COURSE * ltPid->compute(sensor, (int16_t)target);
+            turn = _COURSE * pid->compute(sensor, (int16_t)target, dt);
         }
         forward = speed;
         /* steer EV3 by setting different speed to the motors */
@@ -463,11 +541,19 @@ public:
     }
 protected:
     int speed, target;
-    PIDcalculator* ltPid;
+    PIDcalculator_t* ltPid;
     double srewRate;
     TraceSide side;
     bool updated;
+    uint32_t prevTime;
+    /* the side, the target and the time of the last tick of the shared PID */
+    static TraceSide schedSide;
+    static int schedTarget;
+    static uint32_t schedTime;
 };
+TraceSide TraceLine::schedSide = TS_NORMAL;
+int TraceLine::schedTarget = 0;
+uint32_t TraceLine::schedTime = 0;
 
 /*
     usage:
@@ -514,13 +600,18 @@ protected:
     ".leaf<RotateEV3>(30, speed, srew_rate)"
     is to rotate robot 30 degrees (=clockwise) at the specified speed.
     srew_rate = 0.0 indidates NO tropezoidal motion.
-    srew_rate = 0.5 instructs FilteredMotor to change 1 pwm every two executions of update()
-    until the current speed gradually reaches the instructed target speed.
+    srew_rate = 0.5 instructs SCurveProfile to change 1 pwm every two executions of update() at most,
+    accelerating up to the speed and decelerating in time to creep into the degree,
+    with the change of the rate limited by SCURVE_JERK of profile.txt, 0 for trapezoidal motion,
+    and stopping ahead of it by the distance the robot coasts to a stop to come to rest at the degree without overshoot,
+    both by the time constant of the motors SCURVE_LAG in sec.
+    The rotation ends once the robot comes to rest, and the degree it settles at is logged.
 */
-class RotateEV3 : public BrainTree::Node {
+class RotateEV3 : public Coroutine {
 public:
-    RotateEV3(int16_t degree, int s, double srew_rate) : deltaDegreeTarget(degree),speed(s),srewRate(srew_rate) {
-        updated = false;
+    RotateEV3(int16_t degree, int s, double srew_rate) : deltaDegreeTarget(degree),speed(s),srewRate(srew_rate),
+        profile(s, srew_rate, prof->getValueAsNum("SCURVE_JERK"), fmin(s, ROT_CREEP),
+            prof->getValueAsNum("SCURVE_LAG") * 1000000.0 / PERIOD_UPD_TSK) {
         assert(degree >= -180 && degree <= 180);
         if (degree > 0) {
             clockwise = 1;
@@ -529,78 +620,108 @@ public:
         }
     }
     Status update() override {
-        if (!updated) {
-            originalDegree = plotter->getDegree();
-            srlfL->setRate(srewRate);
-            srlfR->setRate(srewRate);
-            /* stop the robot at start */
-            leftMotor->setPWM(0);
-            rightMotor->setPWM(0);
-            _log("ODO=%05d, Rotation started. Current degree = %d", plotter->getDistance(), originalDegree);
-            updated = true;
-            return Status::Running;
-        }
-
-        int16_t deltaDegree = plotter->getDegree() - originalDegree;
-        if (deltaDegree > 180) {
-            deltaDegree -= 360;
-        } else if (deltaDegree < -180) {
-            deltaDegree += 360;
-        }
-        if (clockwise * deltaDegree < clockwise * deltaDegreeTarget) {
-            if ((srewRate != 0.0) && (clockwise * deltaDegree >= clockwise * deltaDegreeTarget - 5)) {
-                /* when comes to the half-way, start decreazing the speed by tropezoidal motion */    
-                leftMotor->setPWM(clockwise * 3);
-                rightMotor->setPWM(-clockwise * 3);
+        CO_BEGIN
+        originalDegree = plotter->getDegree();
+        /* the profile shapes the PWM in place of SRLF */
+        srlfL->setRate(0.0);
+        srlfR->setRate(0.0);
+        /* stop the robot at start */
+        leftMotor->setPWM(0);
+        rightMotor->setPWM(0);
+        profile.start(deltaDegreeTarget, 0.0);
+        _log("ODO=%05d, Rotation started. Current degree = %d", plotter->getDistance(), originalDegree);
+        CO_YIELD(Status::Running);
+
+        CO_DO_UNTIL(profile.isArrived() || clockwise * deltaDegree() >= clockwise * deltaDegreeTarget, {
+            if (srewRate != 0.0) {
+                int pwm = (int)profile.next(deltaDegree());
+                leftMotor->setPWM(pwm);
+                rightMotor->setPWM(-pwm);
             } else {
                 leftMotor->setPWM(clockwise * speed);
                 rightMotor->setPWM((-clockwise) * speed);
             }
-            return Status::Running;
-        } else {
-            _log("ODO=%05d, Rotation ended. Current degree = %d", plotter->getDistance(), plotter->getDegree());
-            return Status::Success;
-        }
+        });
+        /* stop and wait for the robot to come to rest, for a second at most */
+        leftMotor->setPWM(0);
+        rightMotor->setPWM(0);
+        _log("ODO=%05d, Rotation cut off. Current degree = %d", plotter->getDistance(), plotter->getDegree());
+        stopTime = ev3clock->now();
+        prevAngL = plotter->getAngL();
+        prevAngR = plotter->getAngR();
+        restTicks = 0;
+        CO_DO_UNTIL(isAtRest() || ev3clock->now() - stopTime >= 1000000, {});
+        _log("ODO=%05d, Rotation ended. Current degree = %d", plotter->getDistance(), plotter->getDegree());
+        CO_END
     }
 private:
+    /* true when the wheels did not turn for REST_TICKS calls in a row */
+    bool isAtRest() {
+        int32_t angL = plotter->getAngL(), angR = plotter->getAngR();
+        restTicks = (angL == prevAngL && angR == prevAngR) ? restTicks + 1 : 0;
+        prevAngL = angL;
+        prevAngR = angR;
+        return restTicks >= REST_TICKS;
+    }
+    int16_t deltaDegree() const {
+        int16_t delta = plotter->getDegree() - originalDegree;
+        if (delta > 180) {
+            delta -= 360;
+        } else if (delta < -180) {
+            delta += 360;
+        }
+        return delta;
+    }
+    /* the PWM to creep into the degree at the end */
+    static const int ROT_CREEP = 3;
+    static const int REST_TICKS = 10;
     int16_t deltaDegreeTarget, originalDegree;
     int clockwise, speed;
-    bool updated;
     double srewRate;
+    SCurveProfile profile;
+    uint32_t stopTime;
+    int32_t prevAngL, prevAngR;
+    int restTicks;
 };
 
-class ClimbBoard : public BrainTree::Node { 
+class ClimbBoard : public Coroutine { 
 public:
-    ClimbBoard(int direction, int count) : dir(direction), cnt(count) {}
+    ClimbBoard(int direction, int count) : dir(direction), initialCount(count) {}
     Status update() override {
-        curAngle = gyroSensor->getAngle();
-            if (cnt >= 1) {
-                leftMotor->setPWM(0);
-                rightMotor->setPWM(0);
-                armMotor->setPWM(-50);
-                cnt++;
-                if(cnt >= 200){
-                    return Status::Success;
-                }
-                return Status::Running;
-            } else {
-                armMotor->setPWM(30);
-                leftMotor->setPWM(23);
-                rightMotor->setPWM(23);
-
-                if (curAngle < -9) {
-                    prevAngle = curAngle;
-                }
-                if (prevAngle < -9 && curAngle >= 0) {
-                    ++cnt;
-                    _log("ON BOARD");
-                }
-                return Status::Running;
+        CO_BEGIN
+        cnt = initialCount;
+        prevAngle = 0;
+        /* climb until the gyro sensor tells the robot has tilted back to level on the board */
+        while (cnt < 1) {
+            curAngle = gyroSensor->getAngle();
+            armMotor->setPWM(30);
+            leftMotor->setPWM(23);
+            rightMotor->setPWM(23);
+
+            if (curAngle < -9) {
+                prevAngle = curAngle;
+            }
+            if (prevAngle < -9 && curAngle >= 0) {
+                ++cnt;
+                _log("ON BOARD");
+            }
+            CO_YIELD(Status::Running);
+        }
+        /* then stop and pull the arm back */
+        do {
+            leftMotor->setPWM(0);
+            rightMotor->setPWM(0);
+            armMotor->setPWM(-50);
+            if (++cnt >= 200) {
+                CO_RETURN(Status::Success);
             }
+            CO_YIELD(Status::Running);
+        } while (true);
+        CO_END
     }
 private:
     int8_t dir;
-    int cnt;
+    int initialCount, cnt;
     int32_t curAngle;
     int32_t prevAngle;
 };
@@ -610,109 +731,165 @@ private:
     ".leaf<SetArmPosition>(target_degree, pwm)"
     is to shift the robot arm to the specified degree by the spefied power.
 */
-class SetArmPosition : public BrainTree::Node {
+class SetArmPosition : public Coroutine {
 public:
-    SetArmPosition(int32_t target_degree, int pwm) : targetDegree(target_degree),pwmA(pwm) {
-        updated = false;
-    }
+    SetArmPosition(int32_t target_degree, int pwm) : targetDegree(target_degree),pwmA(pwm) {}
     Status update() override {
-        int32_t currentDegree = armMotor->getCount();
-        if (!updated) {
-            _log("ODO=%05d, Arm position is moving from %d to %d.", plotter->getDistance(), currentDegree, targetDegree);
-            if (currentDegree == targetDegree) {
-                return Status::Success; /* do nothing */
-            } else if (currentDegree < targetDegree) {
-                clockwise = 1;
-            } else {
-                clockwise = -1;
-            }
-            armMotor->setPWM(clockwise * pwmA);
-            updated = true;
-            return Status::Running;
-        }
-        if (((clockwise ==  1) && (currentDegree >= targetDegree)) ||
-            ((clockwise == -1) && (currentDegree <= targetDegree))) {
-            armMotor->setPWM(0);
-            _log("ODO=%05d, Arm position set to %d.", plotter->getDistance(), currentDegree);
-            return Status::Success;
+        CO_BEGIN
+        _log("ODO=%05d, Arm position is moving from %d to %d.", plotter->getDistance(), armMotor->getCount(), targetDegree);
+        if (armMotor->getCount() == targetDegree) {
+            CO_RETURN(Status::Success); /* do nothing */
+        } else if (armMotor->getCount() < targetDegree) {
+            clockwise = 1;
         } else {
-            return Status::Running;
+            clockwise = -1;
         }
+        armMotor->setPWM(clockwise * pwmA);
+        CO_YIELD(Status::Running);
+
+        CO_AWAIT(clockwise * armMotor->getCount() >= clockwise * targetDegree);
+        armMotor->setPWM(0);
+        _log("ODO=%05d, Arm position set to %d.", plotter->getDistance(), armMotor->getCount());
+        CO_END
     }
 private:
     int32_t targetDegree;
     int pwmA, clockwise;
-    bool updated;
 };
 
 /*
-    === NODE CLASS DEFINITION ENDS HERE ===
+    Maneuver is the base of scripted maneuvers, each of which runs a series of legs in a single leaf
+    instead of a MemSequence of ParallelWatch{IsXxxEarned, RunAsInstructed} pairs.
+    usage in update() of a derived class:
+        startLeg(); CO_DO_UNTIL(traveled() >= dist, run(pwm_l, pwm_r, srew_rate));
+    where the condition can be elapsed() in microsecond, traveled() in millimeter or turned() in degree
+    measured since startLeg(), and run() behaves as RunAsInstructed does.
 */
+class Maneuver : public Coroutine {
+protected:
+    void startLeg() {
+        legTime = ev3clock->now();
+        legDist = plotter->getDistance();
+        legDegree = plotter->getDegree();
+        /* The following code chunk is to properly set prevXin in SRLF */
+        srlfL->setRate(0.0);
+        leftMotor->setPWM(leftMotor->getPWM());
+        srlfR->setRate(0.0);
+        rightMotor->setPWM(rightMotor->getPWM());
+        _log("ODO=%05d, Leg %d started.", legDist, ++leg);
+    }
+    int32_t elapsed() const { return ev3clock->now() - legTime; }
+    int32_t traveled() const { return plotter->getDistance() - legDist; }
+    int16_t turned() const {
+        int16_t delta = plotter->getDegree() - legDegree;
+        if (delta > 180) {
+            delta -= 360;
+        } else if (delta < -180) {
+            delta += 360;
+        }
+        return delta;
+    }
+    void run(int pwm_l, int pwm_r, double srew_rate) {
+        if (_COURSE == -1) {
+            int pwm = pwm_l;
+            pwm_l = pwm_r;
+            pwm_r = pwm;
+        }
+        srlfL->setRate(srew_rate);
+        leftMotor->setPWM(pwm_l);
+        srlfR->setRate(srew_rate);
+        rightMotor->setPWM(pwm_r);
+    }
+    void initialize() override {
+        Coroutine::initialize();
+        leg = 0;
+    }
+    uint64_t legTime;
+    int32_t legDist;
+    int16_t legDegree;
+    int leg;
+};
 
+/*
+    usage:
+    ".leaf<ApproachBottles>()"
+    is to back off after the color check on the board and turn to face the plastic bottles.
+*/
+class ApproachBottles : public Maneuver {
+public:
+    Status update() override {
+        CO_BEGIN
+        //move back
+        startLeg(); CO_DO_UNTIL(elapsed() >= 600000, run(-40, -40, 0.0)); //param SJ:700000,IS:550000,600000
+        //rotate left with left wheel
+        startLeg(); CO_DO_UNTIL(elapsed() >= 300000, run(-40, 0, 0.0)); //param SJ:500000,IS:500000,200000,350000,300000
+        //move foward
+        startLeg(); CO_DO_UNTIL(elapsed() >= 450000, run(50, 50, 0.0)); //param SJ:450000,IS:350000,450000
+        //turn left with right wheel
+        startLeg(); CO_DO_UNTIL(elapsed() >= 760000, run(0, 50, 0.0)); //param SJ：1350000,IS:820000,760000
+        CO_END
+    }
+};
 
-/* a cyclic handler to activate a task */
-void task_activator(intptr_t tskid) {
-    ER ercd = act_tsk(tskid);
-    assert(ercd == E_OK || E_QOVR);
-    if (ercd != E_OK) {
-        syslog(LOG_NOTICE, "act_tsk() returned %d", ercd);
+/*
+    usage:
+    ".leaf<SlalomSecondA>()"
+    is to run the latter half of the slalom for the pattern A.
+*/
+class SlalomSecondA : public Maneuver {
+public:
+    Status update() override {
+        CO_BEGIN
+        //後半第一スラローム開始
+        startLeg(); CO_DO_UNTIL(traveled() >= 30, run(-40, 0, 0.0));
+        startLeg(); CO_DO_UNTIL(traveled() >= 50, run(40, 40, 0.0));
+        startLeg(); CO_DO_UNTIL(traveled() >= 20, run(-40, 0, 0.0));
+        startLeg(); CO_DO_UNTIL(traveled() >= 50, run(40, 40, 0.0));
+        //後半第二スラローム開始
+        startLeg(); CO_DO_UNTIL(traveled() >= 200, run(50, 15, 0.0));
+        CO_END
     }
-}
+};
 
-/* The main task */
-void main_task(intptr_t unused) {
-    // temp fix 2022/6/20 W.Taniguchi, as Bluetooth not implemented yet
-    //bt = ev3_serial_open_file(EV3_SERIAL_BT);
-    //assert(bt != NULL);
-    /* create and initialize EV3 objects */
-    ev3clock    = new Clock();
-    video       = new Video();
-    touchSensor = new TouchSensor(PORT_1);
-    // temp fix 2022/6/20 W.Taniguchi, new SonarSensor() blocks apparently
-    sonarSensor = new SonarSensor(PORT_3);
-    colorSensor = new FilteredColorSensor(PORT_2);
-    gyroSensor  = new GyroSensor(PORT_4);
-    leftMotor   = new FilteredMotor(PORT_C);
-    rightMotor  = new FilteredMotor(PORT_B);
-    armMotor    = new Motor(PORT_A);
-    plotter     = new Plotter(leftMotor, rightMotor, gyroSensor);
-    /* read profile file and make the profile object ready */
-    prof        = new Profile("msad2022_pri/profile.txt");
-    /* determine the course L or R */
-    if (prof->getValueAsStr("COURSE") == "R") {
-      _COURSE = -1;
-    } else {
-      _COURSE = 1;
+/*
+    usage:
+    ".leaf<SlalomSecondB>()"
+    is to run the latter half of the slalom for the pattern B.
+*/
+class SlalomSecondB : public Maneuver {
+public:
+    Status update() override {
+        CO_BEGIN
+        //後半第一スラローム開始
+        startLeg(); CO_DO_UNTIL(traveled() >= 50, run(40, 40, 0.0));
+        startLeg(); CO_DO_UNTIL(traveled() >= 110, run(20, 50, 0.0)); //param SJ:100, SJ:20,50
+        //後半第二スラローム開始
+        startLeg(); CO_DO_UNTIL(traveled() >= 20, run(40, 40, 0.0));
+        //カーブを分割すると綺麗になる
+        startLeg(); CO_DO_UNTIL(traveled() >= 40, run(20, 50, 0.0));
+        startLeg(); CO_DO_UNTIL(traveled() >= 250, run(40, 40, 0.0));
+        startLeg(); CO_DO_UNTIL(traveled() >= 120, run(50, 20, 0.0)); //param IS:150
+        startLeg(); CO_DO_UNTIL(traveled() >= 30, run(40, 40, 0.0));
+        startLeg(); CO_DO_UNTIL(traveled() >= 100, run(50, 20, 0.0)); //param IS:150
+        startLeg(); CO_DO_UNTIL(traveled() >= 100, run(40, 40, 0.0));
+        CO_END
     }
- 
-    /* FIR parameters for a low-pass filter with normalized cut-off frequency of 0.2
-        using a function of the Hamming Window */
-    const int FIR_ORDER = 4; 
-    const double hn[FIR_ORDER+1] = { 7.483914270309116e-03, 1.634745733863819e-01, 4.000000000000000e-01, 1.634745733863819e-01, 7.483914270309116e-03 };
-    /* set filters to FilteredColorSensor */
-    Filter *lpf_r = new FIR_Transposed(hn, FIR_ORDER);
-    Filter *lpf_g = new FIR_Transposed(hn, FIR_ORDER);
-    Filter *lpf_b = new FIR_Transposed(hn, FIR_ORDER);
-    colorSensor->setRawColorFilters(lpf_r, lpf_g, lpf_b);
+};
 
-    gyroSensor->reset();
-    leftMotor->reset();
-    srlfL = new SRLF(0.0);
-    leftMotor->setPWMFilter(srlfL);
-    leftMotor->setPWM(0);
-    rightMotor->reset();
-    srlfR = new SRLF(0.0);
-    rightMotor->setPWMFilter(srlfR);
-    rightMotor->setPWM(0);
-    armMotor->reset();
+/*
+    === NODE CLASS DEFINITION ENDS HERE ===
+*/
 
 /*
     === BEHAVIOR TREE DEFINITION STARTS HERE ===
     A Behavior Tree serves as a blueprint for a LEGO object while a Node class serves as each Lego block used in the object.
+    Each tree is defined as a factory function so that the state machine builds the tree only when its state is entered
+    and destroys it when the state is left.
 */
 
-    /* robot starts when touch sensor is turned on */
-    tr_calibration = (BrainTree::BehaviorTree*) BrainTree::Builder()
+/* robot starts when touch sensor is turned on */
+BrainTree::Node* tr_calibration() {
+    return BrainTree::Builder()
         .composite<BrainTree::MemSequence>()
             // temp fix 2022/6/20 W.Taniguchi, as no touch sensor available on RasPike
             //.decorator<BrainTree::UntilSuccess>()
@@ -721,48 +898,29 @@ void main_task(intptr_t unused) {
             .leaf<ResetClock>()
         .end()
     .build();
+}
 
-/*
-    DEFINE ROBOT BEHAVIOR AFTER START
-    FOR THE RIGHT AND LEFT COURSE SEPARATELY
-
-    if (prof->getValueAsStr("COURSE") == "R") {
-    } else {
+BrainTree::Node* tr_run() {
+    /* BEHAVIOR FOR THE RIGHT COURSE */
+    if (_COURSE == -1) {
+        return BrainTree::Builder()
+            .composite<BrainTree::MemSequence>()
+                .composite<BrainTree::ParallelWatch>()
+                    .leaf<IsDistanceEarned>(2000)
+                    .leaf<TraceLine>(prof->getValueAsNum("SPEED"),
+                                     prof->getValueAsNum("GS_TARGET"),
+                                     prof->getValueAsNum("P_CONST"),
+                                     prof->getValueAsNum("I_CONST"),
+                                     prof->getValueAsNum("D_CONST"), 0.0, TS_NORMAL)
+                .end()
+                .leaf<StopNow>()
+            .end()
+        .build();
     }
-*/ 
 
-    /* BEHAVIOR FOR THE RIGHT COURSE STARTS HERE */
-    if (prof->getValueAsStr("COURSE") == "R") {
-      _COURSE = -1;
-
-      tr_run = (BrainTree::BehaviorTree*) BrainTree::Builder()
-        .composite<BrainTree::ParallelSequence>(1,2)
-            .leaf<TraceLine>(prof->getValueAsNum("SPEED"),
-			     prof->getValueAsNum("GS_TARGET"),
-			     prof->getValueAsNum("P_CONST"),
-			     prof->getValueAsNum("I_CONST"),
-			     prof->getValueAsNum("D_CONST"), 0.0, TS_NORMAL)
-	    .leaf<IsDistanceEarned>(2000)
-        .end()
-      .build();
-      tr_slalom_first = nullptr;
-      tr_slalom_check = nullptr;
-      tr_slalom_second_a = nullptr;
-      tr_slalom_second_b = nullptr;
-      tr_block_r     = nullptr;
-      tr_block_g     = nullptr;
-      tr_block_b     = nullptr;
-      tr_block_y     = nullptr;
-      tr_block_d     = nullptr;
-      tr_block = (BrainTree::BehaviorTree*) BrainTree::Builder()
-	    .leaf<StopNow>()
-	  .build();
-
-    } else { /* BEHAVIOR FOR THE LEFT COURSE STARTS HERE */
-      _COURSE = 1;
-
-      tr_run = (BrainTree::BehaviorTree*) BrainTree::Builder()
-        .composite<BrainTree::ParallelSequence>(1,2)
+    /* BEHAVIOR FOR THE LEFT COURSE */
+    return BrainTree::Builder()
+        .composite<BrainTree::ParallelWatch>()
             .leaf<IsBackOn>()
             .composite<BrainTree::MemSequence>()
     //GATE1を通過後ラインの交差地点地点直前まで
@@ -778,7 +936,7 @@ void main_task(intptr_t unused) {
                    //prof->getValueAsNum("srewrate1"), TS_OPPOSITE)//ライントレース1,右のライン検知
                 .end()
     //ラインの交差地点直前から検知するまで減速
-                .composite<BrainTree::ParallelSequence>(1,2)
+                .composite<BrainTree::ParallelWatch>()
                    .leaf<IsColorDetected>(CL_JETBLACK_YMNK)//JETBLACKを検知
                    .leaf<IsTimeEarned>(prof->getValueAsNum("TIME1"))//18秒
                    .leaf<TraceLine>(prof->getValueAsNum("SPEED1a"), 
@@ -796,18 +954,18 @@ void main_task(intptr_t unused) {
                    prof->getValueAsNum("POWER_R1a"), 0.0)
                 .end()
     //ゆるやかに右カーブ
-                .composite<BrainTree::ParallelSequence>(1,2)
+                .composite<BrainTree::ParallelWatch>()
                    .leaf<IsTimeEarned>(prof->getValueAsNum("TIME1aa"))
                    .leaf<RunAsInstructed>(prof->getValueAsNum("POWER_L1aa"),
                    prof->getValueAsNum("POWER_R1aa"), prof->getValueAsNum("srewrate1aa"))
                 .end()
     //ライン検知するまでさらに緩やかに右カーブ
-                .composite<BrainTree::ParallelSequence>(1,2)
+                .composite<BrainTree::ParallelWatch>()
                    .leaf<IsColorDetected>(CL_BLACK)
                    .leaf<RunAsInstructed>(65,40, 0.0)
                 .end()
     //ライン検知後にトレースを補正するために2秒速度を落とす
-                .composite<BrainTree::ParallelSequence>(1,2)
+                .composite<BrainTree::ParallelWatch>()
                    .leaf<IsTimeEarned>(prof->getValueAsNum("TIME2"))
                    .leaf<TraceLine>(prof->getValueAsNum("SPEED2"),  
                    prof->getValueAsNum("GS_TARGET1"), prof->getValueAsNum("P_CONST1"), 
@@ -815,7 +973,7 @@ void main_task(intptr_t unused) {
                    prof->getValueAsNum("D_CONST1"), 0.0, TS_NORMAL)//ライントレース2,左のライン検知
                 .end()
     //ゲート2,3通過後にラインの交差点直前まで
-                .composite<BrainTree::ParallelSequence>(1,2)
+                .composite<BrainTree::ParallelWatch>()
                    .leaf<IsColorDetected>(CL_JETBLACK_YMNK)
                    .leaf<IsTimeEarned>(prof->getValueAsNum("TIME2a"))
                    .leaf<TraceLine>(prof->getValueAsNum("SPEED2a"), 
@@ -824,7 +982,7 @@ void main_task(intptr_t unused) {
                    prof->getValueAsNum("D_CONST1"), 0.0, TS_NORMAL)//ライントレース2a,左のライン検知
                 .end()
     //ラインの交差点検知まで
-                .composite<BrainTree::ParallelSequence>(1,2)
+                .composite<BrainTree::ParallelWatch>()
                    .leaf<IsColorDetected>(CL_JETBLACK_YMNK)
                    .leaf<IsTimeEarned>(prof->getValueAsNum("TIME2a"))
                    .leaf<TraceLine>(prof->getValueAsNum("SPEED2aa"), 
@@ -833,20 +991,20 @@ void main_task(intptr_t unused) {
                    prof->getValueAsNum("D_CONST1"), 0.0, TS_NORMAL)//ライントレース2aa,左のライン検知
                 .end()
     //ライン交差点検知後に緩やかに左カーブ
-                .composite<BrainTree::ParallelSequence>(1,2)
+                .composite<BrainTree::ParallelWatch>()
                    .leaf<IsTimeEarned>(prof->getValueAsNum("TIME3"))
                    .leaf<RunAsInstructed>(prof->getValueAsNum("POWER_L3"),
                    prof->getValueAsNum("POWER_R3"), 0.0)
                 .end()
     //ライン検知するまで緩やかに右カーブ
-                .composite<BrainTree::ParallelSequence>(1,2)
+                .composite<BrainTree::ParallelWatch>()
                    .leaf<IsTimeEarned>(prof->getValueAsNum("TIME3a"))
                    .leaf<IsColorDetected>(CL_BLACK)
                    .leaf<RunAsInstructed>(prof->getValueAsNum("POWER_L4"),
                    prof->getValueAsNum("POWER_R4"), 0.0)
                 .end()
     //ライン検知後にトレースを補正するために1.9秒速度を落とす
-                .composite<BrainTree::ParallelSequence>(1,2)
+                .composite<BrainTree::ParallelWatch>()
                    .leaf<IsTimeEarned>(prof->getValueAsNum("TIME2"))
                    .leaf<TraceLine>(prof->getValueAsNum("SPEED2"),
                    prof->getValueAsNum("GS_TARGET1"), prof->getValueAsNum("P_CONST1"), 
@@ -854,7 +1012,7 @@ void main_task(intptr_t unused) {
                    prof->getValueAsNum("D_CONST1"), 0.0, TS_OPPOSITE)//ライントレース2,右のライン検知
                 .end()
     //2回カーブまでライントレース
-                .composite<BrainTree::ParallelSequence>(1,2)
+                .composite<BrainTree::ParallelWatch>()
                    .leaf<IsTimeEarned>(prof->getValueAsNum("TIME4"))
                    .leaf<TraceLine>(prof->getValueAsNum("SPEED4"),
                    prof->getValueAsNum("GS_TARGET1"), prof->getValueAsNum("P_CONST1"), 
@@ -862,7 +1020,7 @@ void main_task(intptr_t unused) {
                    prof->getValueAsNum("D_CONST1"), 0.0, TS_OPPOSITE)//ライントレース4,右のライン検知
                 .end()
     //最終カーブまでライントレース
-                .composite<BrainTree::ParallelSequence>(1,2)
+                .composite<BrainTree::ParallelWatch>()
                    .leaf<IsTimeEarned>(prof->getValueAsNum("TIME5"))
                    .leaf<TraceLine>(prof->getValueAsNum("SPEED5"),
                    prof->getValueAsNum("GS_TARGET1"), prof->getValueAsNum("P_CONST1"), 
@@ -871,7 +1029,7 @@ void main_task(intptr_t unused) {
                    prof->getValueAsNum("srewrate3"), TS_OPPOSITE)//ライントレース5,右のライン検知
                 .end()
     //スラロームに引き渡すまでライントレース
-                .composite<BrainTree::ParallelSequence>(1,2)
+                .composite<BrainTree::ParallelWatch>()
                    .composite<BrainTree::MemSequence>()
                       .leaf<IsColorDetected>(CL_BLACK)
                       .leaf<IsColorDetected>(CL_BLUE)
@@ -884,17 +1042,19 @@ void main_task(intptr_t unused) {
             .end()
         .end()
     .build();
+}
 
-    tr_slalom_first = (BrainTree::BehaviorTree*) BrainTree::Builder()
-        .composite<BrainTree::ParallelSequence>(1,2)
+BrainTree::Node* tr_slalom_first() {
+    return BrainTree::Builder()
+        .composite<BrainTree::ParallelWatch>()
             .leaf<IsBackOn>()
             .composite<BrainTree::MemSequence>()
                 // ライントレースから引継ぎして、直前の青線まで走る
-                .composite<BrainTree::ParallelSequence>(1,2)
+                .composite<BrainTree::ParallelWatch>()
                    .leaf<IsTimeEarned>(1000000)
                    .leaf<TraceLine>(45, GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_OPPOSITE)
                 .end()
-                .composite<BrainTree::ParallelSequence>(1,2)
+                .composite<BrainTree::ParallelWatch>()
                    .composite<BrainTree::MemSequence>()
                       .leaf<IsColorDetected>(CL_BLACK)
                       .leaf<IsColorDetected>(CL_BLUE)
@@ -902,7 +1062,7 @@ void main_task(intptr_t unused) {
                    .leaf<TraceLine>(35, GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_OPPOSITE)
                 .end()
                 // 台にのる　勢いが必要
-                .composite<BrainTree::ParallelSequence>(1,2)
+                .composite<BrainTree::ParallelWatch>()
 //                    .leaf<IsDistanceEarned>(150)
                     .leaf<IsTimeEarned>(150000)
                     .leaf<RunAsInstructed>(70, 70, 0.0)
@@ -922,74 +1082,74 @@ void main_task(intptr_t unused) {
                    .leaf<TraceLine>(45, GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_OPPOSITE)
                 .end()
 */
-                .composite<BrainTree::ParallelSequence>(1,2)//初期位置調整のために、台上で短距離ライントレース
+                .composite<BrainTree::ParallelWatch>()//初期位置調整のために、台上で短距離ライントレース
                     .leaf<IsDistanceEarned>(30)
                     .leaf<TraceLine>(30, GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_OPPOSITE)
                     //.leaf<RunAsInstructed>(40, 20, 0.0)
                 .end()
-                .composite<BrainTree::ParallelSequence>(1,2)//第一スラローム開始
+                .composite<BrainTree::ParallelWatch>()//第一スラローム開始
                     .leaf<IsDistanceEarned>(100)
                     .leaf<RunAsInstructed>(20, 50, 0.0)
                 .end()
-                .composite<BrainTree::ParallelSequence>(1,2)
+                .composite<BrainTree::ParallelWatch>()
                     .leaf<IsDistanceEarned>(30)
                     .leaf<RunAsInstructed>(30, 30, 0.0)
                 .end()
-                .composite<BrainTree::ParallelSequence>(1,2)//第二スラローム開始
+                .composite<BrainTree::ParallelWatch>()//第二スラローム開始
                     .leaf<IsDistanceEarned>(120)
                     .leaf<RunAsInstructed>(60, 15, 0.0)
                 .end()
-                .composite<BrainTree::ParallelSequence>(1,2)
+                .composite<BrainTree::ParallelWatch>()
                     .leaf<IsDistanceEarned>(30)
                     .leaf<RunAsInstructed>(15, 40, 0.0)
                 .end()
-                .composite<BrainTree::ParallelSequence>(1,2)
+                .composite<BrainTree::ParallelWatch>()
                     .leaf<IsDistanceEarned>(10)
                     .leaf<RunAsInstructed>(30, 30, 0.0)
                 .end()
-                .composite<BrainTree::ParallelSequence>(1,2)
+                .composite<BrainTree::ParallelWatch>()
                     .leaf<IsDistanceEarned>(70)
                     .leaf<RunAsInstructed>(40, 15, 0.0)
                 .end()
-                .composite<BrainTree::ParallelSequence>(1,2)//黒検知したらライントレース
+                .composite<BrainTree::ParallelWatch>()//黒検知したらライントレース
                     .leaf<IsColorDetected>(CL_BLACK)
                     .leaf<RunAsInstructed>(30, 20, 0.0)
                 .end()
-                .composite<BrainTree::ParallelSequence>(1,2)
+                .composite<BrainTree::ParallelWatch>()
                     .leaf<IsDistanceEarned>(160)
                     .leaf<TraceLine>(30, 47, P_CONST, I_CONST, D_CONST, 0.0, TS_OPPOSITE)
                 .end()
-                .composite<BrainTree::ParallelSequence>(1,2)//ライントレースおもてなし
+                .composite<BrainTree::ParallelWatch>()//ライントレースおもてなし
                     .leaf<IsDistanceEarned>(20)
                     .leaf<RunAsInstructed>(15, 50, 0.0)
                 .end()
-                .composite<BrainTree::ParallelSequence>(1,2)
+                .composite<BrainTree::ParallelWatch>()
                     .leaf<IsDistanceEarned>(20)
                     .leaf<RunAsInstructed>(50, 15, 0.0)
                 .end()
-                .composite<BrainTree::ParallelSequence>(1,2)//第三スラローム開始 ライントレース
+                .composite<BrainTree::ParallelWatch>()//第三スラローム開始 ライントレース
                     .leaf<IsDistanceEarned>(160)
                     .leaf<TraceLine>(30, 47, P_CONST, I_CONST, D_CONST, 0.0, TS_NORMAL)
                 .end()
-                .composite<BrainTree::ParallelSequence>(1,2)//第三スラローム開始 ライントレース
+                .composite<BrainTree::ParallelWatch>()//第三スラローム開始 ライントレース
                     //.leaf<IsDistanceEarned>(50)
                     .leaf<IsSonarOn>(500)//超音波センサー＆ライトレースによるチェックポイント
                     .leaf<TraceLine>(30, 47, P_CONST, I_CONST, D_CONST, 0.0, TS_NORMAL)
                 .end()
-                .composite<BrainTree::ParallelSequence>(1,2)//ガレージカードスラローム開始
+                .composite<BrainTree::ParallelWatch>()//ガレージカードスラローム開始
                     .leaf<IsDistanceEarned>(90)
                     .leaf<RunAsInstructed>(50, 15, 0.0)
                 .end()
-                .composite<BrainTree::ParallelSequence>(1,2)
+                .composite<BrainTree::ParallelWatch>()
                     .leaf<IsDistanceEarned>(80)
                     .leaf<RunAsInstructed>(30, 30, 0.0)
                 .end()
-                .composite<BrainTree::ParallelSequence>(1,2)
+                .composite<BrainTree::ParallelWatch>()
                     .leaf<IsDistanceEarned>(60)
                     .leaf<RunAsInstructed>(15, 50, 0.0)
                 .end()
                 // 色検知
-                .composite<BrainTree::ParallelSequence>(1,2)
+                .composite<BrainTree::ParallelWatch>()
                     //.leaf<IsDistanceEarned>(50)
                     .leaf<IsColorDetected>(CL_BLUE_SL)
                     .leaf<IsColorDetected>(CL_RED_SL)
@@ -1000,46 +1160,30 @@ void main_task(intptr_t unused) {
             .end()
         .end()
     .build();
-    
-    //台上転回後、センサーでコースパターン判定
-    tr_slalom_check = (BrainTree::BehaviorTree*) BrainTree::Builder()
-        .composite<BrainTree::ParallelSequence>(1,2)
+}
+
+//台上転回後、センサーでコースパターン判定
+BrainTree::Node* tr_slalom_check() {
+    return BrainTree::Builder()
+        .composite<BrainTree::ParallelWatch>()
             .leaf<IsBackOn>()
             .composite<BrainTree::MemSequence>()
                 // 色検知 for test
-                .composite<BrainTree::ParallelSequence>(1,2)
+                .composite<BrainTree::ParallelRace>()
                     .leaf<IsColorDetected>(CL_BLUE_SL)
                     .leaf<IsColorDetected>(CL_RED_SL)
                     .leaf<IsColorDetected>(CL_YELLOW_SL)
                     .leaf<IsColorDetected>(CL_GREEN_SL)
                     .leaf<IsTimeEarned>(100000)
                 .end()
-                //move back
-                .composite<BrainTree::ParallelSequence>(1,2)
-                    .leaf<IsTimeEarned>(600000) //param SJ:700000,IS:550000,600000
-                    .leaf<RunAsInstructed>(-40, -40, 0.0)
-                .end()
-                //rotate left with left wheel
-                .composite<BrainTree::ParallelSequence>(1,2)
-                    .leaf<IsTimeEarned>(300000) //param SJ:500000,IS:500000,200000,350000,300000
-                    .leaf<RunAsInstructed>(-40, 0, 0.0) 
-                .end()
-                //move foward
-                .composite<BrainTree::ParallelSequence>(1,2)
-                    .leaf<IsTimeEarned>(450000) //param SJ:450000,IS:350000,450000
-                    .leaf<RunAsInstructed>(50, 50, 0.0)
-                .end()
-                //turn left with right wheel
-                .composite<BrainTree::ParallelSequence>(1,2)
-                    .leaf<IsTimeEarned>(760000) //param SJ：1350000,IS:820000,760000
-                    .leaf<RunAsInstructed>(0, 50, 0.0)
-                .end()
+                //move back, rotate left, move forward and turn left to face the bottles
+                .leaf<ApproachBottles>()
                 //detect the distance between the robot and plastic bottle using ultrasonic sensor
                 //determine the arrangement pattern of plastic bottles from the distance
                 //rotate right until sensor detects the distance or 2 second pass
                 .composite<BrainTree::MemSequence>()
                     .leaf<StopNow>()
-                    .composite<BrainTree::ParallelSequence>(1,2)
+                    .composite<BrainTree::ParallelWatch>()
                         .leaf<IsTimeEarned>(500000) //sonar 0.5 sec
                         .leaf<DetectSlalomPattern>()
                         .leaf<RunAsInstructed>(0, 35, 0.0)
@@ -1053,120 +1197,68 @@ void main_task(intptr_t unused) {
             .end()
         .end()
     .build();
+}
 
-    tr_slalom_second_a = (BrainTree::BehaviorTree*) BrainTree::Builder()
-        .composite<BrainTree::MemSequence>()
-            .composite<BrainTree::ParallelSequence>(1,2) //後半第一スラローム開始
-                .leaf<IsDistanceEarned>(30)
-                .leaf<RunAsInstructed>(-40, 0, 0.0)
-            .end()
-            .composite<BrainTree::ParallelSequence>(1,2)
-                .leaf<IsDistanceEarned>(50)
-                .leaf<RunAsInstructed>(40, 40, 0.0)
-            .end()
-            .composite<BrainTree::ParallelSequence>(1,2)
-                .leaf<IsDistanceEarned>(20)
-                .leaf<RunAsInstructed>(-40, 0, 0.0)
-            .end()
-            .composite<BrainTree::ParallelSequence>(1,2)
-                .leaf<IsDistanceEarned>(50)
-                .leaf<RunAsInstructed>(40, 40, 0.0)
-            .end()
-            .composite<BrainTree::ParallelSequence>(1,2) //後半第二スラローム開始
-                .leaf<IsDistanceEarned>(200)
-                .leaf<RunAsInstructed>(50, 15, 0.0)
-            .end()
-        .end()
+BrainTree::Node* tr_slalom_second_a() {
+    return BrainTree::Builder()
+        .leaf<SlalomSecondA>()
     .build();
+}
 
-    tr_slalom_second_b = (BrainTree::BehaviorTree*) BrainTree::Builder()
-        .composite<BrainTree::MemSequence>()
-            .composite<BrainTree::ParallelSequence>(1,2) //後半第一スラローム開始
-                .leaf<IsDistanceEarned>(50)
-                .leaf<RunAsInstructed>(40, 40, 0.0)
-            .end()
-            .composite<BrainTree::ParallelSequence>(1,2)
-                .leaf<IsDistanceEarned>(110)    //param SJ:100
-                .leaf<RunAsInstructed>(20, 50, 0.0) //param SJ:20,50
-            .end()
-            .composite<BrainTree::ParallelSequence>(1,2) //後半第二スラローム開始
-                .leaf<IsDistanceEarned>(20)
-                .leaf<RunAsInstructed>(40, 40, 0.0)
-            .end()
-            .composite<BrainTree::ParallelSequence>(1,2) //カーブを分割すると綺麗になる
-                .leaf<IsDistanceEarned>(40)
-                .leaf<RunAsInstructed>(20, 50, 0.0)
-            .end()
-            .composite<BrainTree::ParallelSequence>(1,2)
-                .leaf<IsDistanceEarned>(250)
-                .leaf<RunAsInstructed>(40, 40, 0.0)
-            .end()
-            .composite<BrainTree::ParallelSequence>(1,2)
-                .leaf<IsDistanceEarned>(120)    //param IS:150
-                .leaf<RunAsInstructed>(50, 20, 0.0)
-            .end()
-            .composite<BrainTree::ParallelSequence>(1,2)
-                .leaf<IsDistanceEarned>(30)
-                .leaf<RunAsInstructed>(40, 40, 0.0)
-            .end()
-            .composite<BrainTree::ParallelSequence>(1,2)
-                .leaf<IsDistanceEarned>(100)    //param IS:150
-                .leaf<RunAsInstructed>(50, 20, 0.0)
-            .end()
-            .composite<BrainTree::ParallelSequence>(1,2)
-                .leaf<IsDistanceEarned>(100)
-                .leaf<RunAsInstructed>(40, 40, 0.0)
-            .end()
-        .end()
+BrainTree::Node* tr_slalom_second_b() {
+    return BrainTree::Builder()
+        .leaf<SlalomSecondB>()
     .build();
+}
 
-    tr_block_r = (BrainTree::BehaviorTree*) BrainTree::Builder()
+BrainTree::Node* tr_block_r() {
+    return BrainTree::Builder()
         .composite<BrainTree::MemSequence>()
-            .composite<BrainTree::ParallelSequence>(1,3)
-                .leaf<SetArmPosition>(10, 40) 
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(500000) 
+                .leaf<SetArmPosition>(10, 40) 
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
+                .leaf<IsColorDetected>(CL_BLUE) 
                 .leaf<TraceLine>(prof->getValueAsNum("G_LT1"),
                                  GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_NORMAL)  
-                .leaf<IsColorDetected>(CL_BLUE) 
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("G_TM1")) // 後ろ向き走行。狙いは黒線。
                 .leaf<RunAsInstructed>(prof->getValueAsNum("G_LM1"),
                                        prof->getValueAsNum("G_RM1"),
                                        0.0)      
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("G_TM2")) // 後ろ向き走行。狙いは黒線。
                 .leaf<RunAsInstructed>(prof->getValueAsNum("G_LM2"),
                                        prof->getValueAsNum("G_RM2"),
                                        0.0)      
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("G_TM3")) // 後ろ向き走行。狙いは黒線。
+                .leaf<IsColorDetected>(CL_BLACK)  
                 .leaf<RunAsInstructed>(prof->getValueAsNum("G_LM3"),
                                        prof->getValueAsNum("G_RM3"),
                                        0.0)        
-                .leaf<IsColorDetected>(CL_BLACK)  
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("G_TM4")) // 黒線検知後、ライントレース準備
                 .leaf<RunAsInstructed>(prof->getValueAsNum("G_LM4"),
                                        prof->getValueAsNum("G_RM4"),
                                        0.0)     
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
+                .leaf<IsTimeEarned>(1000000) // 黒線検知後、ライントレース準備
                 .leaf<TraceLine>(prof->getValueAsNum("G_LT2"),
                                  GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_NORMAL)  
-                .leaf<IsTimeEarned>(1000000) // 黒線検知後、ライントレース準備
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
+                .leaf<IsColorDetected>(CL_GRAY) //グレー検知までライントレース 
                 .leaf<TraceLine>(prof->getValueAsNum("G_LT1"), 
                                  GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_NORMAL)  
-                .leaf<IsColorDetected>(CL_GRAY) //グレー検知までライントレース 
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .composite<BrainTree::MemSequence>()
                     .leaf<IsColorDetected>(CL_GRAY) //グレー検知までライントレース   
                     .leaf<IsColorDetected>(CL_WHITE) //グレー検知までライントレース    
@@ -1176,55 +1268,55 @@ void main_task(intptr_t unused) {
                 .leaf<RunAsInstructed>(prof->getValueAsNum("G_LM5"),
                                        prof->getValueAsNum("G_RM5"),0.0)   //グレー検知後、丸穴あき部分があるため少し前進    
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("GR_TM1"))  // 本線ラインに戻ってくる
                 .leaf<RunAsInstructed>(prof->getValueAsNum("GR_LM1"),
                                        prof->getValueAsNum("GR_RM1"),0.0)          
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("GR_TM2"))  // 本線ラインに戻ってくる
                 .leaf<RunAsInstructed>(prof->getValueAsNum("GR_LM2"),
                                        prof->getValueAsNum("GR_RM2"),0.0)     
             .end()
-             .composite<BrainTree::ParallelSequence>(1,3)
+             .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(5000000) // 本線ラインに戻ってくる。黒ラインか青ライン検知
-                .leaf<RunAsInstructed>(prof->getValueAsNum("GR_LM2"),
-                                       prof->getValueAsNum("GR_RM2"),0.0)     
                 .leaf<IsColorDetected>(CL_BLACK)  
                 .leaf<IsColorDetected>(CL_BLUE2)     
+                .leaf<RunAsInstructed>(prof->getValueAsNum("GR_LM2"),
+                                       prof->getValueAsNum("GR_RM2"),0.0)     
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("GR_TM3")) // 検知後、斜め右前まで回転(ブロックを離さないように)
                 .leaf<RunAsInstructed>(prof->getValueAsNum("GR_LM3"),
                                        prof->getValueAsNum("GR_RM3"),0.0)     
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("GR_TM4")) 
                 .leaf<TraceLine>(prof->getValueAsNum("G_LT2"),
                                  GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_NORMAL)  
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsColorDetected>(CL_WHITE)  
                 .leaf<TraceLine>(prof->getValueAsNum("G_LT2"),
                                  GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_NORMAL)  
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("GR_TM5")) // 全身しながら大きく左に向けて旋回。黄色を目指す。
                 .leaf<RunAsInstructed>(prof->getValueAsNum("GR_LM5"),
                                        prof->getValueAsNum("GR_RM5"),0.0)       
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsColorDetected>(CL_YELLOW)    // 黄色検知後、方向立て直す。
                 .leaf<RunAsInstructed>(prof->getValueAsNum("GR_LM6"),
                                        prof->getValueAsNum("GR_RM6"),0.0)    
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)   
+            .composite<BrainTree::ParallelWatch>()   
                 .leaf<IsTimeEarned>(prof->getValueAsNum("GR_TM7")) 
+                .leaf<IsColorDetected>(CL_RED)   
                 .leaf<RunAsInstructed>(prof->getValueAsNum("GR_LM7"),
                                        prof->getValueAsNum("GR_RM7"),0.0) 
-                .leaf<IsColorDetected>(CL_RED)   
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3) 
+            .composite<BrainTree::ParallelWatch>() 
                 .leaf<IsColorDetected>(CL_RED)  //赤検知までまっすぐ進む。
                 .leaf<RunAsInstructed>(prof->getValueAsNum("GR_LM8"),
                                        prof->getValueAsNum("GR_RM8"),0.0)      
@@ -1233,54 +1325,56 @@ void main_task(intptr_t unused) {
             .leaf<IsTimeEarned>(30000000) // wait 3 seconds
         .end()
         .build();
+}
 
-    tr_block_g = (BrainTree::BehaviorTree*) BrainTree::Builder()
+BrainTree::Node* tr_block_g() {
+    return BrainTree::Builder()
         .composite<BrainTree::MemSequence>()
-            .composite<BrainTree::ParallelSequence>(1,3)
-                .leaf<SetArmPosition>(10, 40) 
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(500000) 
+                .leaf<SetArmPosition>(10, 40) 
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
+                .leaf<IsColorDetected>(CL_BLUE) 
                 .leaf<TraceLine>(prof->getValueAsNum("G_LT1"),
                                  GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_NORMAL)  
-                .leaf<IsColorDetected>(CL_BLUE) 
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("G_TM1")) // 後ろ向き走行。狙いは黒線。
                 .leaf<RunAsInstructed>(prof->getValueAsNum("G_LM1"),
                                        prof->getValueAsNum("G_RM1"),
                                        0.0)      
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("G_TM2")) // 後ろ向き走行。狙いは黒線。
                 .leaf<RunAsInstructed>(prof->getValueAsNum("G_LM2"),
                                        prof->getValueAsNum("G_RM2"),
                                        0.0)      
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("G_TM3")) // 後ろ向き走行。狙いは黒線。
+                .leaf<IsColorDetected>(CL_BLACK)  
                 .leaf<RunAsInstructed>(prof->getValueAsNum("G_LM3"),
                                        prof->getValueAsNum("G_RM3"),
                                        0.0)        
-                .leaf<IsColorDetected>(CL_BLACK)  
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("G_TM4")) // 黒線検知後、ライントレース準備
                 .leaf<RunAsInstructed>(prof->getValueAsNum("G_LM4"),
                                        prof->getValueAsNum("G_RM4"),
                                        0.0)     
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
+                .leaf<IsTimeEarned>(1000000) // 黒線検知後、ライントレース準備
                 .leaf<TraceLine>(prof->getValueAsNum("G_LT2"),
                                  GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_NORMAL)  
-                .leaf<IsTimeEarned>(1000000) // 黒線検知後、ライントレース準備
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
+                .leaf<IsColorDetected>(CL_GRAY) //グレー検知までライントレース 
                 .leaf<TraceLine>(prof->getValueAsNum("G_LT1"), 
                                  GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_NORMAL)  
-                .leaf<IsColorDetected>(CL_GRAY) //グレー検知までライントレース 
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .composite<BrainTree::MemSequence>()
                     .leaf<IsColorDetected>(CL_GRAY) //グレー検知までライントレース   
                     .leaf<IsColorDetected>(CL_WHITE) //グレー検知までライントレース    
@@ -1290,102 +1384,104 @@ void main_task(intptr_t unused) {
                 .leaf<RunAsInstructed>(prof->getValueAsNum("G_LM5"),
                                        prof->getValueAsNum("G_RM5"),0.0)   //グレー検知後、丸穴あき部分があるため少し前進    
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("GO_TM1")) // break after 10 seconds
                 .leaf<RunAsInstructed>(prof->getValueAsNum("GO_LM1"),
                                        prof->getValueAsNum("GO_RM1"),0.0) //左に旋回。ライントレース準備。
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("GO_TM2")) //少し前進。ライントレース準備。
+                 .leaf<IsColorDetected>(CL_BLACK)
                 .leaf<RunAsInstructed>(prof->getValueAsNum("GO_LM2"),
                                        prof->getValueAsNum("GO_RM2"),0.0)     
-                 .leaf<IsColorDetected>(CL_BLACK)
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(5000000)
+                .leaf<IsColorDetected>(CL_BLUE2)  //純粋な青検知までライントレース
                 .leaf<TraceLine>(prof->getValueAsNum("G_LT1"), 
                                  GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_OPPOSITE)  
-                .leaf<IsColorDetected>(CL_BLUE2)  //純粋な青検知までライントレース
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("GO_TM3")) // break after 10 seconds
                 .leaf<RunAsInstructed>(prof->getValueAsNum("GO_LM3"),
                                        prof->getValueAsNum("GO_RM3"),0.0)   //青検知後は大きく右に旋回    
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("GO_TM4")) // break after 10 seconds
                 .leaf<RunAsInstructed>(prof->getValueAsNum("GO_LM4"),
                                        prof->getValueAsNum("GO_RM4"),0.0)    //前進。次の青検知を目指す。
             .end() 
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(5000000)
+                .leaf<IsColorDetected>(CL_BLUE2)  //前進。次の青検知を目指す。
                 .leaf<RunAsInstructed>(prof->getValueAsNum("GO_LM5"),
                                        prof->getValueAsNum("GO_RM5"),0.0)   
-                .leaf<IsColorDetected>(CL_BLUE2)  //前進。次の青検知を目指す。
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("GO_TM6")) //青検知後、大きく右旋回。向きを整える。
                 .leaf<RunAsInstructed>(prof->getValueAsNum("GO_LM6"),
                                        prof->getValueAsNum("GO_RM6"),0.0)         
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsColorDetected>(CL_WHITE)  
                 .leaf<TraceLine>(prof->getValueAsNum("G_LT2"), 
                                  GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_OPPOSITE)  
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("GO_TM7"))
                 .leaf<RunAsInstructed>(prof->getValueAsNum("GO_LM7"),
                                        prof->getValueAsNum("GO_RM7"),0.0)  //目的の色検知まで前進
             .end() 
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(5000000)
+                .leaf<IsColorDetected>(CL_GREEN)  
                 .leaf<RunAsInstructed>(prof->getValueAsNum("GO_LM7"),
                                        prof->getValueAsNum("GO_RM7"),0.0) 
-                .leaf<IsColorDetected>(CL_GREEN)  
             .end()
             .leaf<StopNow>()
             .leaf<IsTimeEarned>(30000000) // wait 3 seconds
             .leaf<SetArmPosition>(10, 40)
         .end()
         .build();
+}
 
-    tr_block_b = (BrainTree::BehaviorTree*) BrainTree::Builder()
+BrainTree::Node* tr_block_b() {
+    return BrainTree::Builder()
         .composite<BrainTree::MemSequence>()
-            .composite<BrainTree::ParallelSequence>(1,3)
-                .leaf<SetArmPosition>(10, 40) 
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(500000) 
+                .leaf<SetArmPosition>(10, 40) 
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
-                .leaf<TraceLine>(40, GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_NORMAL)  
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsColorDetected>(CL_BLUE) 
+                .leaf<TraceLine>(40, GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_NORMAL)  
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(800000) // 後ろ向き走行。狙いは黒線。
                 .leaf<RunAsInstructed>(-30,-80,0.0)      
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(1700000) // 後ろ向き走行。狙いは黒線。
                 .leaf<RunAsInstructed>(-50,-50,0.0)    
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(4000000) // 後ろ向き走行。狙いは黒線。
-                .leaf<RunAsInstructed>(-35,-35,0.0)    
                 .leaf<IsColorDetected>(CL_BLACK)  
+                .leaf<RunAsInstructed>(-35,-35,0.0)    
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(900000) // 黒線検知後、ライントレース準備
                 .leaf<RunAsInstructed>(-30,60,0.0)      
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
-                .leaf<TraceLine>(35, GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_NORMAL)  
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(1000000) // 黒線検知後、ライントレース準備
+                .leaf<TraceLine>(35, GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_NORMAL)  
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
-                .leaf<TraceLine>(40, GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_NORMAL)  
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsColorDetected>(CL_GRAY) //グレー検知までライントレース 
+                .leaf<TraceLine>(40, GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_NORMAL)  
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .composite<BrainTree::MemSequence>()
                     .leaf<IsColorDetected>(CL_GRAY) //グレー検知までライントレース   
                     .leaf<IsColorDetected>(CL_WHITE) //グレー検知までライントレース    
@@ -1394,102 +1490,104 @@ void main_task(intptr_t unused) {
                 .leaf<IsTimeEarned>(1500000) // break after 10 seconds
                 .leaf<RunAsInstructed>(40,40,0.0)  //グレー検知後、丸穴あき部分があるため少し前進    
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsAngleSmaller>(-15)
                 .leaf<RunAsInstructed>(-50,50,0.0) //左に旋回。ライントレース準備。
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(1000000) //少し前進。ライントレース準備。
                 .leaf<RunAsInstructed>(40,42,0.0)      
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(5000000)
-                .leaf<TraceLine>(40, GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_OPPOSITE)  
                 .leaf<IsColorDetected>(CL_BLUE2)  //純粋な青検知までライントレース
+                .leaf<TraceLine>(40, GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_OPPOSITE)  
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsAngleLarger>(1)
                 .leaf<RunAsInstructed>(44,-44,0.0) //青検知後は大きく右に旋回    
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(1000000)
                 .leaf<RunAsInstructed>(35,55,0.0)   //前進。次の青検知を目指す。
             .end() 
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(5000000)
-                .leaf<RunAsInstructed>(40,40,0.0)   
                 .leaf<IsColorDetected>(CL_BLUE2)  //前進。次の青検知を目指す。
+                .leaf<RunAsInstructed>(40,40,0.0)   
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsAngleLarger>(75)
                 .leaf<RunAsInstructed>(55,-55,0.0)      
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsColorDetected>(CL_WHITE)  
                 .leaf<TraceLine>(34, GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_OPPOSITE)  
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(3000000)
                 .leaf<RunAsInstructed>(40,40,0.0)  //目的の色検知まで前進
             .end() 
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(5000000)
-                .leaf<RunAsInstructed>(40,40,0.0) 
                 .leaf<IsColorDetected>(CL_BLUE2)  
+                .leaf<RunAsInstructed>(40,40,0.0) 
             .end()
             .leaf<StopNow>()
             .leaf<IsTimeEarned>(30000000) // wait 3 seconds
             .leaf<SetArmPosition>(10, 40)
         .end()
     .build();
+}
 
-    tr_block_y = (BrainTree::BehaviorTree*) BrainTree::Builder()
+BrainTree::Node* tr_block_y() {
+    return BrainTree::Builder()
         .composite<BrainTree::MemSequence>()
-            .composite<BrainTree::ParallelSequence>(1,3)
-                .leaf<SetArmPosition>(10, 40) 
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(500000) 
+                .leaf<SetArmPosition>(10, 40) 
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
+                .leaf<IsColorDetected>(CL_BLUE) 
                 .leaf<TraceLine>(prof->getValueAsNum("G_LT1"),
                                  GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_NORMAL)  
-                .leaf<IsColorDetected>(CL_BLUE) 
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("G_TM1")) // 後ろ向き走行。狙いは黒線。
                 .leaf<RunAsInstructed>(prof->getValueAsNum("G_LM1"),
                                        prof->getValueAsNum("G_RM1"),
                                        0.0)      
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("G_TM2")) // 後ろ向き走行。狙いは黒線。
                 .leaf<RunAsInstructed>(prof->getValueAsNum("G_LM2"),
                                        prof->getValueAsNum("G_RM2"),
                                        0.0)      
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("G_TM3")) // 後ろ向き走行。狙いは黒線。
+                .leaf<IsColorDetected>(CL_BLACK)  
                 .leaf<RunAsInstructed>(prof->getValueAsNum("G_LM3"),
                                        prof->getValueAsNum("G_RM3"),
                                        0.0)        
-                .leaf<IsColorDetected>(CL_BLACK)  
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("G_TM4")) // 黒線検知後、ライントレース準備
                 .leaf<RunAsInstructed>(prof->getValueAsNum("G_LM4"),
                                        prof->getValueAsNum("G_RM4"),
                                        0.0)     
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
+                .leaf<IsTimeEarned>(1000000) // 黒線検知後、ライントレース準備
                 .leaf<TraceLine>(prof->getValueAsNum("G_LT2"),
                                  GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_NORMAL)  
-                .leaf<IsTimeEarned>(1000000) // 黒線検知後、ライントレース準備
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
+                .leaf<IsColorDetected>(CL_GRAY) //グレー検知までライントレース 
                 .leaf<TraceLine>(prof->getValueAsNum("G_LT1"), 
                                  GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_NORMAL)  
-                .leaf<IsColorDetected>(CL_GRAY) //グレー検知までライントレース 
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .composite<BrainTree::MemSequence>()
                     .leaf<IsColorDetected>(CL_GRAY) //グレー検知までライントレース   
                     .leaf<IsColorDetected>(CL_WHITE) //グレー検知までライントレース    
@@ -1499,104 +1597,367 @@ void main_task(intptr_t unused) {
                 .leaf<RunAsInstructed>(prof->getValueAsNum("G_LM5"),
                                        prof->getValueAsNum("G_RM5"),0.0)   //グレー検知後、丸穴あき部分があるため少し前進    
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("GO_TM1")) // break after 10 seconds
                 .leaf<RunAsInstructed>(prof->getValueAsNum("GO_LM1"),
                                        prof->getValueAsNum("GO_RM1"),0.0) //左に旋回。ライントレース準備。
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("GO_TM2")) //少し前進。ライントレース準備。
+                 .leaf<IsColorDetected>(CL_BLACK)
                 .leaf<RunAsInstructed>(prof->getValueAsNum("GO_LM2"),
                                        prof->getValueAsNum("GO_RM2"),0.0)     
-                 .leaf<IsColorDetected>(CL_BLACK)
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(5000000)
+                .leaf<IsColorDetected>(CL_BLUE2)  //純粋な青検知までライントレース
                 .leaf<TraceLine>(prof->getValueAsNum("G_LT1"), 
                                  GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_OPPOSITE)  
-                .leaf<IsColorDetected>(CL_BLUE2)  //純粋な青検知までライントレース
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("GO_TM3")) // break after 10 seconds
                 .leaf<RunAsInstructed>(prof->getValueAsNum("GO_LM3"),
                                        prof->getValueAsNum("GO_RM3"),0.0)   //青検知後は大きく右に旋回    
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("GO_TM4")) // break after 10 seconds
                 .leaf<RunAsInstructed>(prof->getValueAsNum("GO_LM4"),
                                        prof->getValueAsNum("GO_RM4"),0.0)    //前進。次の青検知を目指す。
             .end() 
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(5000000)
+                .leaf<IsColorDetected>(CL_BLUE2)  //前進。次の青検知を目指す。
                 .leaf<RunAsInstructed>(prof->getValueAsNum("GO_LM5"),
                                        prof->getValueAsNum("GO_RM5"),0.0)   
-                .leaf<IsColorDetected>(CL_BLUE2)  //前進。次の青検知を目指す。
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("GO_TM6")) //青検知後、大きく右旋回。向きを整える。
                 .leaf<RunAsInstructed>(prof->getValueAsNum("GO_LM6"),
                                        prof->getValueAsNum("GO_RM6"),0.0)         
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsColorDetected>(CL_WHITE)  
                 .leaf<TraceLine>(prof->getValueAsNum("G_LT2"), 
                                  GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_OPPOSITE)  
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(prof->getValueAsNum("GO_TM7"))
                 .leaf<RunAsInstructed>(prof->getValueAsNum("GO_LM7"),
                                        prof->getValueAsNum("GO_RM7"),0.0)  //目的の色検知まで前進
             .end() 
-            .composite<BrainTree::ParallelSequence>(1,3)
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(5000000)
+                .leaf<IsColorDetected>(CL_YELLOW)  
                 .leaf<RunAsInstructed>(prof->getValueAsNum("GO_LM7"),
                                        prof->getValueAsNum("GO_RM7"),0.0) 
-                .leaf<IsColorDetected>(CL_YELLOW)  
             .end()
             .leaf<StopNow>()
             .leaf<IsTimeEarned>(30000000) // wait 3 seconds
             .leaf<SetArmPosition>(10, 40)
         .end()
         .build();
+}
 
-    // テストでの値取得用
-    tr_block_d = (BrainTree::BehaviorTree*) BrainTree::Builder()
+// テストでの値取得用
+BrainTree::Node* tr_block_d() {
+    return BrainTree::Builder()
         .composite<BrainTree::MemSequence>()
-            .composite<BrainTree::ParallelSequence>(1,3)
-                .leaf<SetArmPosition>(10, 40) 
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(500000) 
+                .leaf<SetArmPosition>(10, 40) 
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
-                .leaf<TraceLine>(40, GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_NORMAL)  
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(1000000)
+                .leaf<TraceLine>(40, GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_NORMAL)  
             .end()
             .leaf<StopNow>()
             .leaf<IsTimeEarned>(30000000) // wait 3 seconds
         .end()
     .build();
+}
 
-    tr_block_d2 = (BrainTree::BehaviorTree*) BrainTree::Builder()
+BrainTree::Node* tr_block_d2() {
+    return BrainTree::Builder()
         .composite<BrainTree::MemSequence>()
-            .composite<BrainTree::ParallelSequence>(1,3)
-                .leaf<SetArmPosition>(10, 40) 
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(500000) 
+                .leaf<SetArmPosition>(10, 40) 
             .end()
-            .composite<BrainTree::ParallelSequence>(1,3)
-                .leaf<TraceLine>(0, GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_NORMAL)  
+            .composite<BrainTree::ParallelWatch>()
                 .leaf<IsTimeEarned>(10000000) 
+                .leaf<TraceLine>(0, GS_TARGET, P_CONST, I_CONST, D_CONST, 0.0, TS_NORMAL)  
             .end()
             .leaf<StopNow>()
             .leaf<IsTimeEarned>(30000000) // wait 3 seconds
         .end()
     .build();
+}
 
-
-    } /* if (prof->getValueAsStr("COURSE") == "R") */
+/* application terminates after main task gets waken up */
+BrainTree::Node* tr_ending() {
+    return BrainTree::Builder()
+        .leaf<WakeUpMain>()
+    .build();
+}
 
 /*
     === BEHAVIOR TREE DEFINITION ENDS HERE ===
 */
 
+/* the state to enter after calibration, JUMP_CALIBRATION = 1... is for testing only */
+State stateAfterCalibration() {
+    switch (JUMP_CALIBRATION) {
+        case 1:  return ST_SLALOM_FIRST;
+        case 2:  return ST_SLALOM_CHECK;
+        case 3:  return ST_SLALOM_SECOND_A;
+        case 4:  return ST_SLALOM_SECOND_B;
+        case 5:  return ST_BLOCK_R;
+        case 6:  return ST_BLOCK_G;
+        case 7:  return ST_BLOCK_B;
+        case 8:  return ST_BLOCK_Y;
+        case 9:  return ST_BLOCK_D;
+        case 10: return ST_BLOCK_D2;
+        default: return ST_RUN;
+    }
+}
+
+/* the state to enter after slalom, JUMP_BLOCK = 1... is for testing only */
+State stateAfterSlalom() {
+    switch (JUMP_BLOCK) {
+        case 1:  return ST_BLOCK_R;
+        case 2:  return ST_BLOCK_G;
+        case 3:  return ST_BLOCK_B;
+        case 4:  return ST_BLOCK_Y;
+        case 5:  return ST_ENDING;
+        default: return ST_BLOCK_D;
+    }
+}
+
+/* guards to choose the slalom pattern determined by DetectSlalomPattern */
+bool isSlalomPatternA() {
+    if (!DetectSlalomPattern::isSlalomPatternA) {
+        return false;
+    }
+    if (JUMP_SLALOM == true) {
+        _log("test only ST_SLALOM_CHECK.");
+    }
+    if (DetectSlalomPattern::earnedDistance == 0) {
+        _log("Failed to check slalom pattern.");
+    }
+    _log("Distance %d is detected by sonar and chose pattern A.", DetectSlalomPattern::earnedDistance);
+    return true;
+}
+
+bool isSlalomPatternB() {
+    if (DetectSlalomPattern::isSlalomPatternA) {
+        return false;
+    }
+    if (JUMP_SLALOM == true) {
+        _log("test only ST_SLALOM_CHECK.");
+    }
+    _log("Distance %d is detected by sonar and chose pattern B.", DetectSlalomPattern::earnedDistance);
+    return true;
+}
+
+/* listener to log state transitions of the state machine */
+void logTransition(const char* from, const char* to) {
+    _log("State changed: %s to %s", from, to);
+#if defined(MAKE_HOST)
+    ev3host_notifyPhase(from, to);
+#endif
+}
+
+
+/* a cyclic handler to activate a task */
+void task_activator(intptr_t tskid) {
+    ER ercd = act_tsk(tskid);
+    assert(ercd == E_OK || ercd == E_QOVR);
+    if (ercd == E_QOVR && tskid == UPD_TSK) {
+        upd_qovr_count++;
+    } else if (ercd != E_OK) {
+        syslog(LOG_NOTICE, "act_tsk() returned %d", ercd);
+    }
+}
+
+/* The main task */
+void main_task(intptr_t unused) {
+    // temp fix 2022/6/20 W.Taniguchi, as Bluetooth not implemented yet
+    //bt = ev3_serial_open_file(EV3_SERIAL_BT);
+    //assert(bt != NULL);
+    /* create and initialize EV3 objects */
+    ev3clock    = new Clock();
+    video       = new Video();
+    touchSensor = new TouchSensor(PORT_1);
+    // temp fix 2022/6/20 W.Taniguchi, new SonarSensor() blocks apparently
+    sonarSensor = new SonarSensor(PORT_3);
+    colorSensor = new FilteredColorSensor(PORT_2);
+    gyroSensor  = new GyroSensor(PORT_4);
+    leftMotor   = new FilteredMotor(PORT_C);
+    rightMotor  = new FilteredMotor(PORT_B);
+    armMotor    = new Motor(PORT_A);
+    plotter     = new Plotter_t(leftMotor, rightMotor, gyroSensor);
+    /* the budgets of the phases add up to 90% of the period */
+    watchdog    = new TickWatchdog(PERIOD_UPD_TSK);
+    watchdog->addPhase("sense", 1000);
+    watchdog->addPhase("plot",   500);
+    watchdog->addPhase("sonar", 2000);
+    watchdog->addPhase("log",   2000);
+    watchdog->addPhase("tree",  3000);
+    watchdog->addPhase("drive",  500);
+    watchdog->watchQueueOverflow(&upd_qovr_count);
+    /* read profile file and make the profile object ready */
+    prof        = new Profile("msad2022_pri/profile.txt");
+    /* determine the course L or R */
+    if (prof->getValueAsStr("COURSE") == "R") {
+      _COURSE = -1;
+    } else {
+      _COURSE = 1;
+    }
+ 
+    /* set low-pass filters for R, G and B to FilteredColorSensor by LPF_TYPE:
+        FIR for a bank of FIR of the fixed order, or BUTTERWORTH or BESSEL of LPF_ORDER
+        with the cut-off frequency LPF_CUTOFF at the sample rate LPF_RATE in Hz,
+        designed here for the shorter delay, see ev3host/tools/filtercmp to compare them;
+        FIR only in fixed point, as SOS is in double */
+    Filter *lpf_r = nullptr, *lpf_g = nullptr, *lpf_b = nullptr;
+    FilterBank *lpf_rgb = nullptr;
+    std::string lpfType = prof->getValueAsStr("LPF_TYPE");
+#if defined(FIXED_POINT)
+    if (lpfType == "BUTTERWORTH" || lpfType == "BESSEL") {
+        _log("LPF_TYPE=%s not available in fixed point, falling back to FIR", lpfType.c_str());
+    }
+#else
+    if (lpfType == "BUTTERWORTH" || lpfType == "BESSEL") {
+        SOS::Design design = (lpfType == "BESSEL") ? SOS::BESSEL : SOS::BUTTERWORTH;
+        int lpfOrder = (int)prof->getValueAsNum("LPF_ORDER");
+        double lpfCutoff = prof->getValueAsNum("LPF_CUTOFF");
+        double lpfRate = prof->getValueAsNum("LPF_RATE");
+        if (lpfRate == 0.0) lpfRate = 1000000.0 / PERIOD_UPD_TSK;
+        if (lpfOrder < 1 || lpfOrder > SOS::MAX_ORDER || lpfCutoff <= 0.0 || lpfCutoff >= lpfRate / 2.0) {
+            _log("invalid LPF_ORDER or LPF_CUTOFF, falling back to FIR");
+        } else {
+            lpf_r = new SOS(design, lpfOrder, lpfCutoff, lpfRate);
+            lpf_g = new SOS(design, lpfOrder, lpfCutoff, lpfRate);
+            lpf_b = new SOS(design, lpfOrder, lpfCutoff, lpfRate);
+            colorSensor->setRawColorFilters(lpf_r, lpf_g, lpf_b);
+        }
+    }
+#endif
+    if (lpf_r == nullptr) {
+#if defined(FIXED_POINT)
+        /* filtered in integers by applyFix() */
+        FIR_Q15<4, FIR_LowPass02> *fir_r = new FIR_Q15<4, FIR_LowPass02>;
+        FIR_Q15<4, FIR_LowPass02> *fir_g = new FIR_Q15<4, FIR_LowPass02>;
+        FIR_Q15<4, FIR_LowPass02> *fir_b = new FIR_Q15<4, FIR_LowPass02>;
+        colorSensor->setRawColorFiltersFix(fir_r, fir_g, fir_b);
+        lpf_r = fir_r;
+        lpf_g = fir_g;
+        lpf_b = fir_b;
+#else
+        lpf_rgb = new FIRBank<4, FIR_LowPass02>;
+        colorSensor->setRawColorFilterBank(lpf_rgb);
+#endif
+    }
+
+    gyroSensor->reset();
+    leftMotor->reset();
+    srlfL = new SRLF_t(0.0);
+    rightMotor->reset();
+    srlfR = new SRLF_t(0.0);
+#if defined(FIXED_POINT)
+    /* filtered in integers by applyFix() */
+    leftMotor->setPWMFilterFix(srlfL);
+    rightMotor->setPWMFilterFix(srlfR);
+#else
+    leftMotor->setPWMFilter(srlfL);
+    rightMotor->setPWMFilter(srlfR);
+#endif
+    leftMotor->setPWM(0);
+    rightMotor->setPWM(0);
+    armMotor->reset();
+
+    /* set the gain schedule of TraceLine by SCHED_SPEED and SCHED_CURV in 1/m in the ascending order,
+        and SCHED_P, SCHED_I and SCHED_D of the gains row by row of a speed, none for the constants per leaf */
+#if !defined(FIXED_POINT)
+    std::vector<double> schedSpeeds = prof->getValueAsNums("SCHED_SPEED");
+    if (!schedSpeeds.empty()) {
+        gainSchedule = new GainSchedule(schedSpeeds, prof->getValueAsNums("SCHED_CURV"),
+            prof->getValueAsNums("SCHED_P"), prof->getValueAsNums("SCHED_I"), prof->getValueAsNums("SCHED_D"));
+        if (!gainSchedule->isValid()) {
+            _log("invalid SCHED_CURV or SCHED_P/I/D, falling back to the constants per leaf");
+            delete gainSchedule;
+            gainSchedule = nullptr;
+        } else {
+            schedPid = new PIDController(0.0, 0.0, 0.0, PERIOD_UPD_TSK, 0, 0);
+            schedPid->setDerivativeFilter(prof->getValueAsNum("PID_TF"));
+            curvature = new CurvatureEstimator();
+        }
+    }
+#endif
+
+/*
+    === STATE MACHINE DEFINITION STARTS HERE ===
+    The upper layer of HFSM is declared as a transition table where each state hosts its behavior tree.
+    A tree gets built on entering its state and destroyed on leaving it.
+    A transition is taken and the tree of the new state gets its first tick within the same period.
+    The first matching entry in the table wins.
+*/
+    typedef BrainTree::Node::Status Status;
+    const int ANY = BrainTree::StateMachine::AnyState;
+
+    const BrainTree::StateMachine::Transition transitions_l[] = {
+        /* from                 on               to                                           guard */
+        { ST_CALIBRATION,       Status::Success, stateAfterCalibration(),                     nullptr },
+        { ST_RUN,               Status::Success, ST_SLALOM_FIRST,                             nullptr },
+        { ST_SLALOM_FIRST,      Status::Success, ST_SLALOM_CHECK,                             nullptr },
+        { ST_SLALOM_CHECK,      Status::Success, JUMP_SLALOM ? ST_ENDING : ST_SLALOM_SECOND_A, isSlalomPatternA },
+        { ST_SLALOM_CHECK,      Status::Success, JUMP_SLALOM ? ST_ENDING : ST_SLALOM_SECOND_B, isSlalomPatternB },
+        { ST_SLALOM_SECOND_A,   Status::Success, stateAfterSlalom(),                          nullptr },
+        { ST_SLALOM_SECOND_B,   Status::Success, stateAfterSlalom(),                          nullptr },
+        { ST_BLOCK_R,           Status::Success, ST_ENDING,                                   nullptr },
+        { ST_BLOCK_G,           Status::Success, ST_ENDING,                                   nullptr },
+        { ST_BLOCK_B,           Status::Success, ST_ENDING,                                   nullptr },
+        { ST_BLOCK_Y,           Status::Success, ST_ENDING,                                   nullptr },
+        { ST_BLOCK_D,           Status::Success, ST_ENDING,                                   nullptr },
+        { ST_BLOCK_D2,          Status::Success, ST_ENDING,                                   nullptr },
+        { ST_ENDING,            Status::Success, ST_END,                                      nullptr },
+        { ANY,                  Status::Failure, ST_ENDING,                                   nullptr },
+    };
+
+    const BrainTree::StateMachine::Transition transitions_r[] = {
+        /* from                 on               to                                           guard */
+        { ST_CALIBRATION,       Status::Success, ST_RUN,                                      nullptr },
+        { ST_RUN,               Status::Success, ST_ENDING,                                   nullptr },
+        { ST_ENDING,            Status::Success, ST_END,                                      nullptr },
+        { ANY,                  Status::Failure, ST_ENDING,                                   nullptr },
+    };
+
+    BrainTree::StateMachine* sm = new BrainTree::StateMachine(ST_CALIBRATION);
+    sm->addState(ST_CALIBRATION,     STR(ST_CALIBRATION),     tr_calibration);
+    sm->addState(ST_RUN,             STR(ST_RUN),             tr_run);
+    sm->addState(ST_SLALOM_FIRST,    STR(ST_SLALOM_FIRST),    tr_slalom_first);
+    sm->addState(ST_SLALOM_CHECK,    STR(ST_SLALOM_CHECK),    tr_slalom_check);
+    sm->addState(ST_SLALOM_SECOND_A, STR(ST_SLALOM_SECOND_A), tr_slalom_second_a);
+    sm->addState(ST_SLALOM_SECOND_B, STR(ST_SLALOM_SECOND_B), tr_slalom_second_b);
+    sm->addState(ST_BLOCK_R,         STR(ST_BLOCK_R),         tr_block_r);
+    sm->addState(ST_BLOCK_G,         STR(ST_BLOCK_G),         tr_block_g);
+    sm->addState(ST_BLOCK_B,         STR(ST_BLOCK_B),         tr_block_b);
+    sm->addState(ST_BLOCK_Y,         STR(ST_BLOCK_Y),         tr_block_y);
+    sm->addState(ST_BLOCK_D,         STR(ST_BLOCK_D),         tr_block_d);
+    sm->addState(ST_BLOCK_D2,        STR(ST_BLOCK_D2),        tr_block_d2);
+    sm->addState(ST_ENDING,          STR(ST_ENDING),          tr_ending);
+    sm->addState(ST_END,             STR(ST_END),             nullptr); /* final state */
+    if (_COURSE == -1) {
+        sm->setTransitions(transitions_r);
+    } else {
+        sm->setTransitions(transitions_l);
+    }
+    sm->setListener(logTransition);
+
+/*
+    === STATE MACHINE DEFINITION ENDS HERE ===
+*/
+
     /* register cyclic handler to EV3RT */
     sta_cyc(CYC_VIDEO_TSK);
     sta_cyc(CYC_UPD_TSK);
@@ -1604,7 +1965,7 @@ void main_task(intptr_t unused) {
     /* indicate initialization completion by LED color */
     _log("initialization completed.");
     ev3_led_set_color(LED_ORANGE);
-    state = ST_CALIBRATION;
+    stateMachine = sm;
 
     /* the main task sleep until being waken up and let the registered cyclic handler to traverse the behavir trees */
     _log("going to sleep...");
@@ -1620,25 +1981,22 @@ void main_task(intptr_t unused) {
     _log("wait for update task to cease, going to sleep 3 secs");
     ev3clock->sleep(3000000);
     _log("wait finished");
+    watchdog->report();
 
-    /* destroy behavior tree */
-    delete tr_block_r;
-    delete tr_block_g;
-    delete tr_block_b;
-    delete tr_block_y;
-    delete tr_block_d;
-    delete tr_run;
-    delete tr_slalom_first;
-    delete tr_slalom_check;
-    delete tr_slalom_second_a;
-    delete tr_slalom_second_b;
-    delete tr_calibration;
+    /* destroy state machine together with behavior trees hosted by it */
+    stateMachine = nullptr;
+    delete sm;
     /* destroy profile object */
     delete prof;
     /* destroy EV3 objects */
+    delete curvature;
+    delete schedPid;
+    delete gainSchedule;
+    delete lpf_rgb;
     delete lpf_b;
     delete lpf_g;
     delete lpf_r;
+    delete watchdog;
     delete plotter;
     delete armMotor;
     delete rightMotor;
@@ -1660,7 +2018,6 @@ void main_task(intptr_t unused) {
 
 /* periodic task to handle video */
 void video_task(intptr_t unused) {
-    ER ercd;
     video->capture();
     video->writeFrame(video->readFrame());    
     video->show();
@@ -1668,12 +2025,12 @@ void video_task(intptr_t unused) {
     
 /* periodic task to update the behavior tree */
 void update_task(intptr_t unused) {
-    BrainTree::Node::Status status;
-    ER ercd;
-
+    watchdog->begin();
     colorSensor->sense();
-    rgb_raw_t cur_rgb;
+    rgb_raw_t cur_rgb, raw_rgb;
     colorSensor->getRawColor(cur_rgb);
+    colorSensor->getUnfilteredColor(raw_rgb);
+    watchdog->mark(PH_SENSE);
 
     // for test
     plotter->plot();
@@ -1685,348 +2042,32 @@ void update_task(intptr_t unused) {
     int32_t locY = plotter->getLocY();
     int32_t ang = plotter->getAngL();
     int32_t angR = plotter->getAngR();
+    int16_t gyroAngle = gyroSensor->getAngle();
+    watchdog->mark(PH_PLOT);
 
     int32_t sonarDistance = sonarSensor->getDistance();
+    watchdog->mark(PH_SONAR);
 
-    _log("r=%d g=%d b=%d",cur_rgb.r,cur_rgb.g,cur_rgb.b);
+    /* the raw values of the sensors are logged as well so that the run can be replayed on the host */
+    _log("r=%d g=%d b=%d rawR=%d rawG=%d rawB=%d",cur_rgb.r,cur_rgb.g,cur_rgb.b,raw_rgb.r,raw_rgb.g,raw_rgb.b);
 
     _log("dist=%d azi=%d deg=%d locX=%d locY=%d ang=%d angR=%d",distance,azimuth,degree,locX,locY,ang,angR);
-    _log("sonar=%d",sonarDistance);
+    _log("sonar=%d gyro=%d",sonarDistance,gyroAngle);
+    watchdog->mark(PH_LOG);
     
 /*
-    === STATE MACHINE DEFINITION STARTS HERE ===
     The robot behavior is defined using HFSM (Hierarchical Finite State Machine) with two hierarchies as a whole where:
-    - The upper layer is implemented as a state machine here.
+    - The upper layer is implemented as a state machine composite defined in main_task().
     - The lower layer is implemented using Behavior Tree where each tree gets traversed within each corresponding state of the state machine.
 */
-    switch (state) {
-    case ST_CALIBRATION:
-        if (tr_calibration != nullptr) {
-            status = tr_calibration->update();
-            switch (status) {
-            case BrainTree::Node::Status::Success:
-                switch (JUMP_CALIBRATION) { /* JUMP_CALIBRATION = 1... is for testing only */
-                    case 1:
-                        state = ST_SLALOM_FIRST;
-                        _log("State changed: ST_CALIBRATION to ST_SLALOM_FIRST");
-                        break;
-                    case 2:
-                        state = ST_SLALOM_CHECK;
-                        _log("State changed: ST_CALIBRATION to ST_SLALOM_CHECK");
-                        break;
-                    case 3:
-                        state = ST_SLALOM_SECOND_A;
-                        _log("State changed: ST_CALIBRATION to ST_SLALOM_SECOND_A");
-                        break;
-                    case 4:
-                        state = ST_SLALOM_SECOND_B;
-                        _log("State changed: ST_CALIBRATION to ST_SLALOM_SECOND_B");
-                        break;
-                    case 5:
-                        state = ST_BLOCK_R;
-                        _log("State changed: ST_CALIBRATION to ST_BLOCK_R");
-                        break;
-                    case 6:
-                        state = ST_BLOCK_G;
-                        _log("State changed: ST_CALIBRATION to ST_BLOCK_G");
-                        break;
-                    case 7:
-                        state = ST_BLOCK_B;
-                        _log("State changed: ST_CALIBRATION to ST_BLOCK_B");
-                        break;
-                    case 8:
-                        state = ST_BLOCK_Y;
-                        _log("State changed: ST_CALIBRATION to ST_BLOCK_Y");
-                        break;
-                    case 9:
-                        state = ST_BLOCK_D;
-                        _log("State changed: ST_CALIBRATION to ST_BLOCK_D");
-                        break;
-                    case 10:
-                        state = ST_BLOCK_D2;
-                        _log("State changed: ST_CALIBRATION to ST_BLOCK_D");
-                        break;
-                    default:
-                        state = ST_RUN;
-                        _log("State changed: ST_CALIBRATION to ST_RUN");
-                        break;
-                }
-                break;
-            case BrainTree::Node::Status::Failure:
-                state = ST_ENDING;
-                _log("State changed: ST_CALIBRATION to ST_ENDING");
-                break;
-            default:
-                break;
-            }
-        }
-        break;
-    case ST_RUN:
-        if (tr_run != nullptr) {
-            status = tr_run->update();
-            switch (status) {
-            case BrainTree::Node::Status::Success:
-                state = ST_SLALOM_FIRST;
-                _log("State changed: ST_RUN to ST_SLALOM_FIRST");
-                break;
-            case BrainTree::Node::Status::Failure:
-                state = ST_ENDING;
-                _log("State changed: ST_RUN to ST_ENDING");
-                break;
-            default:
-                break;
-            }
-        }
-        break;
-    case ST_SLALOM_FIRST:
-        if (tr_slalom_first != nullptr) {
-            status = tr_slalom_first->update();
-            switch (status) {
-            case BrainTree::Node::Status::Success:
-                state = ST_SLALOM_CHECK;
-                _log("State changed: ST_SLALOM_FIRST to ST_SLALOM_CHECK");
-                break;
-            case BrainTree::Node::Status::Failure:
-                state = ST_ENDING;
-                _log("State changed: ST_SLALOM_FIRST to ST_ENDING");
-                break;
-            default:
-                break;
-            }
-        }
-        break;
-    case ST_SLALOM_CHECK:
-        if (tr_slalom_check != nullptr) {
-            status = tr_slalom_check->update();
-            switch (status) {       
-            case BrainTree::Node::Status::Success:
-                if (DetectSlalomPattern::isSlalomPatternA == true) {
-                    // for test
-                    if (JUMP_SLALOM == true) {
-                        _log("test only ST_SLALOM_CHECK.");
-                        if (DetectSlalomPattern::earnedDistance == 0) {
-                            _log("Failed to check slalom pattern.");
-                        }
-                            state = ST_ENDING;
-                            _log("Distance %d is detected by sonar and chose pattern A.", DetectSlalomPattern::earnedDistance);
-                            _log("State changed: ST_SLALOM_CHECK to ST_ENDING");
-                    } else {
-                        if (DetectSlalomPattern::earnedDistance == 0) {
-                            _log("Failed to check slalom pattern.");
-                        }
-                        state = ST_SLALOM_SECOND_A;
-                        _log("Distance %d is detected by sonar and chose pattern A.", DetectSlalomPattern::earnedDistance);
-                        _log("State changed: ST_SLALOM_CHECK to ST_SLALOM_SECOND_A");
-                    }
-                } else {
-                    // for test
-                    if (JUMP_SLALOM == true) {
-                        _log("test only ST_SLALOM_CHECK.");
-                        state = ST_ENDING;
-                        _log("Distance %d is detected by sonar and chose pattern B.", DetectSlalomPattern::earnedDistance);
-                        _log("State changed: ST_SLALOM_CHECK to ST_ENDING");
-                    } else {
-                        state = ST_SLALOM_SECOND_B;
-                        _log("Distance %d is detected by sonar and chose pattern B.", DetectSlalomPattern::earnedDistance);
-                        _log("State changed: ST_SLALOM_CHECK to ST_SLALOM_SECOND_B");
-                    }
-                }
-                break;
-            case BrainTree::Node::Status::Failure:
-                state = ST_ENDING;
-                _log("State changed: ST_SLALOM_CHECK to ST_ENDING");
-                break;
-            default:
-                break;
-            }
-        }
-        break;
-    case ST_SLALOM_SECOND_A:
-        if (tr_slalom_second_a != nullptr) {
-            status = tr_slalom_second_a->update();
-            switch (status) {
-            case BrainTree::Node::Status::Success:
-                switch (JUMP_BLOCK) { /* JUMP_BLOCK = 1... is for testing only */
-                    case 1:
-                        state = ST_BLOCK_R;
-                        _log("State changed: ST_SLALOM_SECOND_A to ST_BLOCK_R");
-                        break;
-                    case 2:
-                        state = ST_BLOCK_G;
-                        _log("State changed: ST_SLALOM_SECOND_A to ST_BLOCK_G");
-                        break;
-                    case 3:
-                        state = ST_BLOCK_B;
-                        _log("State changed: ST_SLALOM_SECOND_A to ST_BLOCK_B");
-                        break;
-                    case 4:
-                        state = ST_BLOCK_Y;
-                        _log("State changed: ST_SLALOM_SECOND_A to ST_BLOCK_Y");
-                        break;
-                    case 5:
-                        state = ST_ENDING;
-                        _log("State changed: ST_SLALOM_SECOND_A to ST_ENDING");
-                        break;
-                    default:
-                        state = ST_BLOCK_D;
-                        _log("State changed: ST_SLALOM_SECOND_A to ST_BLOCK_D");
-                        break;
-                }
-                break;
-            case BrainTree::Node::Status::Failure:
-                state = ST_ENDING;
-                _log("State changed: ST_SLALOM_SECOND_A to ST_ENDING");
-                break;
-            default:
-                break;
-            }
-        }
-        break;
-    case ST_SLALOM_SECOND_B:
-        if (tr_slalom_second_b != nullptr) {
-            status = tr_slalom_second_b->update();
-            switch (status) {
-            case BrainTree::Node::Status::Success:
-                switch (JUMP_BLOCK) { /* JUMP_BLOCK = 1... is for testing only */
-                    case 1:
-                        state = ST_BLOCK_R;
-                        _log("State changed: ST_SLALOM_SECOND_B to ST_BLOCK_R");
-                        break;
-                    case 2:
-                        state = ST_BLOCK_G;
-                        _log("State changed: ST_SLALOM_SECOND_B to ST_BLOCK_G");
-                        break;
-                    case 3:
-                        state = ST_BLOCK_B;
-                        _log("State changed: ST_SLALOM_SECOND_B to ST_BLOCK_B");
-                        break;
-                    case 4:
-                        state = ST_BLOCK_Y;
-                        _log("State changed: ST_SLALOM_SECOND_B to ST_BLOCK_Y");
-                        break;
-                    case 5:
-                        state = ST_ENDING;
-                        _log("State changed: ST_SLALOM_SECOND_B to ST_ENDING");
-                        break;
-                    default:
-                        state = ST_BLOCK_D;
-                        _log("State changed: ST_SLALOM_SECOND_B to ST_BLOCK_D");
-                        break;
-                }
-                break;
-            case BrainTree::Node::Status::Failure:
-                state = ST_ENDING;
-                _log("State changed: ST_SLALOM_SECOND_B to ST_ENDING");
-                break;
-            default:
-                break;
-            }
-        }
-    case ST_BLOCK_R:
-        if (tr_block_r != nullptr) {
-            status = tr_block_r->update();
-            switch (status) {
-            case BrainTree::Node::Status::Success:
-            case BrainTree::Node::Status::Failure:
-                state = ST_ENDING;
-                _log("State changed: ST_BLOCK_R to ST_ENDING");
-                break;
-            default:
-                break;
-            }
-        }
-        break;
-    case ST_BLOCK_G:
-        if (tr_block_g != nullptr) {
-            status = tr_block_g->update();
-            switch (status) {
-            case BrainTree::Node::Status::Success:
-            case BrainTree::Node::Status::Failure:
-                state = ST_ENDING;
-                _log("State changed: ST_BLOCK_G to ST_ENDING");
-                break;
-            default:
-                break;
-            }
-        }
-        break;
-    case ST_BLOCK_B:
-        if (tr_block_b != nullptr) {
-            status = tr_block_b->update();
-            switch (status) {
-            case BrainTree::Node::Status::Success:
-            case BrainTree::Node::Status::Failure:
-                state = ST_ENDING;
-                _log("State changed: ST_BLOCK_B to ST_ENDING");
-                break;
-            default:
-                break;
-            }
-        }
-        break;
-    case ST_BLOCK_Y:
-        if (tr_block_y != nullptr) {
-            status = tr_block_y->update();
-            switch (status) {
-            case BrainTree::Node::Status::Success:
-            case BrainTree::Node::Status::Failure:
-                state = ST_ENDING;
-                _log("State changed: ST_BLOCK_Y to ST_ENDING");
-                break;
-            default:
-                break;
-            }
-        }
-        break;
-    case ST_BLOCK_D:
-        if (tr_block_d != nullptr) {
-            status = tr_block_d->update();
-            switch (status) {
-            case BrainTree::Node::Status::Success:
-            case BrainTree::Node::Status::Failure:
-                state = ST_ENDING;
-                _log("State changed: ST_BLOCK_D to ST_ENDING");
-                break;
-            default:
-                break;
-            }
-        }
-        break;
-    case ST_BLOCK_D2:
-        if (tr_block_d2 != nullptr) {
-            status = tr_block_d2->update();
-            switch (status) {
-            case BrainTree::Node::Status::Success:
-            case BrainTree::Node::Status::Failure:
-                state = ST_ENDING;
-                _log("State changed: ST_BLOCK_D to ST_ENDING");
-                break;
-            default:
-                break;
-            }
-        }
-        break;
-    case ST_ENDING:
-        _log("waking up main...");
-        /* wake up the main task */
-        ercd = wup_tsk(MAIN_TASK);
-        assert(ercd == E_OK);
-        if (ercd != E_OK) {
-            syslog(LOG_NOTICE, "wup_tsk() returned %d", ercd);
-        }
-        state = ST_END;
-        _log("State changed: ST_ENDING to ST_END");
-        break;    
-    case ST_INITIAL:    /* do nothing */
-    case ST_END:        /* do nothing */
-    default:            /* do nothing */
-        break;
+    if (stateMachine != nullptr) {
+        stateMachine->tick();
     }
-/*
-    === STATE MACHINE DEFINITION ENDS HERE ===
-*/
+    watchdog->mark(PH_TREE);
 
     rightMotor->drive();
     leftMotor->drive();
+    watchdog->mark(PH_DRIVE);
+    watchdog->end();
     //logger->outputLog(LOG_INTERVAL);
 }
\ No newline at end of file
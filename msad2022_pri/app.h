@@ -35,6 +35,7 @@ extern void main_task(intptr_t unused);
 extern void update_task(intptr_t unused);
 extern void video_task(intptr_t unused);
 extern void task_activator(intptr_t tskid);
+extern intptr_t upd_qovr_count;
 
 #endif /* TOPPERS_MACRO_ONLY */
 
@@ -26,10 +26,26 @@ using namespace ev3api;
 
 #include "FilteredMotor.hpp"
 #include "SRLF.hpp"
+#include "SCurve.hpp"
 #include "FilteredColorSensor.hpp"
 #include "FIR.hpp"
+#include "Biquad.hpp"
+#include "RollingMedian.hpp"
 #include "Plotter.hpp"
 #include "PIDcalculator.hpp"
+#include "PIDController.hpp"
+#include "GainSchedule.hpp"
+
+/* the control path in fixed point for the brick without FPU, by USER_COPTS=-DFIXED_POINT */
+#if defined(FIXED_POINT)
+typedef SRLF_Q15            SRLF_t;
+typedef PIDcalculator_Q15   PIDcalculator_t;
+typedef Plotter_Q31         Plotter_t;
+#else
+typedef SRLF                SRLF_t;
+typedef PIDController       PIDcalculator_t;
+typedef Plotter             Plotter_t;
+#endif
 
 /* global variables */
 extern FILE*        bt;
@@ -38,12 +54,12 @@ extern TouchSensor* touchSensor;
 extern SonarSensor* sonarSensor;
 extern FilteredColorSensor* colorSensor;
 extern GyroSensor*  gyroSensor;
-extern SRLF*        srlf_l;
+extern SRLF_t*      srlf_l;
 extern FilteredMotor*       leftMotor;
-extern SRLF*        srlf_r;
+extern SRLF_t*      srlf_r;
 extern FilteredMotor*       rightMotor;
 extern Motor*       armMotor;
-extern Plotter*     plotter;
+extern Plotter_t*   plotter;
 
 #define DEBUG
 
@@ -81,7 +97,8 @@ extern Plotter*     plotter;
     static const int _COURSE = 1;
   #endif /* defined(MAKE_RIGHT) */
 #else
-static int _COURSE = 1;
+/* set by main_task, unused by the other units including this header */
+static int _COURSE __attribute__((unused)) = 1;
 #endif
 
 /* these parameters are intended to be given as a compiler directive,